@@ -0,0 +1,333 @@
+#include "Autorouter.h"
+#include <tuple>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+const int kGrid = ObstacleMap::GridSize;
+const int kDx[4] = { 1, -1, 0, 0 };
+const int kDy[4] = { 0, 0, 1, -1 };
+inline int ChannelOf(int dir) { return dir < 2 ? 0 : 1; }   // 0 水平，1 竖直
+
+// 全局拥塞网格：每格两个通道，记录占用的线网数与历史代价
+class CongestionGrid
+{
+public:
+    void Init(int gx0, int gx1, int gy0, int gy1)
+    {
+        m_gx0 = gx0; m_gy0 = gy0;
+        m_w = std::max(1, gx1 - gx0 + 1);
+        m_h = std::max(1, gy1 - gy0 + 1);
+        size_t n = (size_t)m_w * m_h * 2;
+        m_occ.assign(n, 0);
+        m_hist.assign(n, 0.0f);
+        m_owner.assign(n, 0);
+    }
+
+    int MinX() const { return m_gx0; }
+    int MinY() const { return m_gy0; }
+    int MaxX() const { return m_gx0 + m_w - 1; }
+    int MaxY() const { return m_gy0 + m_h - 1; }
+    bool InRange(int gx, int gy) const { return gx >= m_gx0 && gx <= MaxX() && gy >= m_gy0 && gy <= MaxY(); }
+    size_t Slot(int gx, int gy, int ch) const { return ((size_t)(gy - m_gy0) * m_w + (gx - m_gx0)) * 2 + ch; }
+    size_t SlotCount() const { return m_occ.size(); }
+
+    uint16_t& Occ(size_t slot) { return m_occ[slot]; }
+    float& Hist(size_t slot) { return m_hist[slot]; }
+    uint32_t& Owner(size_t slot) { return m_owner[slot]; }
+
+    // 进入该通道的代价：本线网已占用的通道只计基础代价
+    double Cost(size_t slot, uint32_t netStamp, double presentFactor) const
+    {
+        if (m_owner[slot] == netStamp) return 1.0;
+        return (1.0 + m_hist[slot]) * (1.0 + presentFactor * m_occ[slot]);
+    }
+
+private:
+    int m_gx0 = 0, m_gy0 = 0, m_w = 1, m_h = 1;
+    std::vector<uint16_t> m_occ;
+    std::vector<float> m_hist;
+    std::vector<uint32_t> m_owner;   // 最近一次写入该通道的线网戳，用于同网共用与去重
+};
+
+// 带方向状态的 A*：状态为（格子，到达方向），拐弯与拐弯处的另一通道计入代价
+class BendAwareAStar
+{
+public:
+    struct Params {
+        uint32_t netStamp = 0;
+        double presentFactor = 0.0;
+        double bendCost = 0.0;
+        double heuristicWeight = 1.0;
+    };
+
+    bool Search(const CongestionGrid& grid, const ObstacleMap::Probe& probe, const Params& p,
+        int sx, int sy, int tx, int ty, int wx0, int wx1, int wy0, int wy1, std::vector<std::pair<int, int>>& outCells)
+    {
+        outCells.clear();
+        m_wx0 = wx0; m_wy0 = wy0;
+        m_w = wx1 - wx0 + 1; m_h = wy1 - wy0 + 1;
+        size_t n = (size_t)m_w * m_h * 4;
+        if (m_stamp.size() < n) { m_stamp.resize(n, 0); m_g.resize(n); m_from.resize(n); }
+        if (++m_gen == 0) { std::fill(m_stamp.begin(), m_stamp.end(), 0); m_gen = 1; }
+        m_heap.clear();
+
+        auto inWindow = [&](int x, int y) { return x >= wx0 && x <= wx1 && y >= wy0 && y <= wy1; };
+        auto heuristic = [&](int x, int y) { return p.heuristicWeight * (std::abs(x - tx) + std::abs(y - ty)); };
+        if (!inWindow(sx, sy) || !inWindow(tx, ty)) return false;
+        if (sx == tx && sy == ty) { outCells.emplace_back(sx, sy); return true; }
+
+        // 起点不占方向：直接展开四个邻格
+        for (int d = 0; d < 4; ++d) {
+            int nx = sx + kDx[d], ny = sy + kDy[d];
+            if (!inWindow(nx, ny)) continue;
+            if (!(nx == tx && ny == ty) && probe.Blocked(nx, ny)) continue;
+            double g = grid.Cost(grid.Slot(nx, ny, ChannelOf(d)), p.netStamp, p.presentFactor);
+            Relax(State(nx, ny, d), g, -1, heuristic(nx, ny));
+        }
+        while (!m_heap.empty()) {
+            std::pop_heap(m_heap.begin(), m_heap.end());
+            QNode cur = m_heap.back(); m_heap.pop_back();
+            if (cur.g > m_g[cur.state]) continue;   // 已被更优的代价取代
+            int d = cur.state & 3;
+            int cell = cur.state >> 2;
+            int cx = cell % m_w + m_wx0, cy = cell / m_w + m_wy0;
+            if (cx == tx && cy == ty) {
+                Reconstruct(cur.state, sx, sy, outCells);
+                return true;
+            }
+            for (int nd = 0; nd < 4; ++nd) {
+                if (nd == (d ^ 1)) continue;   // 不走回头路
+                int nx = cx + kDx[nd], ny = cy + kDy[nd];
+                if (!inWindow(nx, ny)) continue;
+                if (!(nx == tx && ny == ty) && probe.Blocked(nx, ny)) continue;
+                double g = cur.g + grid.Cost(grid.Slot(nx, ny, ChannelOf(nd)), p.netStamp, p.presentFactor);
+                if (nd != d) g += p.bendCost + grid.Cost(grid.Slot(cx, cy, ChannelOf(nd)), p.netStamp, p.presentFactor);
+                Relax(State(nx, ny, nd), g, cur.state, heuristic(nx, ny));
+            }
+        }
+        return false;
+    }
+
+private:
+    struct QNode {
+        double f, g;
+        int state;
+        bool operator<(const QNode& o) const { return f != o.f ? f > o.f : g < o.g; }
+    };
+    int m_wx0 = 0, m_wy0 = 0, m_w = 1, m_h = 1;
+    uint32_t m_gen = 0;
+    std::vector<uint32_t> m_stamp;
+    std::vector<double> m_g;
+    std::vector<int> m_from;
+    std::vector<QNode> m_heap;
+
+    int State(int gx, int gy, int dir) const { return (((gy - m_wy0) * m_w + (gx - m_wx0)) << 2) | dir; }
+
+    void Relax(int state, double g, int from, double h)
+    {
+        if (m_stamp[state] == m_gen && g >= m_g[state]) return;
+        m_stamp[state] = m_gen; m_g[state] = g; m_from[state] = from;
+        m_heap.push_back(QNode{ g + h, g, state });
+        std::push_heap(m_heap.begin(), m_heap.end());
+    }
+
+    void Reconstruct(int state, int sx, int sy, std::vector<std::pair<int, int>>& out) const
+    {
+        for (int s = state; s >= 0; s = m_from[s]) {
+            int cell = s >> 2;
+            out.emplace_back(cell % m_w + m_wx0, cell / m_w + m_wy0);
+        }
+        out.emplace_back(sx, sy);
+        std::reverse(out.begin(), out.end());
+    }
+};
+
+// 网格路径转为折线：首尾用精确端点，首尾两段对齐到端点坐标，去掉共线点，残余斜段补成直角
+std::vector<wxPoint> CellsToTurningPoints(const std::vector<std::pair<int, int>>& cells, const wxPoint& start, const wxPoint& end)
+{
+    std::vector<wxPoint> pts;
+    pts.reserve(cells.size() + 2);
+    for (const auto& c : cells) pts.emplace_back(c.first * kGrid, c.second * kGrid);
+    if (pts.size() >= 2) {
+        bool horizontal = cells[1].second == cells[0].second;
+        for (size_t k = 1; k < cells.size() && (horizontal ? cells[k].second == cells[0].second : cells[k].first == cells[0].first); ++k)
+            (horizontal ? pts[k].y : pts[k].x) = horizontal ? start.y : start.x;
+        size_t last = cells.size() - 1;
+        horizontal = cells[last - 1].second == cells[last].second;
+        for (size_t k = last; k-- > 0 && (horizontal ? cells[k].second == cells[last].second : cells[k].first == cells[last].first);)
+            (horizontal ? pts[k].y : pts[k].x) = horizontal ? end.y : end.x;
+    }
+    if (pts.empty()) pts.push_back(start);
+    pts.front() = start;
+    if (pts.size() < 2) pts.push_back(end);
+    pts.back() = end;
+
+    std::vector<wxPoint> ortho;
+    ortho.reserve(pts.size() + 2);
+    for (const auto& q : pts) {
+        if (!ortho.empty()) {
+            const wxPoint a = ortho.back();
+            if (a == q) continue;
+            if (a.x != q.x && a.y != q.y) ortho.emplace_back(a.x, q.y);
+        }
+        ortho.push_back(q);
+    }
+    std::vector<wxPoint> simple;
+    for (const auto& q : ortho) {
+        while (simple.size() >= 2) {
+            const wxPoint& a = simple[simple.size() - 2];
+            const wxPoint& b = simple.back();
+            if ((a.x == b.x && b.x == q.x) || (a.y == b.y && b.y == q.y)) simple.pop_back();
+            else break;
+        }
+        if (simple.empty() || simple.back() != q) simple.push_back(q);
+    }
+    if (simple.size() <= 2) return {};
+    return std::vector<wxPoint>(simple.begin() + 1, simple.end() - 1);
+}
+
+struct NetState {
+    std::vector<size_t> conns;       // 按 aux 深度、下标排序（父连接先布）
+    std::vector<size_t> slots;       // 本线网占用的通道（去重）
+    uint32_t stamp = 0;
+};
+
+} // namespace
+
+AutorouteResult AutorouteAll(const std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    const ObstacleMap& obstacles, const AutorouteOptions& opts)
+{
+    AutorouteResult result;
+    if (connections.empty()) return result;
+
+    // 线网划分见 BuildConnectionNets；线网内父连接先布
+    std::vector<NetState> nets;
+    std::vector<int> depth;
+    {
+        ConnectionNets cn = BuildConnectionNets(elements.size(), connections);
+        nets.resize(cn.Count());
+        for (size_t ci = 0; ci < connections.size(); ++ci) nets[cn.netOf[ci]].conns.push_back(ci);
+        depth.swap(cn.depth);
+        for (auto& net : nets)
+            std::stable_sort(net.conns.begin(), net.conns.end(), [&](size_t a, size_t b) { return depth[a] < depth[b]; });
+    }
+
+    // 网格覆盖全部元件与连线端点
+    ObstacleMap::CellRect ext = obstacles.Extent();
+    int gx0 = ext.Empty() ? INT32_MAX : ext.gx0, gx1 = ext.Empty() ? INT32_MIN : ext.gx1;
+    int gy0 = ext.Empty() ? INT32_MAX : ext.gy0, gy1 = ext.Empty() ? INT32_MIN : ext.gy1;
+    for (size_t ci = 0; ci < connections.size(); ++ci) {
+        EnsureConnectionGeometry(elements, connections, ci);
+        for (const wxPoint& q : connections[ci].geom.poly) {
+            gx0 = std::min(gx0, q.x / kGrid); gx1 = std::max(gx1, q.x / kGrid);
+            gy0 = std::min(gy0, q.y / kGrid); gy1 = std::max(gy1, q.y / kGrid);
+        }
+    }
+    const int pad = std::max(1, opts.windowMargin);
+    CongestionGrid grid;
+    grid.Init(gx0 - pad, gx1 + pad, gy0 - pad, gy1 + pad);
+
+    BendAwareAStar astar;
+    std::vector<std::pair<int, int>> cells;
+    uint32_t nextStamp = 0;
+    double presentFactor = opts.presentFactor;
+
+    auto ripUp = [&](NetState& net) {
+        for (size_t slot : net.slots) --grid.Occ(slot);
+        net.slots.clear();
+    };
+    auto occupy = [&](NetState& net, size_t slot) {
+        if (grid.Owner(slot) == net.stamp) return;
+        grid.Owner(slot) = net.stamp;
+        ++grid.Occ(slot);
+        net.slots.push_back(slot);
+    };
+
+    // 布一条连接；成功时写回 turningPoints 并登记占用
+    auto routeConnection = [&](NetState& net, size_t ci) -> bool {
+        ConnectionInfo& conn = connections[ci];
+        EnsureConnectionGeometry(elements, connections, ci);
+        const wxPoint start = conn.geom.poly.front(), end = conn.geom.poly.back();
+        int sx = start.x / kGrid, sy = start.y / kGrid, tx = end.x / kGrid, ty = end.y / kGrid;
+        if (!grid.InRange(sx, sy) || !grid.InRange(tx, ty)) return false;
+
+        ObstacleMap::Probe probe(obstacles, conn.aIndex, conn.bIndex);
+        BendAwareAStar::Params params;
+        params.netStamp = net.stamp; params.presentFactor = presentFactor; params.bendCost = opts.bendCost;
+        params.heuristicWeight = opts.heuristicWeight;
+        int margin = std::max(pad, (std::abs(tx - sx) + std::abs(ty - sy)) / 2);
+        bool found = false;
+        for (;;) {
+            int wx0 = std::max(grid.MinX(), std::min(sx, tx) - margin), wx1 = std::min(grid.MaxX(), std::max(sx, tx) + margin);
+            int wy0 = std::max(grid.MinY(), std::min(sy, ty) - margin), wy1 = std::min(grid.MaxY(), std::max(sy, ty) + margin);
+            found = astar.Search(grid, probe, params, sx, sy, tx, ty, wx0, wx1, wy0, wy1, cells);
+            if (found) break;
+            if (wx0 == grid.MinX() && wx1 == grid.MaxX() && wy0 == grid.MinY() && wy1 == grid.MaxY()) break;
+            margin *= 4;
+        }
+        if (!found) return false;
+
+        // 首尾格子是端点所在处，不同线网的相邻端点无法避开，不计占用
+        for (size_t k = 1; k + 1 < cells.size(); ++k) {
+            occupy(net, grid.Slot(cells[k].first, cells[k].second, cells[k].second == cells[k - 1].second ? 0 : 1));
+            occupy(net, grid.Slot(cells[k].first, cells[k].second, cells[k + 1].second == cells[k].second ? 0 : 1));
+        }
+
+        // 改走线前记下 aux 点位置，改完后投影回新折线，子连接起点随之更新
+        std::vector<wxPoint> oldAux = conn.geom.auxPixels;
+        conn.turningPoints = CellsToTurningPoints(cells, start, end);
+        conn.Touch();
+        if (!conn.auxOutputs.empty()) {
+            std::vector<wxPoint> poly;
+            poly.push_back(start);
+            poly.insert(poly.end(), conn.turningPoints.begin(), conn.turningPoints.end());
+            poly.push_back(end);
+            for (size_t ai = 0; ai < conn.auxOutputs.size() && ai < oldAux.size(); ++ai) {
+                int seg; double t; wxPoint q;
+                std::tie(seg, t, q) = ProjectPointToPolylineDetailed(oldAux[ai], poly);
+                if (seg < 0) { conn.auxOutputs[ai].segIndex = 0; conn.auxOutputs[ai].t = 0.0; }
+                else { conn.auxOutputs[ai].segIndex = seg; conn.auxOutputs[ai].t = t; }
+            }
+        }
+        return true;
+    };
+
+    // 首轮布不通的连接（端点被其它元件包住等）之后不再尝试，保留原走线
+    std::vector<char> unroutable(connections.size(), 0);
+    auto routeNet = [&](NetState& net) {
+        ripUp(net);
+        net.stamp = ++nextStamp;
+        for (size_t ci : net.conns)
+            if (!unroutable[ci] && !routeConnection(net, ci)) unroutable[ci] = 1;
+    };
+
+    // 溢出连续若干轮没有明显减少即停止（通道容量不足时继续协商只会空转）
+    const int stallLimit = 5;
+    size_t bestOverflow = SIZE_MAX;
+    int stalled = 0;
+    for (int iter = 0; iter < std::max(1, opts.maxIterations); ++iter) {
+        result.iterations = iter + 1;
+        for (auto& net : nets) {
+            bool reroute = (iter == 0);
+            for (size_t k = 0; !reroute && k < net.slots.size(); ++k) reroute = grid.Occ(net.slots[k]) > 1;
+            if (reroute) routeNet(net);
+        }
+        // 统计溢出并累积历史代价
+        size_t overflow = 0;
+        for (size_t slot = 0; slot < grid.SlotCount(); ++slot) {
+            uint16_t occ = grid.Occ(slot);
+            if (occ > 1) { ++overflow; grid.Hist(slot) += (float)(opts.historyIncrement * (occ - 1)); }
+        }
+        result.overflowCells = overflow;
+        if (overflow == 0) break;
+        if (overflow < bestOverflow - bestOverflow / 50) { bestOverflow = overflow; stalled = 0; }   // 至少改善 2%
+        else if (++stalled >= stallLimit) break;
+        presentFactor *= opts.presentGrowth;
+    }
+
+    for (char bad : unroutable) (bad ? result.failed : result.routed) += 1;
+    return result;
+}
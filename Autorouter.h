@@ -0,0 +1,33 @@
+#pragma once
+#include "CircuitModel.h"
+#include "ObstacleMap.h"
+#include <vector>
+#include <cstddef>
+
+// ---- 全局自动布线 ----
+// PathFinder 式协商拥塞：所有连接在同一张网格上反复布线。每个格子分水平/竖直两个通道计数，
+// 同一通道被多个线网占用即为溢出，其当前代价逐轮放大并累积历史代价，迫使线网互相让开；
+// 一横一竖的交叉不算拥塞。拐弯另计固定代价，以减少转折点
+
+struct AutorouteOptions {
+    int maxIterations = 40;
+    double bendCost = 3.0;           // 每个拐弯折合的格数
+    double presentFactor = 0.5;      // 首轮当前拥塞系数
+    double presentGrowth = 1.6;      // 每轮放大倍数
+    double historyIncrement = 0.4;   // 每轮溢出通道累积的历史代价
+    int windowMargin = 12;           // 单条连接搜索窗口的最小外扩（格）
+    double heuristicWeight = 1.2;    // A* 启发放大系数：略大于 1 时以少量最优性换取大幅减少展开
+};
+
+struct AutorouteResult {
+    int iterations = 0;
+    size_t routed = 0;          // 布通的连接数
+    size_t failed = 0;          // 无路可走、保留原走线的连接数
+    size_t overflowCells = 0;   // 结束时仍被多个线网共用的通道数
+};
+
+// 重新布线全部连接：写回 turningPoints，重投影 aux 点并 Touch。
+// 线网按 BuildConnectionNets 划分，同一线网的连接彼此共用通道不算拥塞。
+// obstacles 须由 elements 登记而成
+AutorouteResult AutorouteAll(const std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    const ObstacleMap& obstacles, const AutorouteOptions& opts = AutorouteOptions());
@@ -0,0 +1,93 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+
+// 单线程后台任务执行器，"最新任务优先"：提交新任务时取消正在执行的任务并替换尚未开始的任务。
+// 任务通过传入的 cancelled 标志协作取消；结果由任务自己投递回界面线程（如 wxEvtHandler::CallAfter）
+class LatestTaskWorker
+{
+public:
+    using Task = std::function<void(const std::atomic<bool>& cancelled)>;
+
+    LatestTaskWorker() = default;
+    ~LatestTaskWorker() { Stop(); }
+    LatestTaskWorker(const LatestTaskWorker&) = delete;
+    LatestTaskWorker& operator=(const LatestTaskWorker&) = delete;
+
+    void Submit(Task task)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) return;
+        if (m_running) m_running->store(true);
+        m_pending = std::move(task);
+        if (!m_thread.joinable()) m_thread = std::thread([this]() { Run(); });
+        m_cv.notify_one();
+    }
+
+    // 取消正在执行与等待中的任务（不等待其结束）
+    void Cancel()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) m_running->store(true);
+        m_pending = nullptr;
+    }
+
+    // 取消并等待正在执行的任务返回（界面线程修改任务读取的共享数据前调用；不可在任务内调用）
+    void CancelAndWait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_running) m_running->store(true);
+        m_pending = nullptr;
+        m_idle.wait(lock, [this]() { return !m_busy; });
+    }
+
+    // 取消全部任务并等待工作线程退出；所有者析构前调用，保证任务不再访问所有者
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            if (m_running) m_running->store(true);
+            m_pending = nullptr;
+        }
+        m_cv.notify_one();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+private:
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_idle;
+    bool m_busy = false;  // 工作线程正在执行任务
+    Task m_pending;
+    std::shared_ptr<std::atomic<bool>> m_running; // 当前任务的取消标志
+    bool m_stopping = false;
+
+    void Run()
+    {
+        for (;;) {
+            Task task;
+            std::shared_ptr<std::atomic<bool>> cancelled;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait(lock, [this]() { return m_stopping || m_pending; });
+                if (m_stopping) return;
+                task = std::move(m_pending);
+                m_pending = nullptr;
+                cancelled = std::make_shared<std::atomic<bool>>(false);
+                m_running = cancelled;
+                m_busy = true;
+            }
+            task(*cancelled);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_running == cancelled) m_running.reset();
+            m_busy = false;
+            m_idle.notify_all();
+        }
+    }
+};
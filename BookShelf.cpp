@@ -0,0 +1,793 @@
+#include "BookShelf.h"
+#include "MappedFile.h"
+#include "ElementDraw.h"
+#include "ObstacleMap.h"
+#include "ParallelFor.h"
+#include <string_view>
+#include <unordered_map>
+#include <charconv>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cctype>
+#include <cstdio>
+#include <thread>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+// 一行内的词：以空白和 ':' 分隔，'#' 之后为注释。词直接指向映射内存，不复制
+struct LineTokens {
+    static const int Capacity = 16;
+    std::string_view tok[Capacity];
+    int count = 0;
+
+    bool Is(int i, std::string_view s) const { return i < count && tok[i] == s; }
+};
+
+class TokenReader
+{
+public:
+    explicit TokenReader(const MappedFile& f) : m_p(f.Data()), m_end(f.Data() + f.Size()) {}
+
+    // 读下一非空行，多余的词丢弃；返回 false 表示到达文件末尾
+    bool Next(LineTokens& line)
+    {
+        while (m_p < m_end) {
+            line.count = 0;
+            const char* p = m_p;
+            while (p < m_end && *p != '\n') {
+                char ch = *p;
+                if (ch == ' ' || ch == '\t' || ch == '\r' || ch == ':') { ++p; continue; }
+                if (ch == '#') { while (p < m_end && *p != '\n') ++p; break; }
+                const char* s = p;
+                while (p < m_end) {
+                    ch = *p;
+                    if (ch == ' ' || ch == '\t' || ch == '\r' || ch == ':' || ch == '\n' || ch == '#') break;
+                    ++p;
+                }
+                if (line.count < LineTokens::Capacity) line.tok[line.count++] = std::string_view(s, (size_t)(p - s));
+            }
+            m_p = p < m_end ? p + 1 : m_end;
+            ++m_line;
+            if (line.count > 0) return true;
+        }
+        return false;
+    }
+
+    size_t LineNumber() const { return m_line; }
+
+private:
+    const char* m_p;
+    const char* m_end;
+    size_t m_line = 0;
+};
+
+bool ParseDouble(std::string_view s, double& v)
+{
+    if (!s.empty() && s[0] == '+') s.remove_prefix(1);
+    auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+bool ParseSize(std::string_view s, size_t& v)
+{
+    auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+bool Fail(std::string* error, const std::string& msg)
+{
+    if (error) *error = msg;
+    return false;
+}
+
+std::string LineError(const std::string& file, size_t line, const char* what)
+{
+    return file + " 第 " + std::to_string(line) + " 行: " + what;
+}
+
+std::string Extension(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return std::string();
+    std::string ext = path.substr(dot);
+    for (auto& ch : ext) ch = (char)std::tolower((unsigned char)ch);
+    return ext;
+}
+
+std::string Directory(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+struct BookShelfFiles {
+    std::string nodes, nets, pl, scl;
+};
+
+// .aux 形如 "RowBasedPlacement : a.nodes a.nets a.wts a.pl a.scl"，按扩展名取各文件（相对 .aux 所在目录）
+bool ResolveFiles(const std::string& path, BookShelfFiles& files, std::string* error)
+{
+    const std::string ext = Extension(path);
+    if (ext == ".aux") {
+        MappedFile aux;
+        if (!aux.Open(path)) return Fail(error, "无法打开 " + path);
+        TokenReader reader(aux);
+        LineTokens line;
+        const std::string dir = Directory(path);
+        while (reader.Next(line)) {
+            for (int i = 0; i < line.count; ++i) {
+                std::string name(line.tok[i]);
+                std::string e = Extension(name);
+                if (e == ".nodes" || e == ".node") files.nodes = dir + name;
+                else if (e == ".nets" || e == ".net") files.nets = dir + name;
+                else if (e == ".pl") files.pl = dir + name;
+                else if (e == ".scl") files.scl = dir + name;
+            }
+        }
+        if (files.nodes.empty() || files.nets.empty()) return Fail(error, path + " 中缺少 .nodes 或 .nets 文件");
+        return true;
+    }
+    // .nodes/.node：同名的其它文件；本程序导出的 .node 对应 .net
+    std::string base = ext.empty() ? path : path.substr(0, path.size() - ext.size());
+    files.nodes = path;
+    files.nets = base + (ext == ".node" ? ".net" : ".nets");
+    files.pl = base + ".pl";
+    files.scl = base + ".scl";
+    return true;
+}
+
+// 节点名索引：开放寻址的扁平哈希表，槽位只存 (哈希标记, 编号)，名字本身指向 .nodes 的映射内存。
+// 百万级节点时查找以缓存缺失为主，扁平表比 unordered_map 少两次指针跳转；
+// 批量查找时先对一批名字预取槽位，再逐个比较，使缺失相互重叠
+class NameIndex
+{
+public:
+    static uint64_t Hash(std::string_view s)
+    {
+        uint64_t h = 1469598103934665603ull;
+        for (char ch : s) { h ^= (unsigned char)ch; h *= 1099511628211ull; }
+        return h ^ (h >> 29);
+    }
+
+    void Reserve(size_t n)
+    {
+        size_t cap = 16;
+        while (cap < n * 2) cap <<= 1;
+        if (cap <= m_slots.size()) return;
+        std::vector<Slot> old;
+        old.swap(m_slots);
+        m_slots.assign(cap, Slot());
+        m_mask = cap - 1;
+        for (const Slot& s : old) if (s.id >= 0) Place(s);
+        m_names.reserve(n);
+    }
+
+    // 插入新名字；重名时返回 false
+    bool Insert(std::string_view name, int id)
+    {
+        if ((m_names.size() + 1) * 2 > m_slots.size()) Reserve(std::max<size_t>(16, m_names.size() * 2 + 2));
+        const uint64_t h = Hash(name);
+        if (Find(name, h) >= 0) return false;
+        if ((int)m_names.size() <= id) m_names.resize(id + 1);
+        m_names[id] = name;
+        Place(Slot{ (uint32_t)(h >> 32), id });
+        return true;
+    }
+
+    int Find(std::string_view name, uint64_t h) const
+    {
+        if (m_slots.empty()) return -1;
+        const uint32_t tag = (uint32_t)(h >> 32);
+        for (size_t i = (size_t)h & m_mask;; i = (i + 1) & m_mask) {
+            const Slot& s = m_slots[i];
+            if (s.id < 0) return -1;
+            if (s.tag == tag && m_names[s.id] == name) return s.id;
+        }
+    }
+
+    void Prefetch(uint64_t h) const
+    {
+        if (m_slots.empty()) return;
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&m_slots[(size_t)h & m_mask]);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch((const char*)&m_slots[(size_t)h & m_mask], _MM_HINT_T0);
+#endif
+    }
+
+private:
+    struct Slot {
+        uint32_t tag = 0;
+        int id = -1;
+    };
+    std::vector<Slot> m_slots;
+    std::vector<std::string_view> m_names;
+    size_t m_mask = 0;
+
+    void Place(const Slot& s)
+    {
+        const uint64_t h = Hash(m_names[s.id]);
+        size_t i = (size_t)h & m_mask;
+        while (m_slots[i].id >= 0) i = (i + 1) & m_mask;
+        m_slots[i] = s;
+    }
+};
+
+struct NodeTable {
+    NameIndex index;  // 名字指向 .nodes 的映射内存，须与之同生命周期
+    std::vector<double> w, h, x, y;
+    std::vector<char> terminal;
+    std::vector<char> fixed;
+
+    int Find(std::string_view name) const { return index.Find(name, NameIndex::Hash(name)); }
+};
+
+bool ReadNodes(const MappedFile& f, const std::string& file, NodeTable& nodes, std::string* error)
+{
+    TokenReader reader(f);
+    LineTokens line;
+    while (reader.Next(line)) {
+        if (line.Is(0, "UCLA")) continue;
+        if (line.Is(0, "NumNodes")) {
+            size_t n = 0;
+            if (line.count > 1 && ParseSize(line.tok[1], n)) {
+                nodes.index.Reserve(n);
+                nodes.w.reserve(n); nodes.h.reserve(n);
+                nodes.terminal.reserve(n);
+            }
+            continue;
+        }
+        if (line.Is(0, "NumTerminals")) continue;
+        double w = 1.0, h = 1.0;
+        if (line.count >= 3 && (!ParseDouble(line.tok[1], w) || !ParseDouble(line.tok[2], h)))
+            return Fail(error, LineError(file, reader.LineNumber(), "节点尺寸无法解析"));
+        bool term = line.count >= 4 && line.tok[3].substr(0, 8) == "terminal";
+        int id = (int)nodes.w.size();
+        if (!nodes.index.Insert(line.tok[0], id))
+            return Fail(error, LineError(file, reader.LineNumber(), "节点名重复"));
+        nodes.w.push_back(w);
+        nodes.h.push_back(h);
+        nodes.terminal.push_back(term ? 1 : 0);
+    }
+    const size_t n = nodes.w.size();
+    nodes.x.assign(n, 0.0);
+    nodes.y.assign(n, 0.0);
+    nodes.fixed.assign(nodes.terminal.begin(), nodes.terminal.end());
+    return true;
+}
+
+// 线网引脚按 CSR 存放：线网 k 的引脚为 [start[k], start[k+1])，driver[k] 为驱动引脚在其中的序号
+struct NetTable {
+    std::vector<size_t> start;
+    std::vector<int> pinNode;
+    std::vector<size_t> driver;
+    size_t declared = 0;
+    size_t pins = 0;
+};
+
+bool ReadNets(const MappedFile& f, const std::string& file, const NodeTable& nodes, NetTable& nets, std::string* error)
+{
+    // 引脚名先计算哈希并预取槽位，攒满一批后再按顺序查找
+    struct PendingPin {
+        std::string_view name;
+        uint64_t hash;
+        size_t net;
+        bool output;
+    };
+    const size_t kBatch = 64;
+    std::vector<PendingPin> pending;
+    pending.reserve(kBatch);
+    size_t netDriver = SIZE_MAX;
+    auto openNet = [&]() {
+        if (!nets.start.empty()) nets.driver.push_back(netDriver == SIZE_MAX ? nets.start.back() : netDriver);
+        nets.start.push_back(nets.pinNode.size());
+        netDriver = SIZE_MAX;
+    };
+    auto resolve = [&]() {
+        for (const PendingPin& p : pending) {
+            while (nets.start.size() <= p.net) openNet();
+            // 名字不在 .nodes 中的引脚跳过（例如外部导出的未知端点）
+            int node = nodes.index.Find(p.name, p.hash);
+            if (node < 0) continue;
+            if (netDriver == SIZE_MAX && p.output) netDriver = nets.pinNode.size();
+            nets.pinNode.push_back(node);
+        }
+        pending.clear();
+    };
+
+    TokenReader reader(f);
+    LineTokens line;
+    size_t remaining = 0;
+    while (reader.Next(line)) {
+        if (line.Is(0, "UCLA")) continue;
+        if (line.Is(0, "NumNets") || line.Is(0, "NumPins")) {
+            size_t n = 0;
+            if (line.count > 1 && ParseSize(line.tok[1], n)) {
+                if (line.tok[0] == "NumNets") { nets.start.reserve(n + 1); nets.driver.reserve(n); }
+                else nets.pinNode.reserve(n);
+            }
+            continue;
+        }
+        if (line.Is(0, "NetDegree")) {
+            if (line.count < 2 || !ParseSize(line.tok[1], remaining))
+                return Fail(error, LineError(file, reader.LineNumber(), "NetDegree 无法解析"));
+            ++nets.declared;
+            continue;
+        }
+        if (remaining == 0)
+            return Fail(error, LineError(file, reader.LineNumber(), "引脚不属于任何线网"));
+        --remaining;
+        ++nets.pins;
+        const uint64_t h = NameIndex::Hash(line.tok[0]);
+        nodes.index.Prefetch(h);
+        pending.push_back(PendingPin{ line.tok[0], h, nets.declared - 1, line.Is(1, "O") });
+        if (pending.size() == kBatch) resolve();
+    }
+    resolve();
+    while (nets.start.size() < nets.declared) openNet();
+    openNet();
+    return true;
+}
+
+bool ReadPlacement(const MappedFile& f, const std::string& file, NodeTable& nodes, std::string* error)
+{
+    TokenReader reader(f);
+    LineTokens line;
+    while (reader.Next(line)) {
+        if (line.Is(0, "UCLA") || line.count < 3) continue;
+        int node = nodes.Find(line.tok[0]);
+        if (node < 0) continue;
+        if (!ParseDouble(line.tok[1], nodes.x[node]) || !ParseDouble(line.tok[2], nodes.y[node]))
+            return Fail(error, LineError(file, reader.LineNumber(), "坐标无法解析"));
+        for (int i = 3; i < line.count; ++i)
+            if (line.tok[i] == "/FIXED" || line.tok[i] == "/FIXED_NI") nodes.fixed[node] = 1;
+    }
+    return true;
+}
+
+bool ReadRows(const MappedFile& f, const std::string& file, double scale, std::vector<BookShelfRow>& rows, std::string* error)
+{
+    TokenReader reader(f);
+    LineTokens line;
+    bool inRow = false;
+    double coord = 0, height = 0, spacing = 1, origin = 0, sites = 0;
+    while (reader.Next(line)) {
+        if (line.Is(0, "CoreRow")) {
+            inRow = true;
+            coord = 0; height = 0; spacing = 1; origin = 0; sites = 0;
+            continue;
+        }
+        if (!inRow) continue;
+        if (line.Is(0, "End")) {
+            BookShelfRow r;
+            r.y = (int)std::lround(coord * scale);
+            r.height = (int)std::lround(height * scale);
+            r.x = (int)std::lround(origin * scale);
+            r.width = (int)std::lround(sites * spacing * scale);
+            rows.push_back(r);
+            inRow = false;
+            continue;
+        }
+        // 同一行可能有多对 "Key : value"，如 "SubrowOrigin : 0 NumSites : 100"
+        for (int i = 0; i + 1 < line.count; i += 2) {
+            double v = 0;
+            if (!ParseDouble(line.tok[i + 1], v)) {
+                if (line.tok[i] == "Siteorient" || line.tok[i] == "Sitesymmetry") continue;
+                return Fail(error, LineError(file, reader.LineNumber(), "行参数无法解析"));
+            }
+            const std::string_view key = line.tok[i];
+            if (key == "Coordinate") coord = v;
+            else if (key == "Height") height = v;
+            else if (key == "Sitespacing") spacing = v;
+            else if (key == "SubrowOrigin") origin = v;
+            else if (key == "NumSites") sites = v;
+        }
+    }
+    return true;
+}
+
+// 自动缩放：可移动节点高度的中位数对应 40 像素（没有可移动节点时取全部节点）
+double AutoScale(const NodeTable& nodes)
+{
+    std::vector<double> hs;
+    hs.reserve(nodes.h.size());
+    for (size_t i = 0; i < nodes.h.size(); ++i) if (!nodes.terminal[i] && nodes.h[i] > 0) hs.push_back(nodes.h[i]);
+    if (hs.empty()) for (double h : nodes.h) if (h > 0) hs.push_back(h);
+    if (hs.empty()) return 1.0;
+    auto mid = hs.begin() + hs.size() / 2;
+    std::nth_element(hs.begin(), mid, hs.end());
+    return (double)BaseElemHeight / *mid;
+}
+
+// ---- 写出 ----
+
+// 追加式文本缓冲：数字直接用 to_chars 写进 vector 尾部，不经过 iostream 与 locale
+class TextBuffer
+{
+public:
+    std::vector<char> data;
+
+    void Put(std::string_view s) { data.insert(data.end(), s.begin(), s.end()); }
+    void Put(char ch) { data.push_back(ch); }
+
+    void PutInt(long long v)
+    {
+        const size_t old = data.size();
+        data.resize(old + 24);
+        auto r = std::to_chars(data.data() + old, data.data() + data.size(), v);
+        data.resize((size_t)(r.ptr - data.data()));
+    }
+
+    // 最短的可精确读回的表示，整数值不带小数点
+    void PutNum(double v)
+    {
+        const size_t old = data.size();
+        data.resize(old + 32);
+        auto r = std::to_chars(data.data() + old, data.data() + data.size(), v);
+        data.resize((size_t)(r.ptr - data.data()));
+    }
+
+    void PutNode(int node, int elementCount)
+    {
+        if (node < elementCount) { Put("comp"); PutInt(node); }
+        else { Put("ext"); PutInt(node - elementCount); }
+    }
+};
+
+// 以大块 fwrite 写出的文件；缓冲超过 kFlushBytes 时写出
+class BufferedFile
+{
+public:
+    static const size_t kFlushBytes = 4 << 20;
+
+    explicit BufferedFile(const std::string& path) : m_file(std::fopen(path.c_str(), "wb")) { buf.data.reserve(kFlushBytes + 4096); }
+    ~BufferedFile() { if (m_file) std::fclose(m_file); }
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+    bool IsOpen() const { return m_file != nullptr; }
+    TextBuffer buf;
+
+    void MaybeFlush() { if (buf.data.size() >= kFlushBytes) Flush(); }
+
+    void Write(const TextBuffer& block)
+    {
+        if (buf.data.size() + block.data.size() >= kFlushBytes) Flush();
+        if (block.data.size() >= kFlushBytes) WriteRaw(block.data.data(), block.data.size());
+        else buf.Put(std::string_view(block.data.data(), block.data.size()));
+    }
+
+    void Flush()
+    {
+        WriteRaw(buf.data.data(), buf.data.size());
+        buf.data.clear();
+    }
+
+    // 写出剩余内容并关闭；任一次写入失败都返回 false
+    bool Close()
+    {
+        if (!m_file) return false;
+        Flush();
+        bool ok = m_ok && std::fclose(m_file) == 0;
+        m_file = nullptr;
+        return ok;
+    }
+
+private:
+    std::FILE* m_file;
+    bool m_ok = true;
+
+    void WriteRaw(const char* p, size_t n)
+    {
+        if (n > 0 && m_file && std::fwrite(p, 1, n, m_file) != n) m_ok = false;
+    }
+};
+
+// 把 [0, count) 按 blockSize 分块，并行格式化到各块缓冲，再按顺序写出；每轮最多 blocksPerRound 块以限制内存
+template <class Fn>
+void WriteBlocks(BufferedFile& file, size_t count, size_t blockSize, Fn&& format)
+{
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t blocksPerRound = (size_t)threads * 4;
+    const size_t blockCount = (count + blockSize - 1) / blockSize;
+    std::vector<TextBuffer> blocks(std::min(blockCount, blocksPerRound));
+    for (size_t first = 0; first < blockCount; first += blocksPerRound) {
+        const size_t n = std::min(blocksPerRound, blockCount - first);
+        ParallelFor(n, [&](size_t bi) {
+            TextBuffer& out = blocks[bi];
+            out.data.clear();
+            const size_t b = (first + bi) * blockSize;
+            format(out, b, std::min(count, b + blockSize));
+        }, threads);
+        for (size_t bi = 0; bi < n; ++bi) file.Write(blocks[bi]);
+    }
+}
+
+// 写出用的线网：引脚按 CSR 存放，node >= 元件数的为 terminal；偏移相对节点中心
+struct ExportNets {
+    std::vector<size_t> start;
+    std::vector<int> node;
+    std::vector<char> output;
+    std::vector<int> dx, dy;
+    std::vector<wxPoint> terminals;   // terminal k 的坐标
+
+    void AddPin(int n, bool isOutput, int x, int y)
+    {
+        node.push_back(n); output.push_back(isOutput ? 1 : 0); dx.push_back(x); dy.push_back(y);
+    }
+};
+
+ExportNets BuildExportNets(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections)
+{
+    const int n = (int)elements.size();
+    ExportNets nets;
+    std::unordered_map<int64_t, int> terminalAt;
+    auto terminal = [&](int x, int y) {
+        const int64_t key = ((int64_t)x << 32) | (uint32_t)y;
+        auto it = terminalAt.find(key);
+        if (it != terminalAt.end()) return it->second;
+        const int id = n + (int)nets.terminals.size();
+        nets.terminals.emplace_back(x, y);
+        terminalAt.emplace(key, id);
+        return id;
+    };
+    auto center = [](const ElementInfo& e) {
+        const int sz = std::max(1, e.size);
+        return wxPoint(e.x + BaseElemWidth * sz / 2, e.y + BaseElemHeight * sz / 2);
+    };
+
+    const ConnectionNets cn = BuildConnectionNets(elements.size(), connections);
+    const std::vector<size_t>& netOfConn = cn.netOf;
+    const std::vector<size_t>& rootOfNet = cn.root;
+
+    // 计数排序：各线网的负载连接连续排列，线网内保持连接原有顺序
+    const size_t netCount = rootOfNet.size();
+    std::vector<size_t> sinkStart(netCount + 1, 0);
+    for (size_t ci = 0; ci < connections.size(); ++ci) ++sinkStart[netOfConn[ci] + 1];
+    for (size_t k = 0; k < netCount; ++k) sinkStart[k + 1] += sinkStart[k];
+    std::vector<size_t> order(connections.size());
+    {
+        std::vector<size_t> fill(sinkStart.begin(), sinkStart.end() - 1);
+        for (size_t ci = 0; ci < connections.size(); ++ci) order[fill[netOfConn[ci]]++] = ci;
+    }
+
+    nets.start.reserve(netCount + 1);
+    nets.node.reserve(connections.size() + netCount);
+    nets.output.reserve(connections.size() + netCount);
+    nets.dx.reserve(connections.size() + netCount);
+    nets.dy.reserve(connections.size() + netCount);
+    for (size_t k = 0; k < netCount; ++k) {
+        nets.start.push_back(nets.node.size());
+        const auto& r = connections[rootOfNet[k]];
+        if (r.aIndex >= 0 && r.aIndex < n) {
+            const ElementInfo& e = elements[r.aIndex];
+            const wxPoint p = ElementOutputPoint(e, r.aPin < 0 ? 0 : r.aPin);
+            const wxPoint c = center(e);
+            nets.AddPin(r.aIndex, true, p.x - c.x, p.y - c.y);
+        }
+        else nets.AddPin(terminal(r.x1, r.y1), true, 0, 0);
+        for (size_t s = sinkStart[k]; s < sinkStart[k + 1]; ++s) {
+            const auto& cn = connections[order[s]];
+            if (cn.bIndex >= 0 && cn.bIndex < n) {
+                const ElementInfo& e = elements[cn.bIndex];
+                const wxPoint p = ElementInputPoint(e, cn.bPin < 0 ? 0 : cn.bPin);
+                const wxPoint c = center(e);
+                nets.AddPin(cn.bIndex, false, p.x - c.x, p.y - c.y);
+            }
+            else nets.AddPin(terminal(cn.x2, cn.y2), false, 0, 0);
+        }
+    }
+    nets.start.push_back(nets.node.size());
+    return nets;
+}
+
+std::string BaseName(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+bool ReadBookShelf(const std::string& path, BookShelfDesign& out, std::string* error, const BookShelfReadOptions& opts)
+{
+    BookShelfFiles files;
+    if (!ResolveFiles(path, files, error)) return false;
+
+    MappedFile nodesFile, netsFile;
+    if (!nodesFile.Open(files.nodes)) return Fail(error, "无法打开 " + files.nodes);
+    if (!netsFile.Open(files.nets)) return Fail(error, "无法打开 " + files.nets);
+
+    NodeTable nodes;
+    if (!ReadNodes(nodesFile, files.nodes, nodes, error)) return false;
+    NetTable nets;
+    if (!ReadNets(netsFile, files.nets, nodes, nets, error)) return false;
+    netsFile.Close();
+    {
+        MappedFile plFile;
+        if (!files.pl.empty() && plFile.Open(files.pl) && !ReadPlacement(plFile, files.pl, nodes, error)) return false;
+    }
+
+    const double scale = opts.scale > 0 ? opts.scale : AutoScale(nodes);
+    out = BookShelfDesign();
+    out.scale = scale;
+    out.nets = nets.declared;
+    out.pins = nets.pins;
+    {
+        MappedFile sclFile;
+        if (!files.scl.empty() && sclFile.Open(files.scl) && !ReadRows(sclFile, files.scl, scale, out.rows, error)) return false;
+    }
+
+    // 端点编号：每个线网占用驱动节点的一个输出端点与各负载节点的一个输入端点
+    const size_t n = nodes.w.size();
+    const size_t netCount = nets.start.size() - 1;
+    std::vector<int> outCount(n, 0), inCount(n, 0);
+    size_t connCount = 0;
+    for (size_t k = 0; k < netCount; ++k) {
+        const size_t b = nets.start[k], e = nets.start[k + 1];
+        if (e - b < 2) continue;
+        ++outCount[nets.pinNode[nets.driver[k]]];
+        for (size_t p = b; p < e; ++p) if (p != nets.driver[k]) ++inCount[nets.pinNode[p]];
+        connCount += e - b - 1;
+    }
+
+    out.elements.resize(n);
+    out.fixed.assign(nodes.fixed.begin(), nodes.fixed.end());
+    for (size_t i = 0; i < n; ++i) {
+        ElementInfo& el = out.elements[i];
+        el.type = nodes.terminal[i] ? "Terminal" : nodes.fixed[i] ? "FixedCell" : "Cell";
+        el.color = "black";
+        el.x = (int)std::lround(nodes.x[i] * scale);
+        el.y = (int)std::lround(nodes.y[i] * scale);
+        double sz = std::max(nodes.w[i] * scale / BaseElemWidth, nodes.h[i] * scale / BaseElemHeight);
+        el.size = std::max(1, (int)std::lround(sz));
+        el.inputs = inCount[i];
+        el.outputs = outCount[i];
+    }
+    nodesFile.Close();
+
+    std::fill(outCount.begin(), outCount.end(), 0);
+    std::fill(inCount.begin(), inCount.end(), 0);
+    out.connections.resize(connCount);
+    size_t ci = 0;
+    for (size_t k = 0; k < netCount; ++k) {
+        const size_t b = nets.start[k], e = nets.start[k + 1];
+        if (e - b < 2) continue;
+        const int d = nets.pinNode[nets.driver[k]];
+        const int dPin = outCount[d]++;
+        const wxPoint src = ElementOutputPoint(out.elements[d], dPin);
+        for (size_t p = b; p < e; ++p) {
+            if (p == nets.driver[k]) continue;
+            const int s = nets.pinNode[p];
+            ConnectionInfo& c = out.connections[ci++];
+            c.aIndex = d; c.aPin = dPin;
+            c.bIndex = s; c.bPin = inCount[s]++;
+            const wxPoint dst = ElementInputPoint(out.elements[s], c.bPin);
+            c.x1 = src.x; c.y1 = src.y;
+            c.x2 = dst.x; c.y2 = dst.y;
+        }
+    }
+    return true;
+}
+
+bool WriteBookShelf(const std::string& base, const std::vector<ElementInfo>& elements,
+    const std::vector<ConnectionInfo>& connections, std::string* error)
+{
+    const int n = (int)elements.size();
+    const ExportNets nets = BuildExportNets(elements, connections);
+    const size_t netCount = nets.start.size() - 1;
+    const size_t terminalCount = nets.terminals.size();
+    const size_t nodeCount = (size_t)n + terminalCount;
+    const int kSite = ObstacleMap::GridSize;
+
+    auto failWrite = [&](const std::string& path) { return Fail(error, "写入失败: " + path); };
+
+    // .node
+    {
+        const std::string path = base + ".node";
+        BufferedFile f(path);
+        if (!f.IsOpen()) return Fail(error, "无法创建 " + path);
+        f.buf.Put("UCLA nodes 1.0\n\nNumNodes : "); f.buf.PutInt((long long)nodeCount);
+        f.buf.Put("\nNumTerminals : "); f.buf.PutInt((long long)terminalCount); f.buf.Put('\n');
+        WriteBlocks(f, nodeCount, 65536, [&](TextBuffer& out, size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                out.Put('\t'); out.PutNode((int)i, n);
+                if ((int)i < n) {
+                    const int sz = std::max(1, elements[i].size);
+                    out.Put('\t'); out.PutInt(BaseElemWidth * sz);
+                    out.Put('\t'); out.PutInt(BaseElemHeight * sz); out.Put('\n');
+                }
+                else out.Put("\t1\t1\tterminal\n");
+            }
+        });
+        if (!f.Close()) return failWrite(path);
+    }
+    // .net
+    {
+        const std::string path = base + ".net";
+        BufferedFile f(path);
+        if (!f.IsOpen()) return Fail(error, "无法创建 " + path);
+        f.buf.Put("UCLA nets 1.0\n\nNumNets : "); f.buf.PutInt((long long)netCount);
+        f.buf.Put("\nNumPins : "); f.buf.PutInt((long long)nets.node.size()); f.buf.Put('\n');
+        WriteBlocks(f, netCount, 16384, [&](TextBuffer& out, size_t b, size_t e) {
+            for (size_t k = b; k < e; ++k) {
+                const size_t p0 = nets.start[k], p1 = nets.start[k + 1];
+                out.Put("NetDegree : "); out.PutInt((long long)(p1 - p0));
+                out.Put(" n"); out.PutInt((long long)k); out.Put('\n');
+                for (size_t p = p0; p < p1; ++p) {
+                    out.Put('\t'); out.PutNode(nets.node[p], n);
+                    out.Put(nets.output[p] ? " O : " : " I : ");
+                    out.PutNum(nets.dx[p]); out.Put(' '); out.PutNum(nets.dy[p]); out.Put('\n');
+                }
+            }
+        });
+        if (!f.Close()) return failWrite(path);
+    }
+    // .pl：元件与 terminal 的左下角（即世界坐标原点角）
+    {
+        const std::string path = base + ".pl";
+        BufferedFile f(path);
+        if (!f.IsOpen()) return Fail(error, "无法创建 " + path);
+        f.buf.Put("UCLA pl 1.0\n\n");
+        WriteBlocks(f, nodeCount, 65536, [&](TextBuffer& out, size_t b, size_t e) {
+            for (size_t i = b; i < e; ++i) {
+                out.PutNode((int)i, n);
+                if ((int)i < n) {
+                    out.Put('\t'); out.PutInt(elements[i].x);
+                    out.Put('\t'); out.PutInt(elements[i].y);
+                    out.Put(IsFixedElementType(elements[i].type) ? "\t: N /FIXED\n" : "\t: N\n");
+                }
+                else {
+                    const wxPoint& t = nets.terminals[i - n];
+                    out.Put('\t'); out.PutInt(t.x);
+                    out.Put('\t'); out.PutInt(t.y); out.Put("\t: N /FIXED\n");
+                }
+            }
+        });
+        if (!f.Close()) return failWrite(path);
+    }
+    // .scl：覆盖元件包围盒的行
+    {
+        const std::string path = base + ".scl";
+        BufferedFile f(path);
+        if (!f.IsOpen()) return Fail(error, "无法创建 " + path);
+        int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+        for (int i = 0; i < n; ++i) {
+            const ElementInfo& e = elements[i];
+            const int sz = std::max(1, e.size);
+            if (i == 0) { x0 = e.x; y0 = e.y; x1 = e.x + BaseElemWidth * sz; y1 = e.y + BaseElemHeight * sz; continue; }
+            x0 = std::min(x0, e.x); y0 = std::min(y0, e.y);
+            x1 = std::max(x1, e.x + BaseElemWidth * sz); y1 = std::max(y1, e.y + BaseElemHeight * sz);
+        }
+        const size_t rows = n == 0 ? 0 : (size_t)((y1 - y0 + BaseElemHeight - 1) / BaseElemHeight);
+        const long long sites = (x1 - x0 + kSite - 1) / kSite;
+        f.buf.Put("UCLA scl 1.0\n\nNumRows : "); f.buf.PutInt((long long)rows); f.buf.Put("\n\n");
+        for (size_t r = 0; r < rows; ++r) {
+            f.buf.Put("CoreRow Horizontal\n  Coordinate : "); f.buf.PutInt(y0 + (long long)r * BaseElemHeight);
+            f.buf.Put("\n  Height : "); f.buf.PutInt(BaseElemHeight);
+            f.buf.Put("\n  Sitewidth : "); f.buf.PutInt(kSite);
+            f.buf.Put("\n  Sitespacing : "); f.buf.PutInt(kSite);
+            f.buf.Put("\n  Siteorient : 1\n  Sitesymmetry : 1\n  SubrowOrigin : "); f.buf.PutInt(x0);
+            f.buf.Put("  NumSites : "); f.buf.PutInt(sites);
+            f.buf.Put("\nEnd\n");
+            f.MaybeFlush();
+        }
+        if (!f.Close()) return failWrite(path);
+    }
+    // .aux
+    {
+        const std::string path = base + ".aux";
+        BufferedFile f(path);
+        if (!f.IsOpen()) return Fail(error, "无法创建 " + path);
+        const std::string name = BaseName(base);
+        f.buf.Put("RowBasedPlacement : ");
+        f.buf.Put(name + ".node " + name + ".net " + name + ".pl " + name + ".scl\n");
+        if (!f.Close()) return failWrite(path);
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "CircuitModel.h"
+#include <string>
+#include <vector>
+
+// ---- BookShelf 读取 ----
+// 读取 UCLA BookShelf 基准（.aux 或 .nodes 及同名的 .nets/.pl/.scl）。文件以内存映射方式打开，
+// 在映射的页面上逐行分词，节点名以指向映射内存的 string_view 建索引，不复制文件内容。
+// 节点变为元件：普通节点类型为 "Cell"，terminal 节点为 "Terminal"，.pl 中标记 /FIXED 的节点为 "FixedCell"，
+// 后两者为固定元件（IsFixedElementType），导入后的布局/合法化不移动它们；
+// 元件尺寸按 60x40 的整数倍取最接近的 size。每个多引脚线网取第一个 O 引脚（没有则取第一个引脚）
+// 为驱动端，向其余引脚各连一条连接，这些连接共用驱动端点，在布局/布线中视为同一线网
+
+struct BookShelfRow {
+    int y = 0;           // 行底边（世界坐标）
+    int height = 0;
+    int x = 0;           // 子行起点
+    int width = 0;       // 站点数 * 站点间距
+};
+
+struct BookShelfDesign {
+    std::vector<ElementInfo> elements;
+    std::vector<ConnectionInfo> connections;
+    std::vector<char> fixed;         // terminal 或 .pl 中标记 /FIXED 的节点（与 FixedElementMask(elements) 一致）
+    std::vector<BookShelfRow> rows;  // .scl 中的行（世界坐标）
+    size_t nets = 0;                 // 读取的线网数（含被跳过的单引脚线网）
+    size_t pins = 0;
+    double scale = 1.0;              // BookShelf 坐标到世界坐标（像素）的缩放
+};
+
+struct BookShelfReadOptions {
+    double scale = 0.0;     // 0 表示按节点高度的中位数自动取，使其对应一个 40 像素高的元件
+};
+
+// path 为 .aux（按其中列出的文件名读取）或 .nodes（同目录下取同名的 .nets/.pl/.scl）。
+// .nodes 与 .nets 必须存在，.pl/.scl 可缺省。失败时返回 false 并在 error 中给出原因
+bool ReadBookShelf(const std::string& path, BookShelfDesign& out, std::string* error = nullptr,
+    const BookShelfReadOptions& opts = BookShelfReadOptions());
+
+// ---- BookShelf 写出 ----
+// 写出 base.aux/.node/.net/.pl/.scl（.node/.net 沿用本程序原有的文件名，ReadBookShelf 可直接读回）。
+// 按 BuildConnectionNets 划分的每个线网写为一个多引脚线网；
+// 未接元件的自由端点按坐标去重为 1x1 的 terminal 节点，在 .pl 中标记 /FIXED。
+// 引脚偏移相对节点中心；.scl 按元件包围盒生成 40 像素高、10 像素站点的行。
+// 数字用 std::to_chars 格式化到分块缓冲区，大文件按块并行格式化后顺序写出
+bool WriteBookShelf(const std::string& base, const std::vector<ElementInfo>& elements,
+    const std::vector<ConnectionInfo>& connections, std::string* error = nullptr);
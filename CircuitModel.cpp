@@ -0,0 +1,311 @@
+#include "CircuitModel.h"
+#include "JsonStreamReader.h"
+#include <nlohmann/json.hpp>
+#include <fstream>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <unordered_map>
+#include <algorithm>
+#include "ElementDraw.h"
+using json = nlohmann::json;
+
+bool IsFixedElementType(const std::string& type)
+{
+    return type == "Terminal" || type == "FixedCell";
+}
+
+std::vector<char> FixedElementMask(const std::vector<ElementInfo>& elements)
+{
+    std::vector<char> fixed;
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (!IsFixedElementType(elements[i].type)) continue;
+        if (fixed.empty()) fixed.assign(elements.size(), 0);
+        fixed[i] = 1;
+    }
+    return fixed;
+}
+
+int ConnectionRoot(const std::vector<ConnectionInfo>& connections, size_t ci, size_t* root)
+{
+    int depth = 0;
+    size_t cur = ci;
+    while (depth < 64) {
+        int parent = connections[cur].aConn;
+        if (parent < 0 || parent >= (int)connections.size()) break;
+        cur = (size_t)parent; ++depth;
+    }
+    if (root) *root = cur;
+    return depth;
+}
+
+ConnectionNets BuildConnectionNets(size_t elementCount, const std::vector<ConnectionInfo>& connections)
+{
+    const int n = (int)elementCount;
+    ConnectionNets nets;
+    nets.netOf.resize(connections.size());
+    nets.depth.resize(connections.size());
+    std::unordered_map<int64_t, size_t> netOfKey;
+    netOfKey.reserve(connections.size());
+    for (size_t ci = 0; ci < connections.size(); ++ci) {
+        size_t root = ci;
+        nets.depth[ci] = ConnectionRoot(connections, ci, &root);
+        const auto& r = connections[root];
+        // 输出引脚 -1 与 0 是同一端点
+        const int64_t key = (r.aIndex >= 0 && r.aIndex < n) ? (((int64_t)r.aIndex << 32) | (uint32_t)std::max(0, r.aPin))
+            : -(int64_t)root - 1;
+        auto it = netOfKey.emplace(key, nets.root.size()).first;
+        if (it->second == nets.root.size()) nets.root.push_back(root);
+        nets.netOf[ci] = it->second;
+    }
+    return nets;
+}
+
+wxPoint ElementOutputPoint(const ElementInfo& e, int pinIndex)
+{
+    int sz = std::max(1, e.size);
+    int w = BaseElemWidth * sz;
+    int h = BaseElemHeight * sz;
+    int n = std::max(1, e.outputs);
+    float step = (float)h / (n + 1);
+    int py = e.y + (int)(step * (pinIndex + 1));
+    return wxPoint(e.x + w, py);
+}
+
+wxPoint ElementInputPoint(const ElementInfo& e, int pinIndex)
+{
+    int sz = std::max(1, e.size);
+    int w = BaseElemWidth * sz;
+    int h = BaseElemHeight * sz;
+    int n = std::max(1, e.inputs);
+    float step = (float)h / (n + 1);
+    int py = e.y + (int)(step * (pinIndex + 1));
+    return wxPoint(e.x, py);
+}
+
+// 投影点到段，返回 t 与最近点
+std::pair<double, wxPoint> ProjectPointToSegmentT(const wxPoint& a, const wxPoint& b, const wxPoint& p) {
+    int dx = b.x - a.x;
+    int dy = b.y - a.y;
+    if (dx == 0 && dy == 0) return { 0.0, a };
+    double denom = double(dx) * dx + double(dy) * dy;
+    double t = ((p.x - a.x) * (double)dx + (p.y - a.y) * (double)dy) / denom;
+    if (t < 0.0) t = 0.0;
+    if (t > 1.0) t = 1.0;
+    wxPoint q((int)std::round(a.x + t * dx), (int)std::round(a.y + t * dy));
+    return { t, q };
+}
+
+std::tuple<int, double, wxPoint> ProjectPointToPolylineDetailed(const wxPoint& p, const std::vector<wxPoint>& pts) {
+    if (pts.size() < 2) return { -1, 0.0, p };
+    int bestSeg = -1;
+    double bestT = 0.0;
+    int bestSq = INT_MAX;
+    wxPoint bestPt = pts.front();
+    for (size_t i = 1; i < pts.size(); ++i) {
+        auto pr = ProjectPointToSegmentT(pts[i - 1], pts[i], p);
+        double t = pr.first;
+        wxPoint q = pr.second;
+        int dx = p.x - q.x;
+        int dy = p.y - q.y;
+        int d2 = dx * dx + dy * dy;
+        if (d2 < bestSq) {
+            bestSq = d2;
+            bestSeg = (int)i - 1;
+            bestT = t;
+            bestPt = q;
+        }
+    }
+    return { bestSeg, bestT, bestPt };
+}
+
+// aux 点（segIndex, t）在折线上的像素位置，poly 至少包含两个点
+wxPoint PointOnPolyline(const std::vector<wxPoint>& poly, const ConnectionInfo::AuxOutput& ao) {
+    int seg = ao.segIndex;
+    if (seg < 0) seg = 0;
+    if (seg >= (int)poly.size() - 1) seg = (int)poly.size() - 2;
+    const wxPoint& a = poly[seg];
+    const wxPoint& b = poly[seg + 1];
+    int dx = b.x - a.x;
+    int dy = b.y - a.y;
+    double t = ao.t;
+    if (t < 0.0) t = 0.0;
+    if (t > 1.0) t = 1.0;
+    return wxPoint((int)std::round(a.x + t * dx), (int)std::round(a.y + t * dy));
+}
+
+// 确保连接 ci 的几何缓存有效：先确保父连接有效，再比较各版本号，过期时原地重算
+void EnsureConnectionGeometry(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections, size_t ci, int depth)
+{
+    const ConnectionInfo& c = connections[ci];
+    ConnectionInfo::GeometryCache& g = c.geom;
+    bool aBound = c.aIndex >= 0 && c.aIndex < (int)elements.size();
+    bool bBound = c.bIndex >= 0 && c.bIndex < (int)elements.size();
+    uint64_t aStamp = aBound ? elements[c.aIndex].geomStamp : 0;
+    uint64_t bStamp = bBound ? elements[c.bIndex].geomStamp : 0;
+    int parent = -1;
+    uint64_t parentStamp = 0;
+    if (!aBound && c.aConn >= 0 && c.aConn < (int)connections.size() && c.aConn != (int)ci && c.aConnAux >= 0 && depth < 64) {
+        EnsureConnectionGeometry(elements, connections, c.aConn, depth + 1);
+        if (c.aConnAux < (int)connections[c.aConn].geom.auxPixels.size()) {
+            parent = c.aConn;
+            parentStamp = connections[parent].geom.stamp;
+        }
+    }
+    if (g.valid && g.aStamp == aStamp && g.bStamp == bStamp && g.parentStamp == parentStamp && g.routeStamp == c.routeStamp) return;
+
+    wxPoint p1(c.x1, c.y1), p2(c.x2, c.y2);
+    if (aBound) p1 = ElementOutputPoint(elements[c.aIndex], c.aPin < 0 ? 0 : c.aPin);
+    else if (parent >= 0) p1 = connections[parent].geom.auxPixels[c.aConnAux];
+    if (bBound) p2 = ElementInputPoint(elements[c.bIndex], c.bPin < 0 ? 0 : c.bPin);
+    g.poly.clear();
+    g.poly.push_back(p1);
+    g.poly.insert(g.poly.end(), c.turningPoints.begin(), c.turningPoints.end());
+    g.poly.push_back(p2);
+
+    g.auxPixels.clear();
+    for (const auto& ao : c.auxOutputs) g.auxPixels.push_back(PointOnPolyline(g.poly, ao));
+
+    g.valid = true;
+    g.aStamp = aStamp; g.bStamp = bStamp; g.parentStamp = parentStamp; g.routeStamp = c.routeStamp;
+    g.stamp = NextGeometryStamp();
+}
+
+// 元件/连接与 JSON 对象互转（设计文件与编辑日志共用同一字段名）
+json ElementToJson(const ElementInfo& e)
+{
+    json item;
+    item["type"] = e.type;
+    item["color"] = e.color;
+    item["thickness"] = e.thickness;
+    item["x"] = e.x; item["y"] = e.y;
+    item["size"] = e.size;
+    item["rotationIndex"] = e.rotationIndex;
+    item["inputs"] = e.inputs;
+    item["outputs"] = e.outputs;
+    return item;
+}
+
+ElementInfo ElementFromJson(const json& comp)
+{
+    ElementInfo e;
+    e.type = comp.value("type", std::string());
+    e.color = comp.value("color", std::string("black"));
+    e.thickness = comp.value("thickness", 1);
+    e.x = comp.value("x", 0);
+    e.y = comp.value("y", 0);
+    e.size = comp.value("size", 1);
+    e.rotationIndex = comp.value("rotationIndex", 0);
+    e.inputs = comp.value("inputs", 0);
+    e.outputs = comp.value("outputs", 0);
+    return e;
+}
+
+json ConnectionToJson(const ConnectionInfo& c, const ConnectionInfo::GeometryCache* geom)
+{
+    json cj;
+    cj["a"] = c.aIndex; cj["aPin"] = c.aPin;
+    cj["b"] = c.bIndex; cj["bPin"] = c.bPin;
+    if (geom && geom->valid && geom->poly.size() >= 2) {
+        cj["x1"] = geom->poly.front().x; cj["y1"] = geom->poly.front().y;
+        cj["x2"] = geom->poly.back().x; cj["y2"] = geom->poly.back().y;
+    }
+    else {
+        cj["x1"] = c.x1; cj["y1"] = c.y1;
+        cj["x2"] = c.x2; cj["y2"] = c.y2;
+    }
+    cj["aConn"] = c.aConn; cj["aConnAux"] = c.aConnAux;
+    cj["turningPoints"] = json::array();
+    for (const auto& p : c.turningPoints) cj["turningPoints"].push_back({ p.x, p.y });
+    cj["auxOutputs"] = json::array();
+    for (size_t ai = 0; ai < c.auxOutputs.size(); ++ai) {
+        const auto& ao = c.auxOutputs[ai];
+        json ajo; ajo["seg"] = ao.segIndex; ajo["t"] = ao.t;
+        if (geom && geom->valid && ai < geom->auxPixels.size()) ajo["pos"] = { geom->auxPixels[ai].x, geom->auxPixels[ai].y };
+        cj["auxOutputs"].push_back(ajo);
+    }
+    return cj;
+}
+
+ConnectionInfo ConnectionFromJson(const json& c)
+{
+    ConnectionInfo ci;
+    ci.aIndex = c.value("a", -1);
+    ci.aPin = c.value("aPin", -1);
+    ci.bIndex = c.value("b", -1);
+    ci.bPin = c.value("bPin", -1);
+    ci.x1 = c.value("x1", 0);
+    ci.y1 = c.value("y1", 0);
+    ci.x2 = c.value("x2", 0);
+    ci.y2 = c.value("y2", 0);
+    ci.aConn = c.value("aConn", -1);
+    ci.aConnAux = c.value("aConnAux", -1);
+    if (c.contains("turningPoints") && c["turningPoints"].is_array()) {
+        for (const auto& p : c["turningPoints"]) ci.turningPoints.push_back(wxPoint(p[0], p[1]));
+    }
+    if (c.contains("auxOutputs") && c["auxOutputs"].is_array()) {
+        for (const auto& av : c["auxOutputs"]) {
+            ConnectionInfo::AuxOutput ao;
+            if (av.is_object()) {
+                ao.segIndex = av.value("seg", 0);
+                ao.t = av.value("t", 0.0);
+            }
+            else if (av.is_array() && av.size() == 2) {
+                int px = av[0].get<int>();
+                int py = av[1].get<int>();
+                std::vector<wxPoint> poly;
+                poly.emplace_back(ci.x1, ci.y1);
+                for (const auto& tp : ci.turningPoints) poly.push_back(tp);
+                poly.emplace_back(ci.x2, ci.y2);
+                int seg; double t; wxPoint q;
+                std::tie(seg, t, q) = ProjectPointToPolylineDetailed(wxPoint(px, py), poly);
+                ao.segIndex = seg < 0 ? 0 : seg;
+                ao.t = t;
+            }
+            ci.auxOutputs.push_back(ao);
+        }
+    }
+    return ci;
+}
+
+// 读取 JSON 设计文件（格式与 SaveDesignFile 一致）；流式解析，不构建整份 DOM
+bool LoadDesignFile(const std::string& path, std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections, JournalMark* mark)
+{
+    return ReadDesignJson(path, elements, connections, mark);
+}
+
+// 先写到临时文件再替换，写到一半被取消或失败时原文件保持不变
+bool SaveDesignFile(const std::string& path, const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const JournalMark& mark, const std::atomic<bool>* cancel)
+{
+    auto cancelled = [cancel]() { return cancel && cancel->load(); };
+    const std::string tmp = path + ".tmp";
+    try {
+        json j; j["elements"] = json::array();
+        for (const auto& e : elements) j["elements"].push_back(ElementToJson(e));
+        if (cancelled()) return false;
+        j["connections"] = json::array();
+        for (size_t ci = 0; ci < connections.size(); ++ci) {
+            if ((ci & 4095) == 0 && cancelled()) return false;
+            EnsureConnectionGeometry(elements, connections, ci);
+            j["connections"].push_back(ConnectionToJson(connections[ci], &connections[ci].geom));
+        }
+        if (mark.base != 0) j["journal"] = { { "base", mark.base }, { "seq", mark.seq } };
+        {
+            std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+            if (!ofs.is_open()) return false;
+            ofs << j.dump(4);
+            if (!ofs.good()) { ofs.close(); std::remove(tmp.c_str()); return false; }
+        }
+        if (cancelled()) { std::remove(tmp.c_str()); return false; }
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) { std::remove(tmp.c_str()); return false; }
+        return true;
+    }
+    catch (...) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+}
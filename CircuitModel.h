@@ -0,0 +1,181 @@
+#pragma once
+#include <wx/gdicmn.h>
+#include <vector>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <nlohmann/json_fwd.hpp>
+
+// ---- 电路数据模型 ----
+// 元件/连接结构与几何解析，不依赖窗口；画布与无界面导出共用
+
+// 几何版本号：全局单调递增，元件/连接几何变化时取新值，连接的几何缓存据此判断是否失效
+inline uint64_t NextGeometryStamp()
+{
+    static std::atomic<uint64_t> counter{ 0 };
+    return ++counter;
+}
+
+struct ElementInfo {
+    std::string type;
+    std::string color;
+    int thickness = 1;
+    int x = 0;
+    int y = 0;
+    int size = 1;
+    int rotationIndex = 0;
+    int inputs = 0;
+    int outputs = 0;
+
+    // 位置/尺寸/端点数变化时调用 Touch()，使相关连接的几何缓存失效（不保存到文件）
+    uint64_t geomStamp = NextGeometryStamp();
+    void Touch() { geomStamp = NextGeometryStamp(); }
+};
+
+struct ConnectionInfo {
+    int aIndex = -1;
+    int bIndex = -1;
+    int aPin = -1;
+    int bPin = -1;
+    int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+
+    // 父 connection（若起点来自另一条 connection 的 aux）
+    int aConn = -1;
+    int aConnAux = -1;
+
+    std::vector<wxPoint> turningPoints;
+
+    struct AuxOutput {
+        int segIndex = 0;
+        double t = 0.0;
+    };
+    std::vector<AuxOutput> auxOutputs;
+
+    // 自身路由版本：修改 turningPoints / auxOutputs / 自由端点坐标后调用 Touch()
+    uint64_t routeStamp = NextGeometryStamp();
+    void Touch() { routeStamp = NextGeometryStamp(); }
+
+    // 几何缓存（不保存到文件）：解析后的折线（起点已替换为父连接 aux 点）与各 aux 点像素位置。
+    // 记录生成时两端元件、父连接与自身的版本号，任一变化即重新计算；重算时复用已分配的容量
+    struct GeometryCache {
+        bool valid = false;
+        uint64_t aStamp = 0, bStamp = 0, parentStamp = 0, routeStamp = 0;
+        uint64_t stamp = 0; // 本次缓存的版本号，子连接以此判断父连接几何是否变化
+        std::vector<wxPoint> poly;
+        std::vector<wxPoint> auxPixels;
+    };
+    mutable GeometryCache geom;
+};
+
+// 端点占用索引：记录每个元件每个输入/输出端点被多少条连接使用。
+// 增删连接时增量维护，"端点是否已连接"查询为 O(1)，避免遍历全部连接
+class PinOccupancyIndex
+{
+public:
+    void Rebuild(size_t elementCount, const std::vector<ConnectionInfo>& connections)
+    {
+        m_pins.assign(elementCount, ElementPins());
+        for (const auto& c : connections) Add(c);
+    }
+
+    void Add(const ConnectionInfo& c) { Adjust(c, +1); }
+    void Remove(const ConnectionInfo& c) { Adjust(c, -1); }
+
+    // 删除元件：调用前需先 Remove 掉与之相关的连接；之后的元件索引整体前移，与连接索引的调整一致
+    void EraseElement(int elemIndex)
+    {
+        if (elemIndex >= 0 && elemIndex < (int)m_pins.size()) m_pins.erase(m_pins.begin() + elemIndex);
+    }
+
+    int OutputRefCount(int elemIndex, int pin) const { return Count(elemIndex, pin, true); }
+    int InputRefCount(int elemIndex, int pin) const { return Count(elemIndex, pin, false); }
+    bool IsOutputUsed(int elemIndex, int pin) const { return OutputRefCount(elemIndex, pin) > 0; }
+    bool IsInputUsed(int elemIndex, int pin) const { return InputRefCount(elemIndex, pin) > 0; }
+
+private:
+    struct ElementPins {
+        std::vector<int> in;
+        std::vector<int> out;
+    };
+    std::vector<ElementPins> m_pins;
+
+    void Adjust(const ConnectionInfo& c, int delta)
+    {
+        if (c.aIndex >= 0 && c.aPin >= 0) Bump(c.aIndex, c.aPin, true, delta);
+        if (c.bIndex >= 0 && c.bPin >= 0) Bump(c.bIndex, c.bPin, false, delta);
+    }
+
+    void Bump(int elemIndex, int pin, bool isOutput, int delta)
+    {
+        if ((int)m_pins.size() <= elemIndex) m_pins.resize(elemIndex + 1);
+        std::vector<int>& v = isOutput ? m_pins[elemIndex].out : m_pins[elemIndex].in;
+        if ((int)v.size() <= pin) v.resize(pin + 1, 0);
+        v[pin] = std::max(0, v[pin] + delta);
+    }
+
+    int Count(int elemIndex, int pin, bool isOutput) const
+    {
+        if (elemIndex < 0 || elemIndex >= (int)m_pins.size() || pin < 0) return 0;
+        const std::vector<int>& v = isOutput ? m_pins[elemIndex].out : m_pins[elemIndex].in;
+        return pin < (int)v.size() ? v[pin] : 0;
+    }
+};
+
+// 固定元件（BookShelf 的 terminal 与 /FIXED 节点）以类型标记，随设计文件保存；布局与合法化不移动它们
+bool IsFixedElementType(const std::string& type);
+// GlobalPlace/AnnealPlacement/LegalizePlacement 的 fixed 掩码；没有固定元件时返回空
+std::vector<char> FixedElementMask(const std::vector<ElementInfo>& elements);
+
+// ---- 线网划分 ----
+// 同一输出端点 (aIndex, aPin) 出发的连接，以及沿 aConn 挂在其 aux 上的子连接，构成一个线网；
+// 根连接起点未接元件时以根连接自身为键。布局、布线与 BookShelf 写出共用这一划分
+struct ConnectionNets {
+    std::vector<size_t> netOf;   // 连接 -> 线网编号（按首次出现的顺序编号）
+    std::vector<size_t> root;    // 线网 -> 首个连接的根连接
+    std::vector<int> depth;      // 连接 -> 到根连接的 aux 层数（根连接为 0）
+    size_t Count() const { return root.size(); }
+};
+
+// 沿 aConn 追溯到根连接（最多 64 层，防止成环），返回层数；root 非空时写出根连接下标
+int ConnectionRoot(const std::vector<ConnectionInfo>& connections, size_t ci, size_t* root = nullptr);
+ConnectionNets BuildConnectionNets(size_t elementCount, const std::vector<ConnectionInfo>& connections);
+
+// 元件第 pinIndex 个输出 / 输入端点的坐标
+wxPoint ElementOutputPoint(const ElementInfo& e, int pinIndex = 0);
+wxPoint ElementInputPoint(const ElementInfo& e, int pinIndex);
+
+// 投影点到段，返回 t 与最近点
+std::pair<double, wxPoint> ProjectPointToSegmentT(const wxPoint& a, const wxPoint& b, const wxPoint& p);
+// 投影点到折线，返回 (segIndex, t, 最近点)；pts 少于两个点时 segIndex 为 -1
+std::tuple<int, double, wxPoint> ProjectPointToPolylineDetailed(const wxPoint& p, const std::vector<wxPoint>& pts);
+// aux 点（segIndex, t）在折线上的像素位置，poly 至少包含两个点
+wxPoint PointOnPolyline(const std::vector<wxPoint>& poly, const ConnectionInfo::AuxOutput& ao);
+
+// 确保连接 ci 的几何缓存有效：先确保父连接有效，再比较各版本号，过期时原地重算。
+// 只写 connections[ci]（及其祖先）的 geom，多线程读取前应先在单线程里预热
+void EnsureConnectionGeometry(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections, size_t ci, int depth = 0);
+
+// 设计文件对应的编辑日志位置：文件内容等于编号为 base 的日志前 seq 条记录应用后的状态（base 为 0 表示没有日志）
+struct JournalMark {
+    uint64_t base = 0;
+    uint64_t seq = 0;
+};
+
+// 单个元件/连接与 JSON 对象互转，设计文件与编辑日志共用。geom 非空且有效时端点与 aux 点坐标取自几何缓存
+nlohmann::json ElementToJson(const ElementInfo& e);
+ElementInfo ElementFromJson(const nlohmann::json& j);
+nlohmann::json ConnectionToJson(const ConnectionInfo& c, const ConnectionInfo::GeometryCache* geom = nullptr);
+ConnectionInfo ConnectionFromJson(const nlohmann::json& j);
+
+// 读取 JSON 设计文件追加到 elements/connections；文件打不开返回 false，解析出错时保留已读取的部分。
+// mark 非空时读出文件记录的日志位置（没有则不修改）
+bool LoadDesignFile(const std::string& path, std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    JournalMark* mark = nullptr);
+
+// 写 JSON 设计文件（先写临时文件再替换）。端点与 aux 点坐标按几何缓存写出（会预热 connections 的缓存），
+// 只读 elements/connections，可在后台线程对模型副本调用；cancel 被置位时放弃写入并返回 false
+bool SaveDesignFile(const std::string& path, const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const JournalMark& mark = JournalMark(), const std::atomic<bool>* cancel = nullptr);
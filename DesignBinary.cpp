@@ -0,0 +1,305 @@
+#include "DesignBinary.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cctype>
+
+namespace {
+
+using namespace DesignBinary;
+
+const char kMagic[8] = { 'L', 'G', 'S', 'D', 'E', 'S', 'G', 'N' };
+
+uint64_t Align8(uint64_t v) { return (v + 7) & ~(uint64_t)7; }
+
+bool Fail(std::string* error, const char* msg)
+{
+    if (error) *error = msg;
+    return false;
+}
+
+bool LittleEndianHost()
+{
+    const uint16_t probe = 1;
+    unsigned char b;
+    std::memcpy(&b, &probe, 1);
+    return b == 1;
+}
+
+// 段 [offset, offset + count * size) 在文件内且 8 字节对齐
+bool SectionFits(uint64_t offset, uint64_t count, uint64_t size, uint64_t fileSize)
+{
+    if (offset % 8 != 0 || offset > fileSize) return false;
+    if (count > (fileSize - offset) / size) return false;
+    return true;
+}
+
+// CSR 下标表：从 0 开始、单调不减、末项等于 total
+bool StartsValid(const uint64_t* start, uint64_t count, uint64_t total)
+{
+    if (start[0] != 0 || start[count] != total) return false;
+    for (uint64_t i = 0; i < count; ++i) if (start[i] > start[i + 1]) return false;
+    return true;
+}
+
+class BinaryWriter
+{
+public:
+    explicit BinaryWriter(const std::string& path) : m_file(std::fopen(path.c_str(), "wb")) {}
+    ~BinaryWriter() { if (m_file) std::fclose(m_file); }
+    BinaryWriter(const BinaryWriter&) = delete;
+    BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+    bool IsOpen() const { return m_file != nullptr; }
+    uint64_t Position() const { return m_pos; }
+
+    void Write(const void* data, size_t bytes)
+    {
+        if (bytes == 0) return;
+        if (m_file && std::fwrite(data, 1, bytes, m_file) != bytes) m_ok = false;
+        m_pos += bytes;
+    }
+
+    template <class T>
+    void WriteArray(const std::vector<T>& v) { Write(v.data(), v.size() * sizeof(T)); }
+
+    void PadTo8()
+    {
+        static const char zeros[8] = {};
+        Write(zeros, (size_t)(Align8(m_pos) - m_pos));
+    }
+
+    // 回到文件头重写
+    void Rewrite(const void* data, size_t bytes)
+    {
+        if (!m_file || std::fseek(m_file, 0, SEEK_SET) != 0 || std::fwrite(data, 1, bytes, m_file) != bytes) m_ok = false;
+    }
+
+    bool Close()
+    {
+        if (!m_file) return false;
+        bool ok = m_ok && std::fclose(m_file) == 0;
+        m_file = nullptr;
+        return ok;
+    }
+
+private:
+    std::FILE* m_file;
+    uint64_t m_pos = 0;
+    bool m_ok = true;
+};
+
+} // namespace
+
+namespace DesignBinary {
+
+bool View::Open(const std::string& path, std::string* error)
+{
+    Close();
+    if (!LittleEndianHost()) return Fail(error, "仅支持小端序主机");
+    if (!m_file.Open(path)) return Fail(error, "无法打开文件");
+    const uint64_t size = m_file.Size();
+    if (size < sizeof(Header)) { Close(); return Fail(error, "文件过短"); }
+    const Header* h = reinterpret_cast<const Header*>(m_file.Data());
+    if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0) { Close(); return Fail(error, "不是二进制设计文件"); }
+    if (h->version != Version || h->headerSize != sizeof(Header)) { Close(); return Fail(error, "不支持的版本"); }
+    if (h->fileSize != size) { Close(); return Fail(error, "文件不完整"); }
+    const uint64_t nc = h->connectionCount;
+    if (!SectionFits(h->elementsOffset, h->elementCount, sizeof(ElementRecord), size)
+        || !SectionFits(h->connectionsOffset, nc, sizeof(ConnectionRecord), size)
+        || nc == UINT64_MAX
+        || !SectionFits(h->pointStartOffset, nc + 1, sizeof(uint64_t), size)
+        || !SectionFits(h->pointsOffset, h->pointCount, sizeof(PointRecord), size)
+        || !SectionFits(h->auxStartOffset, nc + 1, sizeof(uint64_t), size)
+        || !SectionFits(h->auxOffset, h->auxCount, sizeof(AuxRecord), size)
+        || h->stringCount == UINT64_MAX
+        || !SectionFits(h->stringStartOffset, h->stringCount + 1, sizeof(uint64_t), size)
+        || h->stringBytesOffset > size || h->stringBytesSize > size - h->stringBytesOffset) {
+        Close();
+        return Fail(error, "段超出文件范围");
+    }
+    m_header = h;
+    if (!StartsValid(PointStart(), nc, h->pointCount) || !StartsValid(AuxStart(), nc, h->auxCount)
+        || !StartsValid(At<uint64_t>(h->stringStartOffset), h->stringCount, h->stringBytesSize)) {
+        Close();
+        return Fail(error, "下标表损坏");
+    }
+    return true;
+}
+
+std::string_view View::String(uint32_t id) const
+{
+    if (id >= m_header->stringCount) return std::string_view();
+    const uint64_t* start = At<uint64_t>(m_header->stringStartOffset);
+    return std::string_view(m_file.Data() + m_header->stringBytesOffset + start[id], (size_t)(start[id + 1] - start[id]));
+}
+
+} // namespace DesignBinary
+
+bool SaveDesignBinary(const std::string& path, const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const JournalMark& mark, const std::atomic<bool>* cancel)
+{
+    auto cancelled = [cancel]() { return cancel && cancel->load(); };
+
+    // 字符串表
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<const std::string*> strings;
+    auto intern = [&](const std::string& s) {
+        auto it = ids.emplace(s, (uint32_t)strings.size());
+        if (it.second) strings.push_back(&it.first->first);
+        return it.first->second;
+    };
+    std::vector<ElementRecord> elems(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) {
+        const ElementInfo& e = elements[i];
+        ElementRecord& r = elems[i];
+        r.x = e.x; r.y = e.y; r.size = e.size; r.rotationIndex = e.rotationIndex;
+        r.inputs = e.inputs; r.outputs = e.outputs; r.thickness = e.thickness;
+        r.type = intern(e.type); r.color = intern(e.color);
+        r.reserved = 0;
+    }
+    if (cancelled()) return false;
+
+    std::vector<ConnectionRecord> conns(connections.size());
+    std::vector<uint64_t> pointStart(connections.size() + 1, 0), auxStart(connections.size() + 1, 0);
+    for (size_t i = 0; i < connections.size(); ++i) {
+        const ConnectionInfo& c = connections[i];
+        conns[i] = ConnectionRecord{ c.aIndex, c.bIndex, c.aPin, c.bPin, c.x1, c.y1, c.x2, c.y2, c.aConn, c.aConnAux };
+        pointStart[i + 1] = pointStart[i] + c.turningPoints.size();
+        auxStart[i + 1] = auxStart[i] + c.auxOutputs.size();
+    }
+    std::vector<uint64_t> stringStart(strings.size() + 1, 0);
+    for (size_t i = 0; i < strings.size(); ++i) stringStart[i + 1] = stringStart[i] + strings[i]->size();
+
+    const std::string tmp = path + ".tmp";
+    BinaryWriter w(tmp);
+    if (!w.IsOpen()) return false;
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = Version;
+    h.headerSize = sizeof(Header);
+    h.journalBase = mark.base;
+    h.journalSeq = mark.seq;
+    h.elementCount = elems.size();
+    h.connectionCount = conns.size();
+    h.pointCount = pointStart.back();
+    h.auxCount = auxStart.back();
+    h.stringCount = strings.size();
+    w.Write(&h, sizeof(h));
+
+    h.elementsOffset = w.Position();
+    w.WriteArray(elems);
+    h.connectionsOffset = w.Position();
+    w.WriteArray(conns);
+    h.pointStartOffset = w.Position();
+    w.WriteArray(pointStart);
+    h.pointsOffset = w.Position();
+    {
+        std::vector<PointRecord> buf;
+        buf.reserve(65536);
+        for (size_t i = 0; i < connections.size(); ++i) {
+            for (const auto& p : connections[i].turningPoints) buf.push_back(PointRecord{ p.x, p.y });
+            if (buf.size() >= 65536) {
+                if (cancelled()) break;
+                w.WriteArray(buf); buf.clear();
+            }
+        }
+        w.WriteArray(buf);
+    }
+    h.auxStartOffset = w.Position();
+    w.WriteArray(auxStart);
+    h.auxOffset = w.Position();
+    {
+        std::vector<AuxRecord> buf;
+        for (const auto& c : connections)
+            for (const auto& ao : c.auxOutputs) buf.push_back(AuxRecord{ ao.t, ao.segIndex, 0 });
+        w.WriteArray(buf);
+    }
+    h.stringStartOffset = w.Position();
+    w.WriteArray(stringStart);
+    h.stringBytesOffset = w.Position();
+    for (const std::string* s : strings) w.Write(s->data(), s->size());
+    h.stringBytesSize = stringStart.back();
+    w.PadTo8();
+    h.fileSize = w.Position();
+    w.Rewrite(&h, sizeof(h));
+
+    if (!w.Close() || cancelled()) { std::remove(tmp.c_str()); return false; }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) { std::remove(tmp.c_str()); return false; }
+    return true;
+}
+
+bool LoadDesignBinary(const std::string& path, std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    JournalMark* mark, std::string* error)
+{
+    View view;
+    if (!view.Open(path, error)) return false;
+
+    // 字符串表先转成 std::string，元件按下标拷贝
+    std::vector<std::string> strings(view.StringCount());
+    for (size_t i = 0; i < strings.size(); ++i) strings[i] = std::string(view.String((uint32_t)i));
+    auto str = [&](uint32_t id) -> const std::string& {
+        static const std::string empty;
+        return id < strings.size() ? strings[id] : empty;
+    };
+
+    const size_t e0 = elements.size();
+    const size_t ne = view.ElementCount();
+    elements.resize(e0 + ne);
+    const ElementRecord* er = view.Elements();
+    for (size_t i = 0; i < ne; ++i) {
+        ElementInfo& e = elements[e0 + i];
+        e.type = str(er[i].type);
+        e.color = str(er[i].color);
+        e.thickness = er[i].thickness;
+        e.x = er[i].x; e.y = er[i].y;
+        e.size = er[i].size;
+        e.rotationIndex = er[i].rotationIndex;
+        e.inputs = er[i].inputs; e.outputs = er[i].outputs;
+    }
+
+    const size_t c0 = connections.size();
+    const size_t nc = view.ConnectionCount();
+    connections.resize(c0 + nc);
+    const ConnectionRecord* cr = view.Connections();
+    const uint64_t* ps = view.PointStart();
+    const PointRecord* pts = view.Points();
+    const uint64_t* as = view.AuxStart();
+    const AuxRecord* aux = view.Aux();
+    for (size_t i = 0; i < nc; ++i) {
+        ConnectionInfo& c = connections[c0 + i];
+        const ConnectionRecord& r = cr[i];
+        c.aIndex = r.aIndex; c.bIndex = r.bIndex; c.aPin = r.aPin; c.bPin = r.bPin;
+        c.x1 = r.x1; c.y1 = r.y1; c.x2 = r.x2; c.y2 = r.y2;
+        c.aConn = r.aConn; c.aConnAux = r.aConnAux;
+        c.turningPoints.resize((size_t)(ps[i + 1] - ps[i]));
+        for (size_t k = 0; k < c.turningPoints.size(); ++k) {
+            const PointRecord& p = pts[ps[i] + k];
+            c.turningPoints[k] = wxPoint(p.x, p.y);
+        }
+        c.auxOutputs.resize((size_t)(as[i + 1] - as[i]));
+        for (size_t k = 0; k < c.auxOutputs.size(); ++k) {
+            const AuxRecord& a = aux[as[i] + k];
+            c.auxOutputs[k].segIndex = a.segIndex;
+            c.auxOutputs[k].t = a.t;
+        }
+    }
+    if (mark) {
+        mark->base = view.Head().journalBase;
+        mark->seq = view.Head().journalSeq;
+    }
+    return true;
+}
+
+bool IsDesignBinaryPath(const std::string& path)
+{
+    if (path.size() < 5) return false;
+    std::string ext = path.substr(path.size() - 5);
+    for (auto& ch : ext) ch = (char)std::tolower((unsigned char)ch);
+    return ext == ".lgdb";
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "CircuitModel.h"
+#include "MappedFile.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// ---- 二进制设计文件（.lgdb）----
+// 版本化的定长记录格式，可直接内存映射读取，无需逐项解析：
+//   Header | ElementRecord[ne] | ConnectionRecord[nc] | pointStart[nc+1] | PointRecord[np]
+//          | auxStart[nc+1] | AuxRecord[na] | stringStart[ns+1] | 字符串字节
+// 连接 i 的转折点为 points[pointStart[i], pointStart[i+1])，aux 点同理；
+// type/color 存为字符串表下标（同名只存一份）。各段按 8 字节对齐，整数为小端序
+
+namespace DesignBinary {
+
+const uint32_t Version = 1;
+
+struct Header {
+    char magic[8];              // "LGSDESGN"
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint64_t journalBase, journalSeq;
+    uint64_t elementCount, connectionCount, pointCount, auxCount, stringCount;
+    uint64_t elementsOffset, connectionsOffset;
+    uint64_t pointStartOffset, pointsOffset;
+    uint64_t auxStartOffset, auxOffset;
+    uint64_t stringStartOffset, stringBytesOffset, stringBytesSize;
+};
+
+struct ElementRecord {
+    int32_t x, y, size, rotationIndex;
+    int32_t inputs, outputs, thickness;
+    uint32_t type, color;       // 字符串表下标
+    uint32_t reserved;
+};
+
+struct ConnectionRecord {
+    int32_t aIndex, bIndex, aPin, bPin;
+    int32_t x1, y1, x2, y2;
+    int32_t aConn, aConnAux;
+};
+
+struct PointRecord {
+    int32_t x, y;
+};
+
+struct AuxRecord {
+    double t;
+    int32_t segIndex;
+    int32_t reserved;
+};
+
+static_assert(sizeof(Header) == 152, "DesignBinary::Header layout");
+static_assert(sizeof(ElementRecord) == 40, "DesignBinary::ElementRecord layout");
+static_assert(sizeof(ConnectionRecord) == 40, "DesignBinary::ConnectionRecord layout");
+static_assert(sizeof(PointRecord) == 8, "DesignBinary::PointRecord layout");
+static_assert(sizeof(AuxRecord) == 16, "DesignBinary::AuxRecord layout");
+
+// 只读视图：映射文件并校验头与各段边界、下标表单调，之后的访问直接指向映射内存
+class View
+{
+public:
+    bool Open(const std::string& path, std::string* error = nullptr);
+    void Close() { m_file.Close(); m_header = nullptr; }
+
+    const Header& Head() const { return *m_header; }
+    size_t ElementCount() const { return (size_t)m_header->elementCount; }
+    size_t ConnectionCount() const { return (size_t)m_header->connectionCount; }
+    const ElementRecord* Elements() const { return At<ElementRecord>(m_header->elementsOffset); }
+    const ConnectionRecord* Connections() const { return At<ConnectionRecord>(m_header->connectionsOffset); }
+    const uint64_t* PointStart() const { return At<uint64_t>(m_header->pointStartOffset); }
+    const PointRecord* Points() const { return At<PointRecord>(m_header->pointsOffset); }
+    const uint64_t* AuxStart() const { return At<uint64_t>(m_header->auxStartOffset); }
+    const AuxRecord* Aux() const { return At<AuxRecord>(m_header->auxOffset); }
+    std::string_view String(uint32_t id) const;
+    size_t StringCount() const { return (size_t)m_header->stringCount; }
+
+private:
+    MappedFile m_file;
+    const Header* m_header = nullptr;
+
+    template <class T>
+    const T* At(uint64_t offset) const { return reinterpret_cast<const T*>(m_file.Data() + offset); }
+};
+
+} // namespace DesignBinary
+
+// 写二进制设计文件（先写临时文件再替换）；只读模型，可在后台线程对副本调用，cancel 被置位时放弃写入
+bool SaveDesignBinary(const std::string& path, const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const JournalMark& mark = JournalMark(), const std::atomic<bool>* cancel = nullptr);
+
+// 读取二进制设计文件追加到 elements/connections（按记录直接拷贝，不解析文本）；格式不符时返回 false 且不修改模型
+bool LoadDesignBinary(const std::string& path, std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    JournalMark* mark = nullptr, std::string* error = nullptr);
+
+// 按扩展名判断是否为二进制设计文件（.lgdb）
+bool IsDesignBinaryPath(const std::string& path);
@@ -0,0 +1,208 @@
+#include "DesignJournal.h"
+#include "ParallelFor.h"
+#include <nlohmann/json.hpp>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+using json = nlohmann::json;
+
+namespace {
+
+// 单次编辑变化的记录数超过此值且超过模型的四分之一时，不写日志而改为整体保存
+const size_t kMaxJournalRecords = 4096;
+const size_t kScanBlock = 65536;
+
+// [0, count) 中 changed(i) 为真的下标，按升序
+template <class Pred>
+std::vector<size_t> ChangedIndices(size_t count, Pred&& changed, std::unique_ptr<WorkerPool>& pool)
+{
+    const size_t blocks = (count + kScanBlock - 1) / kScanBlock;
+    std::vector<std::vector<size_t>> found(blocks);
+    if (blocks > 1 && !pool) pool.reset(new WorkerPool());
+    auto scan = [&](size_t b) {
+        const size_t end = std::min(count, (b + 1) * kScanBlock);
+        for (size_t i = b * kScanBlock; i < end; ++i) if (changed(i)) found[b].push_back(i);
+    };
+    if (blocks > 1) pool->For(blocks, scan);
+    else if (blocks == 1) scan(0);
+    std::vector<size_t> out;
+    for (const auto& f : found) out.insert(out.end(), f.begin(), f.end());
+    return out;
+}
+
+// hint 中仍在范围内的下标加上 [oldCount, count) 的新增下标，只保留 changed(i) 为真的，按升序
+template <class Pred>
+std::vector<size_t> HintedIndices(const std::vector<size_t>& hint, size_t oldCount, size_t count, Pred&& changed)
+{
+    std::vector<size_t> out;
+    for (size_t i : hint) if (i < std::min(oldCount, count) && changed(i)) out.push_back(i);
+    for (size_t i = oldCount; i < count; ++i) if (changed(i)) out.push_back(i);
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+} // namespace
+
+DesignJournal::DesignJournal() = default;
+DesignJournal::~DesignJournal() { Close(); }
+
+bool DesignJournal::Resume(const std::string& path, const JournalMark& mark, uint64_t validBytes)
+{
+    Close();
+    if (validBytes == 0) return false;
+    std::error_code ec;
+    std::filesystem::resize_file(path, validBytes, ec);
+    if (ec) return false;
+    m_file = std::fopen(path.c_str(), "r+b");
+    if (!m_file) return false;
+    // 有效部分的最后一行可能缺少换行（写到换行前中断），补上后再追加
+    bool needNewline = std::fseek(m_file, -1, SEEK_END) == 0 && std::fgetc(m_file) != '\n';
+    if (std::fseek(m_file, 0, SEEK_END) != 0 || (needNewline && std::fputc('\n', m_file) == EOF) || std::fflush(m_file) != 0) {
+        Close();
+        return false;
+    }
+    m_base = mark.base;
+    m_seq = mark.seq;
+    return true;
+}
+
+bool DesignJournal::Restart(const std::string& path, const JournalMark& mark)
+{
+    Close();
+    m_base = mark.base;
+    m_seq = mark.seq;
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) return false;
+    json header; header["base"] = m_base;
+    const std::string line = header.dump() + "\n";
+    if (std::fwrite(line.data(), 1, line.size(), m_file) != line.size() || std::fflush(m_file) != 0) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void DesignJournal::Capture(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections)
+{
+    m_elemStamps.resize(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) m_elemStamps[i] = elements[i].geomStamp;
+    m_connKeys.resize(connections.size());
+    for (size_t i = 0; i < connections.size(); ++i) m_connKeys[i] = KeyOf(connections[i]);
+    m_elemData = elements.data();
+    m_connData = connections.data();
+}
+
+DesignJournal::AppendResult DesignJournal::Append(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const JournalHint* hint)
+{
+    auto elemChanged = [&](size_t i) { return i >= m_elemStamps.size() || m_elemStamps[i] != elements[i].geomStamp; };
+    auto connChanged = [&](size_t i) { return i >= m_connKeys.size() || !(m_connKeys[i] == KeyOf(connections[i])); };
+    // 容器只在末尾增长、未重新分配时 hint 可信，只比较给出的与新增的下标
+    const bool useHint = hint && elements.data() == m_elemData && connections.data() == m_connData
+        && elements.size() >= m_elemStamps.size() && connections.size() >= m_connKeys.size();
+    std::vector<size_t> changedElems, changedConns;
+    if (useHint) {
+        changedElems = HintedIndices(hint->elements, m_elemStamps.size(), elements.size(), elemChanged);
+        changedConns = HintedIndices(hint->connections, m_connKeys.size(), connections.size(), connChanged);
+    }
+    else {
+        // 逐项比较版本号是按步长扫过整个模型的内存访问，大模型时分块并行
+        changedElems = ChangedIndices(elements.size(), elemChanged, m_pool);
+        changedConns = ChangedIndices(connections.size(), connChanged, m_pool);
+    }
+    if (changedElems.empty() && changedConns.empty()
+        && elements.size() == m_elemStamps.size() && connections.size() == m_connKeys.size()) {
+        m_elemData = elements.data();
+        m_connData = connections.data();
+        return AppendResult::Unchanged;
+    }
+
+    const size_t records = changedElems.size() + changedConns.size();
+    if (records > kMaxJournalRecords && records > (elements.size() + connections.size()) / 4) return AppendResult::TooLarge;
+    if (!m_file) return AppendResult::Failed;
+
+    json entry;
+    entry["seq"] = m_seq + 1;
+    entry["ne"] = elements.size();
+    entry["nc"] = connections.size();
+    entry["e"] = json::array();
+    for (size_t i : changedElems) entry["e"].push_back({ i, ElementToJson(elements[i]) });
+    entry["c"] = json::array();
+    for (size_t i : changedConns) entry["c"].push_back({ i, ConnectionToJson(connections[i]) });
+    const std::string line = entry.dump() + "\n";
+    if (std::fwrite(line.data(), 1, line.size(), m_file) != line.size() || std::fflush(m_file) != 0) return AppendResult::Failed;
+
+    ++m_seq;
+    // 只更新变化的部分，不重新复制整个比较基准
+    m_elemStamps.resize(elements.size());
+    for (size_t i : changedElems) m_elemStamps[i] = elements[i].geomStamp;
+    m_connKeys.resize(connections.size());
+    for (size_t i : changedConns) m_connKeys[i] = KeyOf(connections[i]);
+    m_elemData = elements.data();
+    m_connData = connections.data();
+    return AppendResult::Appended;
+}
+
+void DesignJournal::Close()
+{
+    if (m_file) std::fclose(m_file);
+    m_file = nullptr;
+}
+
+uint64_t DesignJournal::NewBase()
+{
+    std::random_device rd;
+    uint64_t t = (uint64_t)std::chrono::system_clock::now().time_since_epoch().count();
+    uint64_t r = ((uint64_t)rd() << 32) ^ rd() ^ (t * 0x9E3779B97F4A7C15ull);
+    return r == 0 ? 1 : r;
+}
+
+uint64_t ReplayDesignJournal(const std::string& path, const JournalMark& mark,
+    std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections, uint64_t* validBytes)
+{
+    uint64_t last = mark.seq;
+    if (validBytes) *validBytes = 0;
+    if (mark.base == 0) return last;
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) return last;
+    std::string line;
+    if (!std::getline(ifs, line)) return last;
+    try {
+        json header = json::parse(line);
+        if (header.value("base", (uint64_t)0) != mark.base) return last;
+    }
+    catch (...) { return last; }
+    // 末行没有换行时 getline 读到文件尾，不计换行
+    uint64_t offset = line.size() + (ifs.eof() ? 0 : 1);
+    if (validBytes) *validBytes = offset;
+
+    // 逐行解析；解析失败（崩溃时写到一半的末行）或序号不连续即停止
+    while (std::getline(ifs, line)) {
+        json entry;
+        try { entry = json::parse(line); }
+        catch (...) { break; }
+        const uint64_t seq = entry.value("seq", (uint64_t)0);
+        offset += line.size() + (ifs.eof() ? 0 : 1);
+        if (seq <= last) { if (validBytes) *validBytes = offset; continue; }
+        if (seq != last + 1) break;
+        elements.resize(entry.value("ne", elements.size()));
+        connections.resize(entry.value("nc", connections.size()));
+        try {
+            for (const auto& rec : entry["e"]) {
+                size_t i = rec[0].get<size_t>();
+                if (i < elements.size()) elements[i] = ElementFromJson(rec[1]);
+            }
+            for (const auto& rec : entry["c"]) {
+                size_t i = rec[0].get<size_t>();
+                if (i < connections.size()) connections[i] = ConnectionFromJson(rec[1]);
+            }
+        }
+        catch (...) { break; }
+        last = seq;
+        if (validBytes) *validBytes = offset;
+    }
+    return last;
+}
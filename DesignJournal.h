@@ -0,0 +1,85 @@
+#pragma once
+#include "CircuitModel.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+
+class WorkerPool;
+
+// ---- 编辑日志 ----
+// 追加式日志，首行为 {"base": 编号}，之后每次编辑一行：
+//   {"seq": n, "ne": 元件数, "nc": 连接数, "e": [[下标, 元件], ...], "c": [[下标, 连接], ...]}
+// 只记录与上一条相比变化的元件/连接：元件以几何版本号判断，连接以路由版本号和端点/父连接下标判断，
+// 调用方给出本次改动的下标（JournalHint）时只比较这些下标，一次编辑的代价只与改动量有关；
+// 不给出时逐项比较整个模型的版本号（大模型分块在常驻线程池上并行）。
+// 设计文件记录自己对应的 (base, seq)；启动时只重放同一 base 下 seq 更大的完整行，写到一半的末行被忽略
+// 一次编辑改动（Touch）过的元件/连接下标；末尾新增的下标不必列出
+struct JournalHint {
+    std::vector<size_t> elements;
+    std::vector<size_t> connections;
+};
+
+class DesignJournal
+{
+public:
+    enum class AppendResult { Unchanged, Appended, TooLarge, Failed };
+
+    DesignJournal();
+    ~DesignJournal();
+    DesignJournal(const DesignJournal&) = delete;
+    DesignJournal& operator=(const DesignJournal&) = delete;
+
+    // 以 mark 为起点重新开始：截断日志文件并写入 base 头；不改变比较基准
+    bool Restart(const std::string& path, const JournalMark& mark);
+    // 接着已有日志继续追加（不截断已有记录）：文件截到 validBytes（ReplayDesignJournal 给出的完整记录末尾），
+    // 之后的记录从 mark.seq + 1 编号。失败时返回 false，日志保持关闭
+    bool Resume(const std::string& path, const JournalMark& mark, uint64_t validBytes);
+    // 把当前模型记为比较基准（之后的 Append 只写相对它的变化）
+    void Capture(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections);
+    // 写入相对比较基准的变化并更新基准。变化的记录过多（如导入或整体布局）时不写入，返回 TooLarge，
+    // 调用方应换用新的 base 重新开始并尽快写出完整的设计文件。
+    // hint 须包含自上次记录以来改动过的全部下标；模型容器在此期间被整体替换或重新分配（撤销、导入、删除）时
+    // hint 不可信，自动改为整体比较
+    AppendResult Append(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+        const JournalHint* hint = nullptr);
+    void Close();
+
+    bool IsOpen() const { return m_file != nullptr; }
+    JournalMark Mark() const { return JournalMark{ m_base, m_seq }; }
+
+    // 新的非零日志编号
+    static uint64_t NewBase();
+
+private:
+    struct ConnKey {
+        uint64_t routeStamp;
+        int aIndex, bIndex, aPin, bPin, aConn, aConnAux;
+        bool operator==(const ConnKey& o) const
+        {
+            return routeStamp == o.routeStamp && aIndex == o.aIndex && bIndex == o.bIndex && aPin == o.aPin
+                && bPin == o.bPin && aConn == o.aConn && aConnAux == o.aConnAux;
+        }
+    };
+    static ConnKey KeyOf(const ConnectionInfo& c)
+    {
+        return ConnKey{ c.routeStamp, c.aIndex, c.bIndex, c.aPin, c.bPin, c.aConn, c.aConnAux };
+    }
+
+    std::FILE* m_file = nullptr;
+    uint64_t m_base = 0;
+    uint64_t m_seq = 0;
+    std::vector<uint64_t> m_elemStamps;
+    std::vector<ConnKey> m_connKeys;
+    // 比较基准对应的容器地址：与之不同说明容器被替换或重新分配过，此时不使用 hint
+    const ElementInfo* m_elemData = nullptr;
+    const ConnectionInfo* m_connData = nullptr;
+    std::unique_ptr<WorkerPool> m_pool;  // 整体比较大模型时使用，首次需要时创建
+};
+
+// 把 path 中编号为 mark.base、seq 大于 mark.seq 的完整记录依次应用到模型；
+// 返回最后应用的 seq（没有可应用的记录时为 mark.seq）。validBytes 非空时写入文件中有效部分
+// （base 头与已应用的记录）的字节数，日志无效时为 0，供 DesignJournal::Resume 截掉之后写坏的部分
+uint64_t ReplayDesignJournal(const std::string& path, const JournalMark& mark,
+    std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections, uint64_t* validBytes = nullptr);
@@ -2,6 +2,7 @@
 #include <wx/pen.h>
 #include <wx/brush.h>
 #include <wx/font.h>
+#include <wx/dcmemory.h>
 #include <cmath>
 
 // 使用 Header 中的 BaseElemWidth/BaseElemHeight
@@ -287,3 +288,103 @@ int Signals(const std::vector<int>& inputs, const std::string& type) {
         return (ones % 2 == 1) ? 1 : 0;
     }
 }
+
+LodTier SelectLodTier(double zoom)
+{
+    if (zoom >= LodSimplifiedZoom) return LodTier::Full;
+    if (zoom >= LodDensityZoom) return LodTier::Simplified;
+    return LodTier::Density;
+}
+
+void DrawElementBox(wxDC& dc, int x, int y, int size)
+{
+    if (size < 1) size = 1;
+    dc.DrawRectangle(x, y, BaseElemWidth * size, BaseElemHeight * size);
+}
+
+// 点 p 到线段 ab 的距离平方
+static double PointSegmentDistSq(const wxPoint& p, const wxPoint& a, const wxPoint& b)
+{
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double len2 = dx * dx + dy * dy;
+    double t = 0.0;
+    if (len2 > 0.0) {
+        t = ((p.x - a.x) * dx + (p.y - a.y) * dy) / len2;
+        if (t < 0.0) t = 0.0;
+        if (t > 1.0) t = 1.0;
+    }
+    double qx = a.x + t * dx - p.x;
+    double qy = a.y + t * dy - p.y;
+    return qx * qx + qy * qy;
+}
+
+std::vector<wxPoint> SimplifyPolylineForLod(const std::vector<wxPoint>& pts, double tolerance)
+{
+    if (pts.size() <= 2) return pts;
+    double tol2 = tolerance * tolerance;
+    std::vector<wxPoint> out;
+    out.reserve(pts.size());
+    out.push_back(pts.front());
+    for (size_t i = 1; i + 1 < pts.size(); ++i) {
+        // 以最后保留的点为起点判断，保证连续多个小折段也能被合并
+        if (PointSegmentDistSq(pts[i], out.back(), pts[i + 1]) > tol2) out.push_back(pts[i]);
+    }
+    out.push_back(pts.back());
+    return out;
+}
+
+// 精灵背景使用接近白色的遮罩色：文字抗锯齿边缘与其混合后仍接近白色，贴到白色画布上不会出现色边
+static const wxColour SpriteMaskColour(254, 254, 254);
+
+const ElementSpriteCache::Sprite& ElementSpriteCache::Get(const std::string& type, const std::string& color, int thickness, int size, double zoom)
+{
+    if (zoom != m_zoom) { m_sprites.clear(); m_zoom = zoom; }
+    if (size < 1) size = 1;
+
+    m_keyBuf.assign(type);
+    m_keyBuf.push_back('\x1f');
+    m_keyBuf.append(color);
+    m_keyBuf.push_back('\x1f');
+    m_keyBuf.append(reinterpret_cast<const char*>(&thickness), sizeof(thickness));
+    m_keyBuf.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    auto it = m_sprites.find(m_keyBuf);
+    if (it != m_sprites.end()) return it->second;
+
+    int w = BaseElemWidth * size;
+    int h = BaseElemHeight * size;
+
+    // 测量文字，确定精灵需要在元件外框之外预留的边距（与 DrawElement 的字体一致）
+    wxBitmap probeBmp(1, 1);
+    wxMemoryDC probe(probeBmp);
+    int fontSize = std::max(8, 12 * size);
+    probe.SetFont(wxFont(fontSize, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD));
+    wxSize textSize = probe.GetTextExtent(wxString(type));
+    probe.SelectObject(wxNullBitmap);
+
+    int pad = std::max(1, thickness) + 2;
+    Sprite sp;
+    sp.originX = pad + std::max(0, (textSize.GetWidth() - w) / 2 + 1);
+    sp.originY = pad + std::max(0, (textSize.GetHeight() - h) / 2 + 1);
+    int logicalW = w + 2 * sp.originX;
+    int logicalH = h + 2 * sp.originY;
+
+    wxBitmap bmp(std::max(1, (int)std::ceil(logicalW * zoom)), std::max(1, (int)std::ceil(logicalH * zoom)));
+    {
+        wxMemoryDC mdc(bmp);
+        mdc.SetBackground(wxBrush(SpriteMaskColour));
+        mdc.Clear();
+        mdc.SetUserScale(zoom, zoom);
+        DrawElement(mdc, type, color, thickness, sp.originX, sp.originY, size);
+        mdc.SelectObject(wxNullBitmap);
+    }
+    bmp.SetMask(new wxMask(bmp, SpriteMaskColour));
+    sp.bitmap = bmp;
+    return m_sprites.emplace(m_keyBuf, std::move(sp)).first->second;
+}
+
+void ElementSpriteCache::Draw(wxDC& dc, const std::string& type, const std::string& color, int thickness, int size, double zoom, int devX, int devY)
+{
+    const Sprite& sp = Get(type, color, thickness, size, zoom);
+    dc.DrawBitmap(sp.bitmap, devX - (int)std::lround(sp.originX * zoom), devY - (int)std::lround(sp.originY * zoom), true);
+}
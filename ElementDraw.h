@@ -1,9 +1,11 @@
 #pragma once
 #include <wx/dc.h>
 #include <wx/colour.h>
+#include <wx/bitmap.h>
 #include <nlohmann/json.hpp>
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 
 // 基础参考尺寸（Canvas 与这里保持一致）
@@ -21,3 +23,48 @@ std::vector<wxPoint> GetElementPins(const nlohmann::json& el);
 void DrawElementPins(wxDC& dc, const std::string& type, int x, int y, int size, int inputs, const wxColour& pinColor);
 
 int Signals(const std::vector<int>& inputs,const std::string& type);
+
+// 细节层级（LOD）：视图缩小时逐级简化绘制
+enum class LodTier {
+    Full,        // 完整绘制：图形、文字、端点、aux 点
+    Simplified,  // 简化：只画外框，不画文字/端点，连线合并近似共线的折段
+    Density      // 远景：按屏幕格子聚合元件密度，以栅格图显示
+};
+
+// 缩放阈值：zoom >= LodSimplifiedZoom 为 Full，>= LodDensityZoom 为 Simplified，否则 Density
+constexpr double LodSimplifiedZoom = 0.5;
+constexpr double LodDensityZoom = 0.15;
+// 简化连线时允许的屏幕偏差（像素）
+constexpr double LodWirePixelTolerance = 1.5;
+
+LodTier SelectLodTier(double zoom);
+
+// 简化层级下的元件外框（不画文字与内部图形，画笔由调用方设置）
+void DrawElementBox(wxDC& dc, int x, int y, int size = 1);
+
+// 合并近似共线的折段：中间点到前后连线的距离不超过 tolerance（世界坐标）则丢弃
+std::vector<wxPoint> SimplifyPolylineForLod(const std::vector<wxPoint>& pts, double tolerance);
+
+// 元件精灵缓存：每种外观（类型/尺寸/颜色/线宽/缩放）只用 DrawElement 渲染一次到带遮罩的位图，之后直接贴图，
+// 避免每个元件每帧重新构造 wxPen/wxFont/wxColour 并测量文字
+class ElementSpriteCache {
+public:
+    // 在设备坐标绘制元件，(devX, devY) 为元件左上角 (x, y) 在屏幕上的位置
+    void Draw(wxDC& dc, const std::string& type, const std::string& color, int thickness, int size, double zoom, int devX, int devY);
+
+    // 缩放或主题变化时清空（Draw 发现缩放改变时也会自动清空）
+    void Invalidate() { m_sprites.clear(); }
+    size_t Count() const { return m_sprites.size(); }
+
+private:
+    struct Sprite {
+        wxBitmap bitmap;
+        int originX = 0; // 元件左上角在精灵内的逻辑坐标（文字可能超出元件外框）
+        int originY = 0;
+    };
+    const Sprite& Get(const std::string& type, const std::string& color, int thickness, int size, double zoom);
+
+    std::unordered_map<std::string, Sprite> m_sprites;
+    std::string m_keyBuf; // 复用的查找键缓冲区，查找时不分配内存
+    double m_zoom = 0.0;
+};
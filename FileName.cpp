@@ -10,17 +10,34 @@
 #include <wx/panel.h>
 #include <wx/spinctrl.h>
 #include "ElementDraw.h"
+#include "CircuitModel.h"
+#include "SchematicExport.h"
+#include "PerfStats.h"
+#include "BackgroundWorker.h"
+#include "ObstacleMap.h"
+#include "Autorouter.h"
+#include "Placer.h"
+#include "BookShelf.h"
+#include "DesignJournal.h"
+#include "DesignBinary.h"
+#include "JsonStreamReader.h"
+#include "ParallelFor.h"
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <algorithm>
 #include <map>
-#include <iomanip>
 #include <cmath>
 #include <queue>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <functional>
 #include <cstdint>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <filesystem>
 using json = nlohmann::json;
 
 // ---- 全局 ID ----
@@ -32,15 +49,28 @@ enum
     ID_EDIT_DELETE,
     ID_EDIT_SELECTALL,
     ID_PROJECT_ADD_CIRCUIT,
+    ID_PROJECT_AUTOROUTE,
+    ID_PROJECT_REROUTE_ALL,
+    ID_PROJECT_REROUTE_VIEW,
+    ID_PROJECT_PLACE_ALL,
+    ID_PROJECT_ANNEAL,
+    ID_PROJECT_CANCEL_PLACE,
+    ID_PROJECT_LEGALIZE,
     ID_SIM_ENABLE,
     ID_SIM_RESET,
     ID_WINDOW_CASCADE,
+    ID_WINDOW_PERF_HUD,
+    ID_WINDOW_MINIMAP,
     ID_HELP_ABOUT,
     ID_FILE_NEW,
     ID_FILE_OPEN,
     ID_FILE_OPENRECENT,
+    ID_FILE_IMPORT_BOOKSHELF,
     ID_FILE_CLOSE,
     ID_FILE_SAVE,
+    ID_FILE_EXPORT_IMAGE,
+    ID_TIMER_PERF,
+    ID_TIMER_AUTOSAVE,
 };
 
 enum ToolID {
@@ -57,41 +87,9 @@ enum ToolID {
     ID_TOOL_EDITVIEW
 };
 
-// ---- 数据结构 ----
-struct ElementInfo {
-    std::string type;
-    std::string color;
-    int thickness = 1;
-    int x = 0;
-    int y = 0;
-    int size = 1;
-    int rotationIndex = 0;
-    int inputs = 0;
-    int outputs = 0;
-};
-
-struct ConnectionInfo {
-    int aIndex = -1;
-    int bIndex = -1;
-    int aPin = -1;
-    int bPin = -1;
-    int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
-
-    // 父 connection（若起点来自另一条 connection 的 aux）
-    int aConn = -1;
-    int aConnAux = -1;
-
-    std::vector<wxPoint> turningPoints;
-
-    struct AuxOutput {
-        int segIndex = 0;
-        double t = 0.0;
-    };
-    std::vector<AuxOutput> auxOutputs;
-};
-
 // 前向声明（PropertyPanel 需要引用 CanvasPanel）
 class CanvasPanel;
+class MinimapPanel;
 
 class MyApp : public wxApp
 {
@@ -112,6 +110,13 @@ private:
     void OnCut(wxCommandEvent& event);
     void OnCopy(wxCommandEvent& event);
     void OnAddCircuit(wxCommandEvent& event);
+    void OnAutorouteAll(wxCommandEvent& event);
+    void OnRerouteAll(wxCommandEvent& event);
+    void OnRerouteView(wxCommandEvent& event);
+    void OnPlaceAll(wxCommandEvent& event);
+    void OnAnnealPlacement(wxCommandEvent& event);
+    void OnCancelPlacement(wxCommandEvent& event);
+    void OnLegalizePlacement(wxCommandEvent& event);
     void OnSimEnable(wxCommandEvent& event);
     void OnWindowCascade(wxCommandEvent& event);
     void OnHelp(wxCommandEvent& event);
@@ -125,10 +130,18 @@ private:
     // 导入/导出网表
     void OnExportNetlist(wxCommandEvent& event);
     void OnImportNetlist(wxCommandEvent& event);
+    void OnImportBookShelf(wxCommandEvent& event);
+    // 导出图片（PNG/SVG）
+    void OnExportImage(wxCommandEvent& event);
+    // 性能 HUD 开关
+    void OnWindowPerfHud(wxCommandEvent& event);
+    // 缩略图显示/隐藏
+    void OnWindowMinimap(wxCommandEvent& event);
 
     std::string m_currentPlacementType;
     // 保存对画布的引用以便触发导入/导出 / 检查未保存状态
     CanvasPanel* m_canvas = nullptr;
+    MinimapPanel* m_minimap = nullptr;
 };
 
 //资源管理器
@@ -197,36 +210,6 @@ private:
 
 
 // ---- 几何 / 路由 帮助函数 ----
-static int orient(const wxPoint& a, const wxPoint& b, const wxPoint& c) {
-    long long v = (long long)(b.y - a.y) * (c.x - b.x) - (long long)(b.x - a.x) * (c.y - b.y);
-    if (v == 0) return 0;
-    return v > 0 ? 1 : 2;
-}
-static bool onSegment(const wxPoint& a, const wxPoint& b, const wxPoint& p) {
-    return p.x >= std::min(a.x, b.x) && p.x <= std::max(a.x, b.x)
-        && p.y >= std::min(a.y, b.y) && p.y <= std::max(a.y, b.y);
-}
-static bool LineSegmentsIntersect(const wxPoint& p1, const wxPoint& p2, const wxPoint& q1, const wxPoint& q2) {
-    int o1 = orient(p1, p2, q1);
-    int o2 = orient(p1, p2, q2);
-    int o3 = orient(q1, q2, p1);
-    int o4 = orient(q1, q2, p2);
-
-    if (o1 != o2 && o3 != o4) return true;
-    if (o1 == 0 && onSegment(p1, p2, q1)) return true;
-    if (o2 == 0 && onSegment(p1, p2, q2)) return true;
-    if (o3 == 0 && onSegment(q1, q2, p1)) return true;
-    if (o4 == 0 && onSegment(q1, q2, p2)) return true;
-    return false;
-}
-
-// pair hash helper
-struct PairHash {
-    size_t operator()(const std::pair<int, int>& p) const noexcept {
-        return ((uint64_t)(uint32_t)p.first << 32) ^ (uint32_t)p.second;
-    }
-};
-
 // A* 网格与路径简化
 static std::vector<wxPoint> SimplifyGridPathToTurningPoints(const std::vector<std::pair<int, int>>& nodes, int gridSize)
 {
@@ -249,123 +232,306 @@ static std::vector<wxPoint> SimplifyGridPathToTurningPoints(const std::vector<st
     return pts;
 }
 
-static std::vector<std::pair<int, int>> AStarGridPath(
-    const std::pair<int, int>& startNode,
-    const std::pair<int, int>& goalNode,
-    int gxMin, int gxMax, int gyMin, int gyMax,
-    const std::unordered_set<std::pair<int, int>, PairHash>& blocked)
+// ---- 网格 A* ----
+// 边权恒为 1、启发为曼哈顿距离（一致启发），f 只取整数且出队顺序单调不减，
+// 因此用桶队列代替二叉堆；g 值与来向放在按窗口内网格下标的稠密数组中，
+// 以代数戳区分本次搜索写入的数据，数组无需清零，并在同一线程的多次搜索间复用。
+// 障碍由调用方的 blocked(gx, gy) 按需查询（见 ObstacleMap::Probe），终点格子总是可走
+class GridAStar
 {
-    struct Node {
-        int f, g;
-        int x, y;
-        bool operator<(Node const& o) const { return f > o.f; }
-    };
+public:
+    // 设定本次搜索的网格范围（含端点），并使上次搜索的数据全部失效
+    void Reset(int gxMin, int gxMax, int gyMin, int gyMax)
+    {
+        m_gxMin = gxMin; m_gyMin = gyMin;
+        m_w = std::max(1, gxMax - gxMin + 1);
+        m_h = std::max(1, gyMax - gyMin + 1);
+        size_t n = (size_t)m_w * (size_t)m_h;
+        if (m_visited.size() < n) {
+            m_visited.resize(n, 0);
+            m_g.resize(n);
+            m_from.resize(n);
+        }
+        if (++m_gen == 0) {
+            // 代数戳回绕：真正清零一次
+            std::fill(m_visited.begin(), m_visited.end(), 0);
+            m_gen = 1;
+        }
+    }
 
-    auto heuristic = [](const std::pair<int, int>& a, const std::pair<int, int>& b)->int {
-        return std::abs(a.first - b.first) + std::abs(a.second - b.second);
-        };
+    bool InRange(int gx, int gy) const
+    {
+        return gx >= m_gxMin && gx < m_gxMin + m_w && gy >= m_gyMin && gy < m_gyMin + m_h;
+    }
 
-    std::priority_queue<Node> open;
-    std::unordered_map<std::pair<int, int>, int, PairHash> gScore;
-    std::unordered_map<std::pair<int, int>, std::pair<int, int>, PairHash> cameFrom;
-    gScore[startNode] = 0;
-    open.push({ heuristic(startNode, goalNode), 0, startNode.first, startNode.second });
-
-    const int dirs[4][2] = { {1,0},{-1,0},{0,1},{0,-1} };
-
-    while (!open.empty()) {
-        Node cur = open.top(); open.pop();
-        std::pair<int, int> curP{ cur.x, cur.y };
-        if (curP == goalNode) {
-            std::vector<std::pair<int, int>> path;
-            std::pair<int, int> p = goalNode;
-            while (!(p == startNode)) {
-                path.push_back(p);
-                p = cameFrom[p];
+    // 返回从 start 到 goal 的网格节点序列（含两端）；不可达或被取消时返回空
+    template<class Blocked>
+    std::vector<std::pair<int, int>> Search(const std::pair<int, int>& start, const std::pair<int, int>& goal,
+        const Blocked& blocked, const std::atomic<bool>* cancel = nullptr)
+    {
+        if (!InRange(start.first, start.second) || !InRange(goal.first, goal.second)) return {};
+        for (auto& b : m_buckets) b.clear();
+
+        auto heuristic = [&](int x, int y)->int { return std::abs(x - goal.first) + std::abs(y - goal.second); };
+        const int fBase = heuristic(start.first, start.second);
+        const int s = Index(start.first, start.second);
+        const int t = Index(goal.first, goal.second);
+        m_visited[s] = m_gen; m_g[s] = 0; m_from[s] = NoDir;
+        Push(0, s);
+
+        const int dirs[4][2] = { {1,0},{-1,0},{0,1},{0,-1} };
+        size_t expanded = 0;
+        for (size_t b = 0; b < m_buckets.size(); ++b) {
+            while (!m_buckets[b].empty()) {
+                // 后台路由：定期检查取消标志
+                if (cancel && (++expanded & 1023) == 0 && cancel->load(std::memory_order_relaxed)) return {};
+                int cur = m_buckets[b].back(); m_buckets[b].pop_back();
+                int cx = cur % m_w + m_gxMin, cy = cur / m_w + m_gyMin;
+                int g = m_g[cur];
+                if (g + heuristic(cx, cy) - fBase != (int)b) continue; // 已被更优的 g 取代
+                if (cur == t) return Reconstruct(s, t);
+                for (int d = 0; d < 4; ++d) {
+                    int nx = cx + dirs[d][0], ny = cy + dirs[d][1];
+                    if (!InRange(nx, ny)) continue;
+                    int ni = Index(nx, ny);
+                    if (ni != t && blocked(nx, ny)) continue;
+                    int ng = g + 1;
+                    if (m_visited[ni] != m_gen || ng < m_g[ni]) {
+                        m_visited[ni] = m_gen; m_g[ni] = ng; m_from[ni] = (uint8_t)d;
+                        Push((size_t)(ng + heuristic(nx, ny) - fBase), ni);
+                    }
+                }
             }
-            path.push_back(startNode);
-            std::reverse(path.begin(), path.end());
-            return path;
         }
-        if (gScore.find(curP) != gScore.end() && cur.g != gScore[curP]) continue;
+        return {};
+    }
 
-        for (auto& d : dirs) {
-            int nx = cur.x + d[0];
-            int ny = cur.y + d[1];
-            if (nx < gxMin || nx > gxMax || ny < gyMin || ny > gyMax) continue;
-            std::pair<int, int> np{ nx,ny };
-            if (blocked.find(np) != blocked.end()) continue;
-            int ng = cur.g + 1;
-            auto it = gScore.find(np);
-            if (it == gScore.end() || ng < it->second) {
-                gScore[np] = ng;
-                int f = ng + heuristic(np, goalNode);
-                cameFrom[np] = curP;
-                open.push({ f, ng, nx, ny });
-            }
+    // 每个线程一份（界面线程与后台路由线程互不干扰）
+    static GridAStar& ForThread()
+    {
+        thread_local GridAStar instance;
+        return instance;
+    }
+
+private:
+    static const uint8_t NoDir = 0xFF;
+    int m_gxMin = 0, m_gyMin = 0, m_w = 1, m_h = 1;
+    uint32_t m_gen = 0;
+    std::vector<uint32_t> m_visited;   // == m_gen 表示本次搜索已写入 g/from
+    std::vector<int> m_g;
+    std::vector<uint8_t> m_from;       // 到达该格时走的方向（dirs 下标）
+    std::vector<std::vector<int>> m_buckets; // 下标为 f - f(start)
+
+    int Index(int gx, int gy) const { return (gy - m_gyMin) * m_w + (gx - m_gxMin); }
+
+    void Push(size_t bucket, int idx)
+    {
+        if (bucket >= m_buckets.size()) m_buckets.resize(bucket + 1);
+        m_buckets[bucket].push_back(idx);
+    }
+
+    std::vector<std::pair<int, int>> Reconstruct(int s, int t) const
+    {
+        static const int back[4] = { -1, 1, 0, 0 };
+        std::vector<std::pair<int, int>> path;
+        int cur = t;
+        for (;;) {
+            int x = cur % m_w, y = cur / m_w;
+            path.emplace_back(x + m_gxMin, y + m_gyMin);
+            if (cur == s) break;
+            int d = m_from[cur];
+            if (d < 2) x += back[d]; else y += (d == 2) ? -1 : 1;
+            cur = y * m_w + x;
         }
+        std::reverse(path.begin(), path.end());
+        return path;
     }
-    return {};
-}
+};
 
-static void BuildBlockedGrid(const std::vector<ElementInfo>& elements, int gridSize,
-    int gxMin, int gxMax, int gyMin, int gyMax,
-    int exceptA, int exceptB,
-    std::unordered_set<std::pair<int, int>, PairHash>& outBlocked,
-    int extraPadding = 8)
+// ---- 稀疏通道图路由 ----
+// 只保留窗口边界、两端点以及各障碍格子矩形两侧紧邻的行列作为网格线，整片空白压缩成少数节点：
+// 相邻网格线之间的格子障碍情况一致，曼哈顿最短路总能沿这些网格线走出，长度与逐格 A* 相同。
+// 状态带来向，代价先比长度、再比拐弯数。障碍稠密时压缩后的节点并不比原网格少，由调用方退回 GridAStar
+class SparseGridRouter
 {
-    for (size_t i = 0; i < elements.size(); ++i) {
-        if ((int)i == exceptA || (int)i == exceptB) continue;
-        const ElementInfo& e = elements[i];
-        int sz = std::max(1, e.size);
-        int left = e.x - extraPadding;
-        int top = e.y - extraPadding;
-        int right = e.x + BaseElemWidth * sz + extraPadding;
-        int bottom = e.y + BaseElemHeight * sz + extraPadding;
-        int gx0 = left / gridSize;
-        int gy0 = top / gridSize;
-        int gx1 = right / gridSize;
-        int gy1 = bottom / gridSize;
-        for (int gx = gx0; gx <= gx1; ++gx) {
-            for (int gy = gy0; gy <= gy1; ++gy) {
-                if (gx < gxMin || gx > gxMax || gy < gyMin || gy > gyMax) continue;
-                outBlocked.insert({ gx, gy });
+public:
+    // 在窗口 [gxMin, gxMax] x [gyMin, gyMax] 内求 start 到 goal 的格子路径（含两端、逐格相邻），写入 path。
+    // 返回 false 表示压缩不划算、未搜索；返回 true 且 path 为空表示不可达或被取消
+    bool Search(const ObstacleMap& obstacles, int exceptA, int exceptB, int gxMin, int gxMax, int gyMin, int gyMax,
+        const std::pair<int, int>& start, const std::pair<int, int>& goal,
+        std::vector<std::pair<int, int>>& path, const std::atomic<bool>* cancel = nullptr)
+    {
+        path.clear();
+        ObstacleMap::CellRect win{ gxMin, gyMin, gxMax, gyMax };
+        if (!win.Contains(start.first, start.second) || !win.Contains(goal.first, goal.second)) return true;
+
+        // 窗口内障碍（与 ObstacleMap::Probe 一致：两端元件不计）
+        m_ids.clear();
+        obstacles.ForEachElementNear(win, [&](int i) { if (i != exceptA && i != exceptB) m_ids.push_back(i); });
+        std::sort(m_ids.begin(), m_ids.end());
+        m_ids.erase(std::unique(m_ids.begin(), m_ids.end()), m_ids.end());
+
+        m_xs.assign({ gxMin, gxMax, gxMax + 1, start.first, start.first + 1, goal.first, goal.first + 1 });
+        m_ys.assign({ gyMin, gyMax, gyMax + 1, start.second, start.second + 1, goal.second, goal.second + 1 });
+        m_rects.clear();
+        for (int id : m_ids) {
+            ObstacleMap::CellRect r = obstacles.RegisteredCells(id);
+            r.gx0 = std::max(r.gx0, gxMin); r.gx1 = std::min(r.gx1, gxMax);
+            r.gy0 = std::max(r.gy0, gyMin); r.gy1 = std::min(r.gy1, gyMax);
+            if (r.Empty()) continue;
+            m_rects.push_back(r);
+            m_xs.insert(m_xs.end(), { r.gx0 - 1, r.gx0, r.gx1 + 1, r.gx1 + 2 });
+            m_ys.insert(m_ys.end(), { r.gy0 - 1, r.gy0, r.gy1 + 1, r.gy1 + 2 });
+        }
+        Compress(m_xs, gxMin, gxMax + 1);
+        Compress(m_ys, gyMin, gyMax + 1);
+        const int w = (int)m_xs.size() - 1, h = (int)m_ys.size() - 1;
+        // 节点（含 4 个来向）不到原网格格子数的一半才值得
+        if ((size_t)w * (size_t)h * 8 > (size_t)(gxMax - gxMin + 1) * (size_t)(gyMax - gyMin + 1)) return false;
+
+        // 二维差分标记被障碍覆盖的压缩格
+        const size_t cells = (size_t)w * (size_t)h;
+        m_cover.assign((size_t)(w + 1) * (size_t)(h + 1), 0);
+        auto col = [&](int gx) { return (int)(std::lower_bound(m_xs.begin(), m_xs.end(), gx) - m_xs.begin()); };
+        auto row = [&](int gy) { return (int)(std::lower_bound(m_ys.begin(), m_ys.end(), gy) - m_ys.begin()); };
+        for (const auto& r : m_rects) {
+            int i0 = col(r.gx0), i1 = col(r.gx1 + 1), j0 = row(r.gy0), j1 = row(r.gy1 + 1);
+            m_cover[(size_t)j0 * (w + 1) + i0] += 1; m_cover[(size_t)j0 * (w + 1) + i1] -= 1;
+            m_cover[(size_t)j1 * (w + 1) + i0] -= 1; m_cover[(size_t)j1 * (w + 1) + i1] += 1;
+        }
+        m_blocked.assign(cells, 0);
+        for (int j = 0; j < h; ++j)
+            for (int i = 0; i < w; ++i) {
+                int& v = m_cover[(size_t)j * (w + 1) + i];
+                if (i > 0) v += m_cover[(size_t)j * (w + 1) + i - 1];
+                if (j > 0) v += m_cover[(size_t)(j - 1) * (w + 1) + i];
+                if (i > 0 && j > 0) v -= m_cover[(size_t)(j - 1) * (w + 1) + i - 1];
+                m_blocked[(size_t)j * w + i] = v > 0;
+            }
+
+        const int s = row(start.second) * w + col(start.first);
+        const int t = row(goal.second) * w + col(goal.first);
+        m_blocked[t] = 0;  // 终点格子总是可走（与 GridAStar 一致）
+
+        // A*：状态 = 压缩格 * 4 + 来向；代价 = 长度 * LengthScale + 拐弯数
+        const int gx = goal.first, gy = goal.second;
+        auto heuristic = [&](int cell)->int64_t {
+            return (int64_t)(std::abs(m_xs[cell % w] - gx) + std::abs(m_ys[cell / w] - gy)) * LengthScale;
+            };
+        if (m_stamp.size() < cells * 4) {
+            m_stamp.resize(cells * 4, 0);
+            m_g.resize(cells * 4);
+            m_from.resize(cells * 4);
+        }
+        if (++m_gen == 0) {
+            std::fill(m_stamp.begin(), m_stamp.end(), 0);
+            m_gen = 1;
+        }
+        // 出队按 f 升序，f 相同时先取 g 大的（离终点近的），减少在等价路径平台上的展开
+        using Entry = std::tuple<int64_t, int64_t, int>;  // (f, -g, 状态)
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        for (int d = 0; d < 4; ++d) {
+            m_stamp[(size_t)s * 4 + d] = m_gen; m_g[(size_t)s * 4 + d] = 0; m_from[(size_t)s * 4 + d] = -1;
+            open.push(Entry(heuristic(s), 0, s * 4 + d));
+        }
+        const int dirs[4][2] = { {1,0},{-1,0},{0,1},{0,-1} };
+        size_t expanded = 0;
+        while (!open.empty()) {
+            if (cancel && (++expanded & 1023) == 0 && cancel->load(std::memory_order_relaxed)) return true;
+            const int st = std::get<2>(open.top());
+            const int64_t g = -std::get<1>(open.top());
+            open.pop();
+            if (g != m_g[st]) continue;  // 已被更优的 g 取代
+            const int cell = st >> 2, dir = st & 3;
+            if (cell == t) {
+                Reconstruct(st, w, path);
+                return true;
+            }
+            const int ci = cell % w, cj = cell / w;
+            for (int d = 0; d < 4; ++d) {
+                int ni = ci + dirs[d][0], nj = cj + dirs[d][1];
+                if (ni < 0 || ni >= w || nj < 0 || nj >= h) continue;
+                int nc = nj * w + ni;
+                if (m_blocked[nc]) continue;
+                int step = std::abs(m_xs[ni] - m_xs[ci]) + std::abs(m_ys[nj] - m_ys[cj]);
+                int64_t ng = g + (int64_t)step * LengthScale + (d != dir ? 1 : 0);
+                int ns = nc * 4 + d;
+                if (m_stamp[ns] != m_gen || ng < m_g[ns]) {
+                    m_stamp[ns] = m_gen; m_g[ns] = ng; m_from[ns] = st;
+                    open.push(Entry(ng + heuristic(nc), -ng, ns));
+                }
             }
         }
+        return true;
     }
-}
 
-// 在 ComputeManhattanPath 之前（或在 orient/LineSegmentsIntersect 之后）插入：
-static bool SegmentIntersectsElement(const wxPoint& s, const wxPoint& e, const ElementInfo& el) {
-    int sz = std::max(1, el.size);
-    wxRect r(el.x, el.y, BaseElemWidth * sz, BaseElemHeight * sz);
-    // 如果端点在矩形内，则认为相交
-    if (r.Contains(s) || r.Contains(e)) return true;
-    // 矩形四边
-    wxPoint r1(r.GetLeft(), r.GetTop()), r2(r.GetRight(), r.GetTop());
-    wxPoint r3(r.GetRight(), r.GetBottom()), r4(r.GetLeft(), r.GetBottom());
-    if (LineSegmentsIntersect(s, e, r1, r2)) return true;
-    if (LineSegmentsIntersect(s, e, r2, r3)) return true;
-    if (LineSegmentsIntersect(s, e, r3, r4)) return true;
-    if (LineSegmentsIntersect(s, e, r4, r1)) return true;
-    return false;
-}
+    static SparseGridRouter& ForThread()
+    {
+        thread_local SparseGridRouter instance;
+        return instance;
+    }
+
+private:
+    static constexpr int64_t LengthScale = int64_t(1) << 32; // 拐弯数远小于此值，保证长度优先
+
+    std::vector<int> m_ids;
+    std::vector<ObstacleMap::CellRect> m_rects;
+    std::vector<int> m_xs, m_ys;         // 网格线（压缩格的起始格坐标），末项为窗口外一格
+    std::vector<int> m_cover;
+    std::vector<char> m_blocked;
+    uint32_t m_gen = 0;
+    std::vector<uint32_t> m_stamp;       // == m_gen 表示本次搜索已写入 g/from
+    std::vector<int64_t> m_g;
+    std::vector<int> m_from;
+
+    static void Compress(std::vector<int>& v, int lo, int hi)
+    {
+        v.erase(std::remove_if(v.begin(), v.end(), [&](int x) { return x < lo || x > hi; }), v.end());
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    }
+
+    // 回溯压缩格节点并展开为逐格路径，以便沿用 SimplifyGridPathToTurningPoints
+    void Reconstruct(int st, int w, std::vector<std::pair<int, int>>& path) const
+    {
+        std::vector<std::pair<int, int>> nodes;
+        for (int cur = st; cur >= 0; cur = m_from[cur]) {
+            int cell = cur >> 2;
+            nodes.emplace_back(m_xs[cell % w], m_ys[cell / w]);
+        }
+        std::reverse(nodes.begin(), nodes.end());
+        path.push_back(nodes[0]);
+        for (size_t k = 1; k < nodes.size(); ++k) {
+            std::pair<int, int> p = path.back();
+            const std::pair<int, int>& q = nodes[k];
+            while (p != q) {
+                if (p.first != q.first) p.first += (q.first > p.first) ? 1 : -1;
+                else p.second += (q.second > p.second) ? 1 : -1;
+                path.push_back(p);
+            }
+        }
+    }
+};
 
+// 路由调用计数与累计耗时（性能 HUD 按拖拽区间取差值）
+static HotPathCounter g_routePerf;
 
+// obstacles 须与当前元件一致；exceptA/exceptB 为两端元件，不视为障碍。
+// cancel 非空时可被其它线程中途取消（取消后返回值无意义，调用方应丢弃）
 static std::vector<wxPoint> ComputeManhattanPath(const wxPoint& start, const wxPoint& end,
-    const std::vector<ElementInfo>& elements, int exceptA = -1, int exceptB = -1)
+    const ObstacleMap& obstacles, int exceptA = -1, int exceptB = -1,
+    const std::atomic<bool>* cancel = nullptr)
 {
+    HotPathCounter::Scope perfScope(g_routePerf);
     std::vector<wxPoint> empty;
     if (start.x == end.x || start.y == end.y) {
         return empty;
     }
 
+    const int gridSize = ObstacleMap::GridSize;
+    // 候选折线的各段都是轴对齐线段，直接交给障碍图的批量矩形检测
     auto intersectsAny = [&](const wxPoint& a, const wxPoint& b)->bool {
-        for (size_t i = 0; i < elements.size(); ++i) {
-            if ((int)i == exceptA || (int)i == exceptB) continue;
-            if (SegmentIntersectsElement(a, b, elements[i])) return true;
-        }
-        return false;
+        return obstacles.SegmentBlocked(a, b, exceptA, exceptB);
         };
 
     // 单折尝试
@@ -374,82 +540,73 @@ static std::vector<wxPoint> ComputeManhattanPath(const wxPoint& start, const wxP
     if (!intersectsAny(start, c1) && !intersectsAny(c1, end)) return { c1 };
     if (!intersectsAny(start, c2) && !intersectsAny(c2, end)) return { c2 };
 
-    // 双折中点尝试（对齐网格）
+    // 双折尝试（对齐网格）：Z 形的中段依次取 1/2、1/4、3/4 处；
+    // 再试绕到两端包围盒外侧的 U 形。按固定顺序尝试，结果可复现
     auto snapGrid = [](int v)->int { return ((v + 5) / 10) * 10; };
-    int midY = snapGrid((start.y + end.y) / 2);
-    wxPoint m1(start.x, midY), m2(end.x, midY);
-    if (!intersectsAny(start, m1) && !intersectsAny(m1, m2) && !intersectsAny(m2, end)) return { m1, m2 };
-    int midX = snapGrid((start.x + end.x) / 2);
-    wxPoint n1(midX, start.y), n2(midX, end.y);
-    if (!intersectsAny(start, n1) && !intersectsAny(n1, n2) && !intersectsAny(n2, end)) return { n1, n2 };
-
-    // 回退到 A* 网格
-    const int gridSize = 10;
-    int minX = std::min(start.x, end.x), maxX = std::max(start.x, end.x);
-    int minY = std::min(start.y, end.y), maxY = std::max(start.y, end.y);
-    for (const auto& el : elements) {
-        minX = std::min(minX, el.x - BaseElemWidth);
-        minY = std::min(minY, el.y - BaseElemHeight);
-        maxX = std::max(maxX, el.x + BaseElemWidth * std::max(1, el.size) + BaseElemWidth);
-        maxY = std::max(maxY, el.y + BaseElemHeight * std::max(1, el.size) + BaseElemHeight);
-    }
-    const int padding = 120;
-    minX -= padding; minY -= padding; maxX += padding; maxY += padding;
-
-    int gxMin = (minX) / gridSize; int gyMin = (minY) / gridSize;
-    int gxMax = (maxX) / gridSize; int gyMax = (maxY) / gridSize;
+    auto tryTwoBends = [&](const wxPoint& p1, const wxPoint& p2)->bool {
+        return !intersectsAny(start, p1) && !intersectsAny(p1, p2) && !intersectsAny(p2, end);
+        };
+    const int fractions[3][2] = { { 1, 2 }, { 1, 4 }, { 3, 4 } };
+    for (const auto& f : fractions) {
+        int midY = snapGrid(start.y + (end.y - start.y) * f[0] / f[1]);
+        wxPoint m1(start.x, midY), m2(end.x, midY);
+        if (tryTwoBends(m1, m2)) return { m1, m2 };
+        int midX = snapGrid(start.x + (end.x - start.x) * f[0] / f[1]);
+        wxPoint n1(midX, start.y), n2(midX, end.y);
+        if (tryTwoBends(n1, n2)) return { n1, n2 };
+    }
+    const int detourSteps[3] = { 2, 4, 8 };
+    for (int step : detourSteps) {
+        int off = step * gridSize;
+        int top = snapGrid(std::min(start.y, end.y) - off), bottom = snapGrid(std::max(start.y, end.y) + off);
+        int left = snapGrid(std::min(start.x, end.x) - off), right = snapGrid(std::max(start.x, end.x) + off);
+        if (tryTwoBends(wxPoint(start.x, top), wxPoint(end.x, top))) return { wxPoint(start.x, top), wxPoint(end.x, top) };
+        if (tryTwoBends(wxPoint(start.x, bottom), wxPoint(end.x, bottom))) return { wxPoint(start.x, bottom), wxPoint(end.x, bottom) };
+        if (tryTwoBends(wxPoint(left, start.y), wxPoint(left, end.y))) return { wxPoint(left, start.y), wxPoint(left, end.y) };
+        if (tryTwoBends(wxPoint(right, start.y), wxPoint(right, end.y))) return { wxPoint(right, start.y), wxPoint(right, end.y) };
+    }
+
+    // 回退到网格搜索：先在两端包围盒外扩一圈的窗口内搜索，失败再放大到整个设计范围（外扩 padding）
     std::pair<int, int> sNode{ start.x / gridSize, start.y / gridSize };
     std::pair<int, int> eNode{ end.x / gridSize, end.y / gridSize };
+    const int paddingCells = 120 / gridSize;
+    int gxMin = std::min(sNode.first, eNode.first), gxMax = std::max(sNode.first, eNode.first);
+    int gyMin = std::min(sNode.second, eNode.second), gyMax = std::max(sNode.second, eNode.second);
+    int margin = std::max(paddingCells, (gxMax - gxMin) + (gyMax - gyMin));
+    ObstacleMap::CellRect ext = obstacles.Extent();
+    int fullMinX = gxMin - paddingCells, fullMaxX = gxMax + paddingCells;
+    int fullMinY = gyMin - paddingCells, fullMaxY = gyMax + paddingCells;
+    if (!ext.Empty()) {
+        fullMinX = std::min(fullMinX, ext.gx0 - paddingCells); fullMaxX = std::max(fullMaxX, ext.gx1 + paddingCells);
+        fullMinY = std::min(fullMinY, ext.gy0 - paddingCells); fullMaxY = std::max(fullMaxY, ext.gy1 + paddingCells);
+    }
 
-    std::unordered_set<std::pair<int, int>, PairHash> blocked;
-    BuildBlockedGrid(elements, gridSize, gxMin, gxMax, gyMin, gyMax, exceptA, exceptB, blocked, 8);
-    blocked.erase(sNode);
-    blocked.erase(eNode);
-
-    auto gridPath = AStarGridPath(sNode, eNode, gxMin, gxMax, gyMin, gyMax, blocked);
-    if (!gridPath.empty()) {
-        return SimplifyGridPathToTurningPoints(gridPath, gridSize);
+    // 每个窗口先试稀疏通道图（空旷区域的长连线只展开少量节点），障碍稠密时退回逐格 A*
+    ObstacleMap::Probe probe(obstacles, exceptA, exceptB);
+    auto blocked = [&](int gx, int gy) { return probe.Blocked(gx, gy); };
+    GridAStar& grid = GridAStar::ForThread();
+    SparseGridRouter& sparse = SparseGridRouter::ForThread();
+    std::vector<std::pair<int, int>> gridPath;
+    for (;;) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) return { c1 };
+        int x0 = std::max(fullMinX, gxMin - margin), x1 = std::min(fullMaxX, gxMax + margin);
+        int y0 = std::max(fullMinY, gyMin - margin), y1 = std::min(fullMaxY, gyMax + margin);
+        if (!sparse.Search(obstacles, exceptA, exceptB, x0, x1, y0, y1, sNode, eNode, gridPath, cancel)) {
+            grid.Reset(x0, x1, y0, y1);
+            gridPath = grid.Search(sNode, eNode, blocked, cancel);
+        }
+        if (!gridPath.empty()) return SimplifyGridPathToTurningPoints(gridPath, gridSize);
+        if (x0 == fullMinX && x1 == fullMaxX && y0 == fullMinY && y1 == fullMaxY) break;
+        margin *= 4;
     }
     return { c1 };
 }
 
-// DrawConnection: 支持转折点，动态端点（若绑定到元素）
-static void DrawConnection(wxDC& dc, const ConnectionInfo& c, const std::vector<ElementInfo>& elements, const wxColour& penColor = wxColour(0, 0, 0)) {
+// DrawConnection: 绘制已解析的连线折线（端点与转折点，见 CanvasPanel::ConnectionPolyline）
+static void DrawConnection(wxDC& dc, const std::vector<wxPoint>& pts, const wxColour& penColor = wxColour(0, 0, 0)) {
     wxPen old = dc.GetPen();
     dc.SetPen(wxPen(penColor, 2));
-    wxPoint p1(c.x1, c.y1), p2(c.x2, c.y2);
-
-    // 如果连接到某个元件的输出，使用该元件对应输出 pin 的位置（支持多输出）
-    if (c.aIndex >= 0 && c.aIndex < (int)elements.size()) {
-        const ElementInfo& ea = elements[c.aIndex];
-        int sz = std::max(1, ea.size);
-        int w = BaseElemWidth * sz;
-        int h = BaseElemHeight * sz;
-        int nOut = std::max(1, ea.outputs);
-        int pin = (c.aPin < 0) ? 0 : c.aPin;
-        float step = (float)h / (nOut + 1);
-        int py = ea.y + (int)(step * (pin + 1));
-        p1 = wxPoint(ea.x + w, py);
-    }
-    // 如果连接到某个元件的输入，使用该元件对应输入 pin 的位置（支持多输入）
-    if (c.bIndex >= 0 && c.bIndex < (int)elements.size()) {
-        const ElementInfo& eb = elements[c.bIndex];
-        int sz = std::max(1, eb.size);
-        int h = BaseElemHeight * sz;
-        int nIn = std::max(1, eb.inputs);
-        int pin = (c.bPin < 0) ? 0 : c.bPin;
-        float step = (float)h / (nIn + 1);
-        int py = eb.y + (int)(step * (pin + 1));
-        p2 = wxPoint(eb.x, py);
-    }
-
-    std::vector<wxPoint> pts;
-    pts.push_back(p1);
-    for (const auto& tp : c.turningPoints) pts.push_back(tp);
-    pts.push_back(p2);
-    for (size_t i = 1; i < pts.size(); ++i) {
-        dc.DrawLine(pts[i - 1].x, pts[i - 1].y, pts[i].x, pts[i].y);
-    }
+    if (pts.size() >= 2) dc.DrawLines((int)pts.size(), pts.data());
     dc.SetPen(old);
 }
 
@@ -538,6 +695,55 @@ private:
     void OnApply(wxCommandEvent& evt);
 };
 
+// 缩略图：整张设计的低分辨率缓存图 + 当前视口框，点击/拖动跳转。
+// 缓存图只在设计范围变化或面板尺寸变化时整体重建，元件移动等编辑只重画受影响的世界区域
+class MinimapPanel : public wxPanel
+{
+public:
+    MinimapPanel(wxWindow* parent, CanvasPanel* canvas = nullptr);
+
+    void SetCanvas(CanvasPanel* c) { m_canvas = c; InvalidateAll(); }
+    // 设计整体变化（加载/撤销/删除等）：下次绘制时整体重建
+    void InvalidateAll() { m_fullRebuild = true; m_dirtyWorld.clear(); Refresh(); }
+    // 世界坐标区域内容变化：下次绘制时只重画这些区域
+    void InvalidateWorld(const wxRect& r) { if (!r.IsEmpty()) m_dirtyWorld.push_back(r); Refresh(); }
+    // 连接 ci 新增或几何变化：重画其登记的旧范围与当前范围，并更新连线分块索引
+    void InvalidateConnection(size_t ci);
+    // 连接 ci 即将被删除（之后的下标前移）：重画其范围并从索引中移除
+    void ConnectionErased(size_t ci);
+    // 画布视口变化：只需重画视口框
+    void ViewChanged() { Refresh(); }
+
+private:
+    CanvasPanel* m_canvas;
+    wxImage m_image;            // 缓存图（RGB），覆盖世界范围 m_extent
+    wxBitmap m_bitmap;
+    bool m_bitmapValid = false;
+    bool m_fullRebuild = true;
+    wxRect m_extent;            // 缓存图对应的世界范围（设计包围盒加留白）
+    double m_scale = 1.0;       // 世界坐标 → 缓存图像素
+    wxPoint m_imageOrigin;      // 缓存图在面板中的位置（居中）
+    std::vector<wxRect> m_dirtyWorld;
+    static constexpr size_t MaxDirtyRects = 32;
+    // 连线分块索引：缓存图按 WireChunkPx 像素分块，每块登记与之相交的连线下标；
+    // m_wireWorld 为各连线登记时的世界坐标范围（几何变化后据此重画旧位置）。元件经画布的障碍图查询
+    std::vector<std::vector<int>> m_wireChunks;
+    std::vector<wxRect> m_wireWorld;
+    int m_chunkCols = 0, m_chunkRows = 0;
+    static constexpr int WireChunkPx = 16;
+
+    void OnPaint(wxPaintEvent& event);
+    void OnMouse(wxMouseEvent& event);
+    void Rebuild();
+    void FlushDirty();
+    void RenderRegion(const wxRect& pixelRect);
+    wxRect WorldToImage(const wxRect& r) const;
+    wxRect ImageToWorld(const wxRect& px) const;
+    bool ChunkRange(const wxRect& px, int& c0, int& r0, int& c1, int& r1) const;
+    void IndexWire(size_t ci, bool add);
+    void FillImageRect(const wxRect& r, const wxRect& clip, unsigned char cr, unsigned char cg, unsigned char cb);
+    void DrawImageLine(wxPoint a, wxPoint b, const wxRect& clip, unsigned char cr, unsigned char cg, unsigned char cb);
+};
 
 
 // ---- CanvasPanel ----
@@ -563,6 +769,11 @@ public:
         SetBackgroundStyle(wxBG_STYLE_PAINT);
         SetBackgroundColour(*wxWHITE);
 
+        m_perfTimer.SetOwner(this, ID_TIMER_PERF);
+        Bind(wxEVT_TIMER, &CanvasPanel::OnPerfTimer, this, ID_TIMER_PERF);
+        m_autosaveTimer.SetOwner(this, ID_TIMER_AUTOSAVE);
+        Bind(wxEVT_TIMER, [this](wxTimerEvent&) { StartCompaction(); }, ID_TIMER_AUTOSAVE);
+
         LoadElementsAndConnectionsFromFile();
 
         Bind(wxEVT_LEFT_DOWN, &CanvasPanel::OnLeftDown, this);
@@ -572,6 +783,10 @@ public:
         Bind(wxEVT_LEFT_UP, &CanvasPanel::OnLeftUp, this);
         Bind(wxEVT_RIGHT_DOWN, &CanvasPanel::OnRightDown, this);
         Bind(wxEVT_RIGHT_UP, &CanvasPanel::OnRightUp, this);
+        Bind(wxEVT_MOUSEWHEEL, &CanvasPanel::OnMouseWheel, this);
+        Bind(wxEVT_SYS_COLOUR_CHANGED, [this](wxSysColourChangedEvent& e) {
+            m_spriteCache.Invalidate(); m_backValid = false; Refresh(); e.Skip();
+        });
 
         // 键盘事件：保留 KEY_DOWN，同时绑定 CHAR_HOOK 以更可靠接收 Delete/Backspace
         Bind(wxEVT_KEY_DOWN, &CanvasPanel::OnKeyDown, this);
@@ -582,9 +797,31 @@ public:
         Bind(wxEVT_SET_FOCUS, [this](wxFocusEvent&) { SetFocus(); });
     }
 
+    // 后台路由任务持有 this，须先停止工作线程
+    ~CanvasPanel() { m_placeWorker.Stop(); m_routeWorker.Stop(); FlushAutosave(); }
+
     bool IsDirty() const { return m_dirty; }
     void SetPropertyPanel(PropertyPanel* p) { m_propPanel = p; if (m_propPanel) m_propPanel->SetCanvas(this); }
     int GetSelectedIndex() const { return m_selectedIndex; }
+    const PinOccupancyIndex& GetPinIndex() const { return m_pinIndex; }
+
+    // 缩略图访问的只读数据与视图跳转
+    void SetMinimap(MinimapPanel* m) { m_minimap = m; if (m_minimap) m_minimap->SetCanvas(this); }
+    const std::vector<ElementInfo>& GetElements() const { return m_elements; }
+    size_t GetConnectionCount() const { return m_connections.size(); }
+    const std::vector<wxPoint>& GetConnectionPolyline(size_t ci) const { return ConnectionPolyline(ci); }
+    wxRect GetConnectionBounds(size_t ci) const { return PolylineBounds(ConnectionPolyline(ci)); }
+    std::vector<int> GetElementsInRect(const wxRect& world) const { return ElementsInRect(world); }
+    wxRect GetVisibleWorldRect() const { return VisibleWorldRect(); }
+    void CenterViewOn(const wxPoint& world)
+    {
+        wxSize sz = GetClientSize();
+        m_viewOrigin.x = world.x - (int)std::lround(sz.x / 2 / m_zoom);
+        m_viewOrigin.y = world.y - (int)std::lround(sz.y / 2 / m_zoom);
+        m_backValid = false;
+        Refresh();
+        if (m_minimap) m_minimap->ViewChanged();
+    }
 
     // ApplyPropertiesToSelected（包含 inputs/outputs）
     void ApplyPropertiesToSelected(int x, int y, int size, int inputs, int outputs)
@@ -598,6 +835,9 @@ public:
         e.x = x;
         e.y = y;
         e.size = std::max(1, size);
+        e.Touch();
+        m_obstacles.Update(m_selectedIndex, e);
+        MinimapReset();
 
         // 针对特殊类型约束
         if (IsInputType(e.type)) {
@@ -617,7 +857,9 @@ public:
             e.outputs = outputs < 1 ? 1 : outputs;
         }
 
-        SaveElementsAndConnectionsToFile();
+        JournalHint hint;
+        hint.elements.push_back((size_t)m_selectedIndex);
+        ScheduleAutosave(&hint);
         m_backValid = false;
         RebuildBackbuffer();
         Refresh();
@@ -628,11 +870,31 @@ public:
         wxAutoBufferedPaintDC dc(this); dc.Clear();
         wxSize sz = GetClientSize();
         if (!m_backValid || m_backBitmap.GetWidth() != sz.x || m_backBitmap.GetHeight() != sz.y) RebuildBackbuffer();
-        if (m_backValid) dc.DrawBitmap(m_backBitmap, 0, 0, false);
-        else DrawGrid(dc);
-        if (m_dragging && m_dragIndex >= 0 && m_dragIndex < (int)m_elements.size()) {
+        PerfTimer paintTimer;
+        if (m_backValid) dc.DrawBitmap((m_simulating && m_simValid) ? m_simBitmap : m_backBitmap, 0, 0, false);
+        bool dragVisible = m_dragging && m_dragIndex >= 0 && m_dragIndex < (int)m_elements.size();
+        if (dragVisible && SelectLodTier(m_zoom) == LodTier::Full) {
+            // 拖拽中的元件直接贴精灵（设备坐标）
+            const ElementInfo& e = m_elements[m_dragIndex];
+            wxPoint dev = WorldToScreen(m_dragCurrent);
+            m_spriteCache.Draw(dc, e.type, e.color, e.thickness, e.size, m_zoom, dev.x, dev.y);
+            dragVisible = false;
+        }
+        // 以下临时图形都使用世界坐标
+        ApplyViewTransform(dc);
+        if (!m_backValid) DrawGrid(dc);
+        if (dragVisible) {
             const ElementInfo& e = m_elements[m_dragIndex];
-            DrawElement(dc, e.type, e.color, e.thickness, m_dragCurrent.x, m_dragCurrent.y, e.size);
+            dc.SetPen(wxPen(wxColour(e.color), e.thickness)); dc.SetBrush(*wxWHITE_BRUSH);
+            DrawElementBox(dc, m_dragCurrent.x, m_dragCurrent.y, e.size);
+        }
+        // 跟随拖拽的连线预览
+        for (const auto& dw : m_dragWires) {
+            if (dw.poly.size() < 2) continue;
+            const auto& c = m_connections[dw.conn];
+            bool isOutputToInput = ((c.aIndex >= 0) || (c.aConn >= 0)) && (c.bIndex >= 0);
+            dc.SetPen(wxPen(isOutputToInput ? wxColour(0, 128, 0) : wxColour(0, 0, 0), 2));
+            dc.DrawLines((int)dw.poly.size(), dw.poly.data());
         }
         if (m_connecting) {
             ConnectorHit endHit = HitTestConnector(m_tempLineEnd);
@@ -645,14 +907,12 @@ public:
             }
             else lineColor = valid ? wxColour(0, 128, 0) : wxColour(0, 0, 0);
             dc.SetPen(wxPen(lineColor, 2));
-            wxPoint startPt;
-            if (m_connectStartElem >= 0) startPt = GetConnectorPosition(m_connectStartElem, m_connectStartPin, true);
-            else startPt = m_connectStartGrid;
-            std::vector<wxPoint> tempTurns = ComputeManhattanPath(startPt, m_tempLineEnd, m_elements, m_connectStartElem, -1);
-            wxPoint prev = startPt;
-            for (const auto& pt : tempTurns) { dc.DrawLine(prev.x, prev.y, pt.x, pt.y); prev = pt; }
-            dc.DrawLine(prev.x, prev.y, m_tempLineEnd.x, m_tempLineEnd.y);
+            // 只画已完成的后台路由结果，不在绘制中路由
+            std::vector<wxPoint> preview = ConnectPreviewPolyline();
+            dc.DrawLines((int)preview.size(), preview.data());
         }
+        m_perf.paint.Add(paintTimer.ElapsedMs());
+        if (m_showPerfHud) DrawPerfHud(dc);
     }
 
     int HitTestConnection(const wxPoint& pt)
@@ -660,11 +920,7 @@ public:
         const int LINE_HIT_TOLERANCE = 4;
         for (size_t i = 0; i < m_connections.size(); ++i)
         {
-            const auto& conn = m_connections[i];
-            std::vector<wxPoint> linePoints;
-            linePoints.emplace_back(conn.x1, conn.y1);
-            for (const auto& p : conn.turningPoints) linePoints.push_back(p);
-            linePoints.emplace_back(conn.x2, conn.y2);
+            const std::vector<wxPoint>& linePoints = ConnectionPolyline(i);
 
             for (size_t j = 0; j + 1 < linePoints.size(); ++j)
             {
@@ -697,7 +953,7 @@ public:
 
     void OnLeftDown(wxMouseEvent& event)
     {
-        wxPoint pt = event.GetPosition();
+        wxPoint pt = ScreenToWorld(event.GetPosition());
         // 确保画布在点击后获取键盘焦点，以接收 Delete 键等按键事件
         SetFocus();
 
@@ -713,8 +969,8 @@ public:
                 ao.t = hitT;
                 // 防止与现有 aux 过近（像素距离 <= 2）
                 bool dup = false;
-                for (const auto& existing : m_connections[hitConn].auxOutputs) {
-                    wxPoint expt = AuxOutputToPixel(existing, m_connections[hitConn], m_elements);
+                for (size_t ai = 0; ai < m_connections[hitConn].auxOutputs.size(); ++ai) {
+                    wxPoint expt = CachedAuxPixel(hitConn, ai);
                     if (DistanceSquared(expt, nearest) <= 4) { dup = true; break; }
                 }
                 if (!dup) {
@@ -722,8 +978,11 @@ public:
                     SaveStateForUndo();
 
                     m_connections[hitConn].auxOutputs.push_back(ao);
+                    m_connections[hitConn].Touch();
                     m_backValid = false;
-                    SaveElementsAndConnectionsToFile();
+                    JournalHint hint;
+                    hint.connections.push_back((size_t)hitConn);
+                    ScheduleAutosave(&hint);
                     RebuildBackbuffer();
                     Refresh();
                 }
@@ -744,8 +1003,7 @@ public:
                 c.x1 = startPos.x; c.y1 = startPos.y; c.aIndex = m_connectStartElem; c.aPin = m_connectStartPin;
             }
             else if (m_connectStartConnIndex >= 0 && m_connectStartConnOutputIndex >= 0) {
-                const auto& parent = m_connections[m_connectStartConnIndex];
-                wxPoint startPos = AuxOutputToPixel(parent.auxOutputs[m_connectStartConnOutputIndex], parent, m_elements);
+                wxPoint startPos = CachedAuxPixel(m_connectStartConnIndex, m_connectStartConnOutputIndex);
                 c.x1 = startPos.x; c.y1 = startPos.y; c.aIndex = -1; c.aPin = -1; c.aConn = m_connectStartConnIndex; c.aConnAux = m_connectStartConnOutputIndex;
             }
             else {
@@ -761,14 +1019,17 @@ public:
             }
 
             // 计算曼哈顿转折
-            c.turningPoints = ComputeManhattanPath(wxPoint(c.x1, c.y1), wxPoint(c.x2, c.y2), m_elements, c.aIndex, c.bIndex);
+            c.turningPoints = ComputeManhattanPath(wxPoint(c.x1, c.y1), wxPoint(c.x2, c.y2), m_obstacles, c.aIndex, c.bIndex);
 
             if (IsConnectionValid(c)) {
                 //保存撤销点
                 SaveStateForUndo();
 
                 m_connections.push_back(c);
-                SaveElementsAndConnectionsToFile();
+                m_pinIndex.Add(c);
+                MinimapConnectionChanged(m_connections.size() - 1);
+                const JournalHint appended; // 只在末尾新增
+                ScheduleAutosave(&appended);
                 if (m_simulating) {
                     m_connectionSignals.resize(m_connections.size(), -1);
                     PropagateSignals();
@@ -883,7 +1144,10 @@ public:
             SaveStateForUndo();
 
             m_elements.push_back(newElem);
-            SaveElementsAndConnectionsToFile();
+            m_obstacles.Add((int)m_elements.size() - 1, newElem);
+            MinimapDirty(ElementRect(wxPoint(newElem.x, newElem.y), newElem.size));
+            const JournalHint appended; // 只在末尾新增
+            ScheduleAutosave(&appended);
             m_backValid = false; m_dirty = true; RebuildBackbuffer();
             if (mf) mf->SetPlacementType(std::string());
             Refresh();
@@ -891,7 +1155,7 @@ public:
         event.Skip();
     }
 
-    void OnSize(wxSizeEvent& event) { m_backValid = false; Refresh(); event.Skip(); }
+    void OnSize(wxSizeEvent& event) { m_backValid = false; Refresh(); if (m_minimap) m_minimap->ViewChanged(); event.Skip(); }
 
     bool AskSaveIfDirty()
     {
@@ -900,7 +1164,7 @@ public:
         int res = dlg.ShowModal();
         if (res == wxID_YES) {
             // 弹出保存对话框，让用户选择保存路径
-            wxFileDialog fd(this, "保存文件", "", "Elementlib.json", "JSON files (*.json)|*.json", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+            wxFileDialog fd(this, "保存文件", "", "Elementlib.json", "JSON files (*.json)|*.json|Binary design (*.lgdb)|*.lgdb", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
             if (fd.ShowModal() != wxID_OK) {
                 // 用户在保存对话框中取消，视为取消关闭
                 return false;
@@ -922,70 +1186,263 @@ public:
 
     void OnMouseMove(wxMouseEvent& event)
     {
-        wxPoint pt = event.GetPosition();
+        wxPoint pt = ScreenToWorld(event.GetPosition());
         if (m_dragging && m_dragIndex >= 0) {
-            wxPoint newPos(pt.x - m_dragOffset.x, pt.y - m_dragOffset.y);
-            wxRect oldRect = ElementRect(m_prevDragCurrent, m_elements[m_dragIndex].size);
-            wxRect newRect = ElementRect(newPos, m_elements[m_dragIndex].size);
-            wxRect refreshRect = oldRect.Union(newRect);
-            refreshRect.Inflate(10, 10);
-            m_dragCurrent = newPos; m_prevDragCurrent = m_dragCurrent;
-            RefreshRect(refreshRect);
+            // 合并鼠标移动：只记录最新位置，事件队列中至多排队一次更新
+            m_pendingDragPos = wxPoint(pt.x - m_dragOffset.x, pt.y - m_dragOffset.y);
+            if (!m_dragMovePending) {
+                m_dragMovePending = true;
+                CallAfter(&CanvasPanel::ProcessDragMove);
+            }
         }
         else if (m_connecting) {
-            wxPoint oldEnd = m_prevTempLineEnd;
-            m_tempLineEnd = SnapToGrid(pt);
-            wxPoint startPt;
-            if (m_connectStartElem >= 0 && m_connectStartIsOutput) startPt = GetConnectorPosition(m_connectStartElem, m_connectStartPin, true);
-            else startPt = m_connectStartGrid;
-            wxRect oldRect(startPt, oldEnd);
-            wxRect newRect(startPt, m_tempLineEnd);
-            wxRect refreshRect = oldRect.Union(newRect);
-            refreshRect.Inflate(6, 6);
-            m_prevTempLineEnd = m_tempLineEnd;
-            RefreshRect(refreshRect);
+            wxPoint snapped = SnapToGrid(pt);
+            if (snapped != m_tempLineEnd) {
+                wxRect refreshRect = PolylineBounds(ConnectPreviewPolyline());
+                m_tempLineEnd = snapped;
+                refreshRect = refreshRect.Union(PolylineBounds(ConnectPreviewPolyline()));
+                refreshRect.Inflate(6, 6);
+                m_prevTempLineEnd = m_tempLineEnd;
+                RefreshRect(WorldToScreen(refreshRect));
+                RequestConnectPreview();
+            }
         }
         event.Skip();
     }
 
+    // ---- 拖拽时连线跟随 ----
+    // 处理合并后的最新拖拽位置：移动元件预览，连线先用 L 形预览跟随，再提交后台完整路由
+    void ProcessDragMove()
+    {
+        m_dragMovePending = false;
+        if (!m_dragging || m_dragIndex < 0 || m_pendingDragPos == m_dragCurrent) return;
+        if (!m_dragWiresInit) BeginDragWires();
+        const int size = m_elements[m_dragIndex].size;
+        wxRect refreshRect = ElementRect(m_prevDragCurrent, size).Union(ElementRect(m_pendingDragPos, size));
+        for (const auto& dw : m_dragWires) refreshRect = refreshRect.Union(PolylineBounds(dw.poly));
+        m_dragCurrent = m_pendingDragPos; m_prevDragCurrent = m_dragCurrent;
+        for (size_t i = 0; i < m_dragWires.size(); ++i) {
+            UpdateDragWirePreview(i);
+            refreshRect = refreshRect.Union(PolylineBounds(m_dragWires[i].poly));
+        }
+        refreshRect.Inflate(10, 10);
+        RefreshRect(WorldToScreen(refreshRect));
+        RequestDragRouting();
+    }
+
+    // 首次移动时收集与被拖元件直接相连的连线，并从静态层中隐藏（由 OnPaint 绘制跟随的预览）
+    void BeginDragWires()
+    {
+        m_dragWiresInit = true;
+        m_dragWires.clear();
+        for (size_t ci = 0; ci < m_connections.size(); ++ci) {
+            const auto& c = m_connections[ci];
+            if (c.aIndex != m_dragIndex && c.bIndex != m_dragIndex) continue;
+            const std::vector<wxPoint>& poly = ConnectionPolyline(ci);
+            DragWire dw;
+            dw.conn = ci;
+            dw.movesStart = (c.aIndex == m_dragIndex);
+            dw.movesEnd = (c.bIndex == m_dragIndex);
+            dw.baseStart = poly.front();
+            dw.baseEnd = poly.back();
+            dw.poly = poly;
+            m_dragWires.push_back(dw);
+        }
+        if (m_dragWires.empty()) return;
+        m_dragHiddenConn.assign(m_connections.size(), 0);
+        for (const auto& dw : m_dragWires) m_dragHiddenConn[dw.conn] = 1;
+        m_backValid = false;
+        RebuildBackbuffer();
+        Refresh();
+    }
+
+    // 按元件当前位移计算端点，生成 L 形预览（与 ComputeManhattanPath 无障碍时的单折形状一致）
+    void UpdateDragWirePreview(size_t i)
+    {
+        auto& dw = m_dragWires[i];
+        const wxPoint delta = m_dragCurrent - m_dragStart;
+        dw.start = dw.movesStart ? dw.baseStart + delta : dw.baseStart;
+        dw.end = dw.movesEnd ? dw.baseEnd + delta : dw.baseEnd;
+        dw.routed = false;
+        dw.poly.clear();
+        dw.poly.push_back(dw.start);
+        if (dw.start.x != dw.end.x && dw.start.y != dw.end.y) dw.poly.push_back(wxPoint(dw.start.x, dw.end.y));
+        dw.poly.push_back(dw.end);
+    }
+
+    // 提交后台完整路由；新的提交会取消尚未完成的上一次
+    void RequestDragRouting()
+    {
+        if (m_dragWires.empty()) return;
+        struct RouteJob { wxPoint start, end; int a, b; };
+        std::vector<RouteJob> jobs;
+        jobs.reserve(m_dragWires.size());
+        for (const auto& dw : m_dragWires) {
+            const auto& c = m_connections[dw.conn];
+            jobs.push_back(RouteJob{ dw.start, dw.end, c.aIndex, c.bIndex });
+        }
+        const uint64_t gen = ++m_dragRouteGen;
+        m_routeWorker.Submit([this, gen, jobs](const std::atomic<bool>& cancelled) {
+            std::vector<std::vector<wxPoint>> turns;
+            turns.reserve(jobs.size());
+            for (const auto& j : jobs) {
+                if (cancelled.load()) return;
+                turns.push_back(ComputeManhattanPath(j.start, j.end, m_obstacles, j.a, j.b, &cancelled));
+            }
+            if (cancelled.load()) return;
+            CallAfter([this, gen, turns]() { ApplyDragRouting(gen, turns); });
+        });
+    }
+
+    // 界面线程：只接受最新一次提交的结果
+    void ApplyDragRouting(uint64_t gen, const std::vector<std::vector<wxPoint>>& turns)
+    {
+        if (!m_dragging || gen != m_dragRouteGen || turns.size() != m_dragWires.size()) return;
+        wxRect refreshRect;
+        for (size_t i = 0; i < m_dragWires.size(); ++i) {
+            auto& dw = m_dragWires[i];
+            refreshRect = refreshRect.Union(PolylineBounds(dw.poly));
+            dw.turns = turns[i];
+            dw.poly.clear();
+            dw.poly.push_back(dw.start);
+            dw.poly.insert(dw.poly.end(), dw.turns.begin(), dw.turns.end());
+            dw.poly.push_back(dw.end);
+            dw.routed = true;
+            refreshRect = refreshRect.Union(PolylineBounds(dw.poly));
+        }
+        refreshRect.Inflate(6, 6);
+        RefreshRect(WorldToScreen(refreshRect));
+    }
+
+    void EndDragWires()
+    {
+        m_routeWorker.Cancel();
+        ++m_dragRouteGen;
+        m_dragWires.clear();
+        m_dragHiddenConn.clear();
+        m_dragWiresInit = false;
+    }
+
+    // 放弃进行中的拖拽：元件在松开鼠标前尚未移动，只需丢弃预览与被隐藏的连线
+    void CancelDrag()
+    {
+        if (!m_dragging) return;
+        EndDragWires();
+        if (HasCapture()) ReleaseMouse();
+        m_dragging = false; m_dragIndex = -1; m_dragMovePending = false;
+        m_prevDragCurrent = wxPoint(-10000, -10000);
+        m_backValid = false;
+        Refresh();
+    }
+
+    // 一批相互独立的路由请求：并行求解（只读 m_elements / m_obstacles），结果按请求下标写回，
+    // 提交顺序与线程调度无关。请求很少时直接在当前线程执行
+    struct RouteRequest {
+        wxPoint start, end;
+        int exceptA, exceptB;
+        std::vector<wxPoint> turns;  // 输出
+    };
+    static constexpr size_t ParallelRouteMinBatch = 4;
+    void RouteBatch(std::vector<RouteRequest>& batch) const
+    {
+        ParallelFor(batch.size(), [&](size_t i) {
+            RouteRequest& r = batch[i];
+            r.turns = ComputeManhattanPath(r.start, r.end, m_obstacles, r.exceptA, r.exceptB);
+            }, batch.size() < ParallelRouteMinBatch ? 1u : 0u);
+    }
+
     void OnLeftUp(wxMouseEvent& event)
     {
         if (m_dragging && m_dragIndex >= 0) {
+            // 尚未处理的合并移动直接取最新位置
+            if (m_dragMovePending) { m_dragCurrent = m_pendingDragPos; m_dragMovePending = false; }
+            // 后台已按最终位置完成路由的连线直接复用结果
+            std::unordered_map<size_t, size_t> routedWires;  // 连线下标 -> m_dragWires 下标
+            for (size_t i = 0; i < m_dragWires.size(); ++i)
+                if (m_dragWires[i].routed) routedWires[m_dragWires[i].conn] = i;
+            // 后台路由读取 m_obstacles，更新障碍图前等它退出
+            m_routeWorker.CancelAndWait();
+            const HotPathCounter::Snapshot routeBefore = g_routePerf.Take();
+            // 缩略图只重画元件新旧位置与重新路由连线的新旧范围（连线旧范围由缩略图的索引记录）
+            std::vector<size_t> reroutedConns;
+            MinimapDirty(ElementRect(wxPoint(m_elements[m_dragIndex].x, m_elements[m_dragIndex].y), m_elements[m_dragIndex].size));
+            MinimapDirty(ElementRect(m_dragCurrent, m_elements[m_dragIndex].size));
             m_elements[m_dragIndex].x = m_dragCurrent.x;
             m_elements[m_dragIndex].y = m_dragCurrent.y;
-            // 重新路由与该元件相关的连接，并更新 aux
+            m_elements[m_dragIndex].Touch();
+            m_obstacles.Update(m_dragIndex, m_elements[m_dragIndex]);
+            // 一次遍历收集受影响的连接：与该元件直接相连的，以及起点挂在它们 aux 上的子连接
+            std::vector<char> attachedFlag(m_connections.size(), 0);
+            std::vector<size_t> attachedConns, childConns;
+            for (size_t ci = 0; ci < m_connections.size(); ++ci) {
+                const auto& c = m_connections[ci];
+                if (c.aIndex == m_dragIndex || c.bIndex == m_dragIndex) { attachedFlag[ci] = 1; attachedConns.push_back(ci); }
+            }
             for (size_t ci = 0; ci < m_connections.size(); ++ci) {
+                const auto& c = m_connections[ci];
+                if (c.aConn >= 0 && c.aConn < (int)m_connections.size() && attachedFlag[c.aConn]
+                    && c.aConnAux >= 0 && c.aConnAux < (int)m_connections[c.aConn].auxOutputs.size()) childConns.push_back(ci);
+            }
+
+            // 第一批：直接相连的连接（拖拽时后台已按最终端点算好的直接复用）
+            std::vector<RouteRequest> batch;
+            std::vector<size_t> batchConn;
+            for (size_t ci : attachedConns) {
                 auto& conn = m_connections[ci];
-                if (conn.aIndex == m_dragIndex || conn.bIndex == m_dragIndex) {
-                    wxPoint p1 = (conn.aIndex >= 0 && conn.aIndex < (int)m_elements.size()) ? GetConnectorPosition(conn.aIndex, conn.aPin, true) : wxPoint(conn.x1, conn.y1);
-                    wxPoint p2 = (conn.bIndex >= 0 && conn.bIndex < (int)m_elements.size()) ? GetConnectorPosition(conn.bIndex, conn.bPin, false) : wxPoint(conn.x2, conn.y2);
-                    conn.turningPoints = ComputeManhattanPath(p1, p2, m_elements, conn.aIndex, conn.bIndex);
-                    conn.x1 = p1.x; conn.y1 = p1.y; conn.x2 = p2.x; conn.y2 = p2.y;
-                    std::vector<wxPoint> poly; poly.emplace_back(conn.x1, conn.y1);
-                    for (const auto& tp : conn.turningPoints) poly.push_back(tp);
-                    poly.emplace_back(conn.x2, conn.y2);
-                    for (auto& ao : conn.auxOutputs) {
-                        wxPoint oldPt = AuxOutputToPixel(ao, conn, m_elements);
-                        int newSeg; double newT; wxPoint newPt;
-                        std::tie(newSeg, newT, newPt) = ProjectPointToPolylineDetailed(oldPt, poly);
-                        if (newSeg < 0) { ao.segIndex = 0; ao.t = 0.0; }
-                        else { ao.segIndex = newSeg; ao.t = newT; }
-                    }
-                    // 更新以该 connection 为父的子连接
-                    for (auto& child : m_connections) {
-                        if (child.aConn == (int)ci && child.aConnAux >= 0) {
-                            const auto& parent = m_connections[child.aConn];
-                            if (child.aConnAux < (int)parent.auxOutputs.size()) {
-                                wxPoint newStart = AuxOutputToPixel(parent.auxOutputs[child.aConnAux], parent, m_elements);
-                                child.x1 = newStart.x; child.y1 = newStart.y;
-                                wxPoint endPt = (child.bIndex >= 0 && child.bIndex < (int)m_elements.size()) ? GetConnectorPosition(child.bIndex, child.bPin, false) : wxPoint(child.x2, child.y2);
-                                child.turningPoints = ComputeManhattanPath(newStart, endPt, m_elements, child.aIndex, child.bIndex);
-                            }
-                        }
-                    }
+                wxPoint p1 = (conn.aIndex >= 0 && conn.aIndex < (int)m_elements.size()) ? GetConnectorPosition(conn.aIndex, conn.aPin, true) : wxPoint(conn.x1, conn.y1);
+                wxPoint p2 = (conn.bIndex >= 0 && conn.bIndex < (int)m_elements.size()) ? GetConnectorPosition(conn.bIndex, conn.bPin, false) : wxPoint(conn.x2, conn.y2);
+                auto routed = routedWires.find(ci);
+                if (routed != routedWires.end() && m_dragWires[routed->second].start == p1 && m_dragWires[routed->second].end == p2)
+                    conn.turningPoints = m_dragWires[routed->second].turns;
+                else { batch.push_back(RouteRequest{ p1, p2, conn.aIndex, conn.bIndex, {} }); batchConn.push_back(ci); }
+                conn.x1 = p1.x; conn.y1 = p1.y; conn.x2 = p2.x; conn.y2 = p2.y;
+            }
+            RouteBatch(batch);
+            for (size_t k = 0; k < batch.size(); ++k) m_connections[batchConn[k]].turningPoints = std::move(batch[k].turns);
+            // 按连接下标顺序提交：重投影 aux 点
+            for (size_t ci : attachedConns) {
+                auto& conn = m_connections[ci];
+                reroutedConns.push_back(ci);
+                std::vector<wxPoint> poly; poly.emplace_back(conn.x1, conn.y1);
+                for (const auto& tp : conn.turningPoints) poly.push_back(tp);
+                poly.emplace_back(conn.x2, conn.y2);
+                for (auto& ao : conn.auxOutputs) {
+                    wxPoint oldPt = AuxOutputToPixel(ao, conn, m_elements);
+                    int newSeg; double newT; wxPoint newPt;
+                    std::tie(newSeg, newT, newPt) = ProjectPointToPolylineDetailed(oldPt, poly);
+                    if (newSeg < 0) { ao.segIndex = 0; ao.t = 0.0; }
+                    else { ao.segIndex = newSeg; ao.t = newT; }
                 }
-            }
-            m_dirty = true; m_backValid = false; RebuildBackbuffer(); SaveElementsAndConnectionsToFile();
+                conn.Touch();
+            }
+
+            // 第二批：子连接起点随父连接的 aux 点移动
+            batch.clear();
+            for (size_t chi : childConns) {
+                auto& child = m_connections[chi];
+                wxPoint newStart = CachedAuxPixel(child.aConn, child.aConnAux);
+                child.x1 = newStart.x; child.y1 = newStart.y;
+                wxPoint endPt = (child.bIndex >= 0 && child.bIndex < (int)m_elements.size()) ? GetConnectorPosition(child.bIndex, child.bPin, false) : wxPoint(child.x2, child.y2);
+                if (attachedFlag[chi]) { child.x2 = endPt.x; child.y2 = endPt.y; }
+                batch.push_back(RouteRequest{ newStart, endPt, child.aIndex, child.bIndex, {} });
+            }
+            RouteBatch(batch);
+            for (size_t k = 0; k < childConns.size(); ++k) {
+                auto& child = m_connections[childConns[k]];
+                child.turningPoints = std::move(batch[k].turns);
+                child.Touch();
+                reroutedConns.push_back(childConns[k]);
+            }
+            for (size_t ci : reroutedConns) MinimapConnectionChanged(ci);
+            const HotPathCounter::Snapshot routeAfter = g_routePerf.Take();
+            m_perf.routeCalls.Add((double)(routeAfter.calls - routeBefore.calls));
+            m_perf.routeMs.Add((routeAfter.nanos - routeBefore.nanos) / 1e6);
+            EndDragWires();
+            m_dirty = true; m_backValid = false; RebuildBackbuffer();
+            JournalHint hint;
+            hint.elements.push_back((size_t)m_dragIndex);
+            hint.connections = reroutedConns;
+            ScheduleAutosave(&hint);
             if (HasCapture()) ReleaseMouse();
             m_dragging = false; m_dragIndex = -1; m_prevDragCurrent = wxPoint(-10000, -10000);
             if (m_selectedIndex >= 0 && m_selectedIndex < (int)m_elements.size() && m_propPanel) m_propPanel->UpdateForElement(m_elements[m_selectedIndex]);
@@ -996,7 +1453,7 @@ public:
 
     void OnRightDown(wxMouseEvent& event)
     {
-        wxPoint pt = event.GetPosition();
+        wxPoint pt = ScreenToWorld(event.GetPosition());
         ConnectorHit hit = HitTestConnector(pt);
         m_connecting = true;
         m_connectStartGrid = SnapToGrid(pt);
@@ -1006,7 +1463,7 @@ public:
         if (hit.hit && hit.isConnOutput && hit.connIndex >= 0 && hit.connOutputIndex >= 0) {
             const auto& conn = m_connections[hit.connIndex];
             if (hit.connOutputIndex < (int)conn.auxOutputs.size()) {
-                wxPoint auxPixel = AuxOutputToPixel(conn.auxOutputs[hit.connOutputIndex], conn, m_elements);
+                wxPoint auxPixel = CachedAuxPixel(hit.connIndex, hit.connOutputIndex);
                 m_connectStartGrid = auxPixel; m_connectStartElem = -1; m_connectStartPin = -1; m_connectStartIsOutput = true;
                 m_connectStartConnIndex = hit.connIndex; m_connectStartConnOutputIndex = hit.connOutputIndex;
             }
@@ -1016,13 +1473,70 @@ public:
             m_connectStartElem = hit.elemIndex; m_connectStartPin = hit.pinIndex; m_connectStartIsOutput = true; m_connectStartConnIndex = -1; m_connectStartConnOutputIndex = -1;
         }
         else { m_connectStartElem = -1; m_connectStartPin = -1; m_connectStartIsOutput = false; m_connectStartConnIndex = -1; m_connectStartConnOutputIndex = -1; }
+        EndConnectPreview();
         CaptureMouse(); event.Skip();
     }
 
+    // ---- 连线预览 ----
+    wxPoint ConnectStartPoint() const
+    {
+        if (m_connectStartElem >= 0) return GetConnectorPosition(m_connectStartElem, m_connectStartPin, true);
+        return m_connectStartGrid;
+    }
+
+    bool ConnectPreviewMatches(const wxPoint& start, const wxPoint& end, int exceptA) const
+    {
+        return m_connectPreview.valid && m_connectPreview.start == start && m_connectPreview.end == end && m_connectPreview.exceptA == exceptA;
+    }
+
+    // 当前应显示的预览折线：后台结果与当前端点一致时用它，否则先画单折 L 形
+    std::vector<wxPoint> ConnectPreviewPolyline() const
+    {
+        const wxPoint start = ConnectStartPoint(), end = m_tempLineEnd;
+        std::vector<wxPoint> poly;
+        poly.push_back(start);
+        if (ConnectPreviewMatches(start, end, m_connectStartElem))
+            poly.insert(poly.end(), m_connectPreview.turns.begin(), m_connectPreview.turns.end());
+        else if (start.x != end.x && start.y != end.y) poly.push_back(wxPoint(start.x, end.y));
+        poly.push_back(end);
+        return poly;
+    }
+
+    // 光标进入新格子时提交后台路由，取消尚未完成的旧请求
+    void RequestConnectPreview()
+    {
+        const wxPoint start = ConnectStartPoint(), end = m_tempLineEnd;
+        const int exceptA = m_connectStartElem;
+        if (ConnectPreviewMatches(start, end, exceptA)) return;
+        const uint64_t gen = ++m_connectRouteGen;
+        m_routeWorker.Submit([this, gen, start, end, exceptA](const std::atomic<bool>& cancelled) {
+            std::vector<wxPoint> turns = ComputeManhattanPath(start, end, m_obstacles, exceptA, -1, &cancelled);
+            if (cancelled.load()) return;
+            CallAfter([this, gen, start, end, exceptA, turns]() {
+                if (!m_connecting || gen != m_connectRouteGen) return;
+                wxRect refreshRect = PolylineBounds(ConnectPreviewPolyline());
+                m_connectPreview.start = start; m_connectPreview.end = end; m_connectPreview.exceptA = exceptA;
+                m_connectPreview.turns = turns;
+                m_connectPreview.valid = true;
+                refreshRect = refreshRect.Union(PolylineBounds(ConnectPreviewPolyline()));
+                refreshRect.Inflate(6, 6);
+                RefreshRect(WorldToScreen(refreshRect));
+            });
+        });
+    }
+
+    void EndConnectPreview()
+    {
+        m_routeWorker.Cancel();
+        ++m_connectRouteGen;
+        m_connectPreview.valid = false;
+        m_connectPreview.turns.clear();
+    }
+
     void OnRightUp(wxMouseEvent& event)
     {
         if (m_connecting) {
-            wxPoint pt = event.GetPosition();
+            wxPoint pt = ScreenToWorld(event.GetPosition());
             wxPoint snapped = SnapToGrid(pt);
             ConnectorHit endHit = HitTestConnector(pt);
 
@@ -1034,7 +1548,7 @@ public:
             else if (m_connectStartConnIndex >= 0 && m_connectStartConnIndex < (int)m_connections.size() && m_connectStartConnOutputIndex >= 0) {
                 const auto& parent = m_connections[m_connectStartConnIndex];
                 if (m_connectStartConnOutputIndex < (int)parent.auxOutputs.size()) {
-                    wxPoint startPos = AuxOutputToPixel(parent.auxOutputs[m_connectStartConnOutputIndex], parent, m_elements);
+                    wxPoint startPos = CachedAuxPixel(m_connectStartConnIndex, m_connectStartConnOutputIndex);
                     c.x1 = startPos.x; c.y1 = startPos.y; c.aIndex = -1; c.aPin = -1; c.aConn = m_connectStartConnIndex; c.aConnAux = m_connectStartConnOutputIndex;
                 }
                 else { c.x1 = m_connectStartGrid.x; c.y1 = m_connectStartGrid.y; c.aIndex = -1; c.aPin = -1; c.aConn = -1; c.aConnAux = -1; }
@@ -1047,13 +1561,19 @@ public:
             }
             else { c.x2 = snapped.x; c.y2 = snapped.y; c.bIndex = -1; c.bPin = -1; }
 
-            c.turningPoints = ComputeManhattanPath(wxPoint(c.x1, c.y1), wxPoint(c.x2, c.y2), m_elements, c.aIndex, c.bIndex);
+            // 终点未落在端点上时，与预览的路由条件相同，可直接复用后台结果
+            if (c.bIndex < 0 && ConnectPreviewMatches(wxPoint(c.x1, c.y1), wxPoint(c.x2, c.y2), c.aIndex)) c.turningPoints = m_connectPreview.turns;
+            else c.turningPoints = ComputeManhattanPath(wxPoint(c.x1, c.y1), wxPoint(c.x2, c.y2), m_obstacles, c.aIndex, c.bIndex);
+            EndConnectPreview();
             if (IsConnectionValid(c)) { 
                 //保存撤销点
                 SaveStateForUndo();
 
                 m_connections.push_back(c); 
-                SaveElementsAndConnectionsToFile(); }
+                m_pinIndex.Add(c);
+                MinimapConnectionChanged(m_connections.size() - 1);
+                const JournalHint appended;
+                ScheduleAutosave(&appended); }
 
             m_backValid = false; RebuildBackbuffer();
             m_prevTempLineEnd = wxPoint(-10000, -10000);
@@ -1066,6 +1586,32 @@ public:
         event.Skip();
     }
 
+    // 滚轮：Ctrl+滚轮以光标为中心缩放，Shift+滚轮水平平移，其余垂直平移
+    void OnMouseWheel(wxMouseEvent& event)
+    {
+        int rot = event.GetWheelRotation();
+        if (rot == 0) { event.Skip(); return; }
+        if (event.ControlDown()) {
+            wxPoint screen = event.GetPosition();
+            wxPoint anchor = ScreenToWorld(screen);
+            double zoom = m_zoom * (rot > 0 ? 1.25 : 0.8);
+            zoom = std::max(MinZoom, std::min(MaxZoom, zoom));
+            if (zoom == m_zoom) return;
+            m_zoom = zoom;
+            // 保持光标下的世界坐标不变
+            m_viewOrigin.x = anchor.x - (int)std::lround(screen.x / m_zoom);
+            m_viewOrigin.y = anchor.y - (int)std::lround(screen.y / m_zoom);
+        }
+        else {
+            int step = (int)std::lround(60.0 / m_zoom) * (rot > 0 ? -1 : 1);
+            if (event.ShiftDown()) m_viewOrigin.x += step;
+            else m_viewOrigin.y += step;
+        }
+        m_backValid = false;
+        Refresh();
+        if (m_minimap) m_minimap->ViewChanged();
+    }
+
     void OnKeyDown(wxKeyEvent& event)
     {
         //Ctrl+Z ->Undo
@@ -1077,12 +1623,17 @@ public:
         // Delete 键：优先删除选中连线，其次删除选中元件（原逻辑）
         if (event.GetKeyCode() == WXK_DELETE)
         {
+            // 拖拽中不删除（预览仍引用当前的连线下标）
+            if (m_dragging) return;
+
             if (m_selectedConnectionIndex >= 0 && m_selectedConnectionIndex < (int)m_connections.size())
             {
                 //保存撤销点
                 SaveStateForUndo();
 
                 // 删除选中的连线
+                m_pinIndex.Remove(m_connections[m_selectedConnectionIndex]);
+                if (m_minimap) m_minimap->ConnectionErased(m_selectedConnectionIndex);
                 m_connections.erase(m_connections.begin() + m_selectedConnectionIndex);
 
                 // 仿真数据同步
@@ -1098,7 +1649,7 @@ public:
                 RebuildBackbuffer();
                 Refresh();
                 m_dirty = true;
-                SaveElementsAndConnectionsToFile();
+                ScheduleAutosave();
                 return;
             }
 
@@ -1117,11 +1668,15 @@ public:
                     {
                         remainingConnections.push_back(conn);
                     }
+                    else m_pinIndex.Remove(conn);
                 }
                 m_connections.swap(remainingConnections);
 
                 // 2. 删除选中的元件
                 m_elements.erase(m_elements.begin() + m_selectedIndex);
+                m_pinIndex.EraseElement(m_selectedIndex);
+                m_obstacles.EraseElement(m_selectedIndex);
+                MinimapReset();
 
                 // 3. 更新所有连接中涉及的元件索引（因为删除后索引会变化）
                 for (auto& conn : m_connections)
@@ -1143,7 +1698,7 @@ public:
                 m_backValid = false;
                 RebuildBackbuffer();
                 Refresh();
-                SaveElementsAndConnectionsToFile();
+                ScheduleAutosave();
                 return;
             }
         }
@@ -1152,6 +1707,238 @@ public:
         event.Skip();
     }
 
+    // 导出整张原理图为图片：按扩展名选择 SVG 或 PNG，不受窗口大小与当前缩放限制
+    bool ExportImage(const std::string& filename, double scale = 1.0)
+    {
+        ExportOptions opts;
+        opts.scale = scale;
+        wxString ext = wxFileName(filename).GetExt().Lower();
+        if (ext == "svg") return ExportSchematicSVG(filename, m_elements, m_connections, opts);
+        return ExportSchematicPNG(filename, m_elements, m_connections, opts);
+    }
+
+    // 全部连接协商拥塞重新布线（可撤销）
+    AutorouteResult AutorouteAllConnections()
+    {
+        if (m_connections.empty()) return AutorouteResult();
+        SaveStateForUndo();
+        PerfTimer timer;
+        AutorouteResult r = AutorouteAll(m_elements, m_connections, m_obstacles);
+        m_perf.autoroute.Add(timer.ElapsedMs());
+        MinimapReset();
+        m_dirty = true; m_backValid = false; RebuildBackbuffer(); ScheduleAutosave();
+        Refresh();
+        return r;
+    }
+
+    // 全局自动布局全部元件，随后重新布线全部连接（可撤销）
+    PlacementResult AutoPlaceAll()
+    {
+        if (m_elements.empty()) return PlacementResult();
+        SaveStateForUndo();
+        PerfTimer timer;
+        const std::vector<char> fixed = FixedElementMask(m_elements);
+        PlacementResult r = GlobalPlace(m_elements, m_connections, fixed);
+        LegalizePlacement(m_elements, fixed);
+        r.hpwlAfter = PlacementHPWL(m_elements, m_connections);
+        m_perf.place.Add(timer.ElapsedMs());
+        m_obstacles.Rebuild(m_elements);
+        if (!m_connections.empty()) RipUpAndReroute(false, /*saveUndo=*/false);
+        else {
+            MinimapReset();
+            m_dirty = true; m_backValid = false; RebuildBackbuffer(); ScheduleAutosave();
+            Refresh();
+        }
+        return r;
+    }
+
+    // 消除元件重叠：移到最近的对齐网格的空位，随后重新布线（可撤销）
+    LegalizeResult LegalizeAll()
+    {
+        if (m_elements.empty()) return LegalizeResult();
+        // 在副本上合法化，没有元件需要移动时不产生撤销点
+        PerfTimer timer;
+        std::vector<ElementInfo> placed = m_elements;
+        LegalizeResult r = LegalizePlacement(placed, FixedElementMask(placed));
+        m_perf.place.Add(timer.ElapsedMs());
+        if (r.moved == 0) return r;
+        SaveStateForUndo();
+        m_elements.swap(placed);
+        m_obstacles.Rebuild(m_elements);
+        if (!m_connections.empty()) RipUpAndReroute(false, /*saveUndo=*/false);
+        else {
+            MinimapReset();
+            m_dirty = true; m_backValid = false; RebuildBackbuffer(); ScheduleAutosave();
+            Refresh();
+        }
+        return r;
+    }
+
+    // 后台模拟退火细化当前布局：在模型副本上运行，进度显示在状态栏；完成时若设计未被修改则写回坐标并重新布线（可撤销）
+    bool StartAnnealPlacement()
+    {
+        if (m_placeRunning || m_elements.empty()) return false;
+        auto elements = std::make_shared<std::vector<ElementInfo>>(m_elements);
+        auto connections = std::make_shared<const std::vector<ConnectionInfo>>(m_connections);
+        auto stamps = std::make_shared<std::vector<uint64_t>>();
+        stamps->reserve(m_elements.size());
+        for (const auto& e : m_elements) stamps->push_back(e.geomStamp);
+        const uint64_t gen = ++m_placeGen;
+        m_placeRunning = true;
+        ShowStatus("Refining placement...");
+        m_placeWorker.Submit([this, gen, elements, connections, stamps](const std::atomic<bool>& cancelled) {
+            PerfTimer timer;
+            // 退火只保持合法性，先在副本上消除已有的重叠
+            const std::vector<char> fixed = FixedElementMask(*elements);
+            LegalizePlacement(*elements, fixed);
+            AnnealResult r = AnnealPlacement(*elements, *connections, fixed, AnnealOptions(), &cancelled,
+                [this, gen](double fraction, double hpwl) {
+                    CallAfter([this, gen, fraction, hpwl]() {
+                        if (gen != m_placeGen) return;
+                        ShowStatus(wxString::Format("Refining placement: %d%%, wirelength %.0f", (int)(fraction * 100), hpwl));
+                    });
+                });
+            if (r.cancelled) return;
+            const double ms = timer.ElapsedMs();
+            CallAfter([this, gen, elements, stamps, r, ms]() { ApplyAnnealPlacement(gen, *elements, *stamps, r, ms); });
+        });
+        return true;
+    }
+
+    void CancelAnnealPlacement()
+    {
+        if (!m_placeRunning) return;
+        m_placeWorker.Cancel();
+        ++m_placeGen;
+        m_placeRunning = false;
+        ShowStatus("Placement refinement cancelled");
+    }
+
+    // 界面线程：元件数目或任一元件的几何版本与启动时不同，说明期间设计被修改过，此时丢弃结果
+    void ApplyAnnealPlacement(uint64_t gen, const std::vector<ElementInfo>& placed, const std::vector<uint64_t>& startStamps,
+        const AnnealResult& r, double ms)
+    {
+        if (gen != m_placeGen) return;
+        m_placeRunning = false;
+        bool unchanged = placed.size() == m_elements.size() && startStamps.size() == m_elements.size();
+        for (size_t i = 0; unchanged && i < m_elements.size(); ++i) unchanged = m_elements[i].geomStamp == startStamps[i];
+        if (!unchanged) {
+            ShowStatus("Design changed during placement refinement; result discarded");
+            return;
+        }
+        SaveStateForUndo();
+        for (size_t i = 0; i < placed.size(); ++i) {
+            ElementInfo& e = m_elements[i];
+            if (e.x == placed[i].x && e.y == placed[i].y) continue;
+            e.x = placed[i].x; e.y = placed[i].y; e.Touch();
+        }
+        m_perf.place.Add(ms);
+        m_obstacles.Rebuild(m_elements);
+        if (!m_connections.empty()) RipUpAndReroute(false, /*saveUndo=*/false);
+        else {
+            MinimapReset();
+            m_dirty = true; m_backValid = false; RebuildBackbuffer(); ScheduleAutosave();
+            Refresh();
+        }
+        ShowStatus(wxString::Format("Placement refined in %.1f ms: %d elements moved, wirelength %.0f -> %.0f",
+            ms, (int)r.moved, r.hpwlBefore, r.hpwlAfter));
+    }
+
+    void ShowStatus(const wxString& text)
+    {
+        wxFrame* frame = dynamic_cast<wxFrame*>(wxGetTopLevelParent(this));
+        if (frame) frame->SetStatusText(text);
+    }
+
+    // 拆除并重新计算连接的 turningPoints：全部连接，或只限与当前可见区域相交的连接（可撤销）。
+    // 端点按元件端点位置重新取得（导入的网表坐标可能过期）；子连接起点依赖父连接的新走线，
+    // 因此按 aux 深度分层，每层内并行路由、按连接下标提交，结果与线程数无关。返回重新路由的连接数。
+    // saveUndo 为 false 时由调用方负责保存撤销状态（与之前的修改合为一步）
+    size_t RipUpAndReroute(bool visibleOnly, bool saveUndo = true)
+    {
+        const size_t n = m_connections.size();
+        if (n == 0) return 0;
+        if (saveUndo) SaveStateForUndo();
+        PerfTimer timer;
+        std::vector<char> pick(n, 1);
+        if (visibleOnly) {
+            wxRect view = VisibleWorldRect();
+            for (size_t ci = 0; ci < n; ++ci) pick[ci] = view.Intersects(PolylineBounds(ConnectionPolyline(ci))) ? 1 : 0;
+        }
+        std::vector<int> depth(n, 0);
+        int maxDepth = 0;
+        for (size_t ci = 0; ci < n; ++ci) {
+            depth[ci] = ConnectionRoot(m_connections, ci);
+            maxDepth = std::max(maxDepth, depth[ci]);
+        }
+        if (visibleOnly) {
+            // 父连接重新走线后其 aux 点会重投影到新路径上，子连接起点随之移动，
+            // 因此被选中连接的 aux 子树（含视口外的部分）一并重新路由。按深度由浅到深传递
+            std::vector<std::vector<size_t>> byDepth(maxDepth + 1);
+            for (size_t ci = 0; ci < n; ++ci) byDepth[depth[ci]].push_back(ci);
+            for (int level = 1; level <= maxDepth; ++level)
+                for (size_t ci : byDepth[level]) {
+                    const int parent = m_connections[ci].aConn;
+                    if (!pick[ci] && parent >= 0 && parent < (int)n && pick[parent]) pick[ci] = 1;
+                }
+        }
+
+        size_t rerouted = 0;
+        std::vector<RouteRequest> batch;
+        std::vector<size_t> batchConn;
+        for (int level = 0; level <= maxDepth; ++level) {
+            batch.clear(); batchConn.clear();
+            for (size_t ci = 0; ci < n; ++ci) {
+                if (!pick[ci] || depth[ci] != level) continue;
+                const auto& c = m_connections[ci];
+                wxPoint p1, p2;
+                if (c.aIndex >= 0 && c.aIndex < (int)m_elements.size()) p1 = GetConnectorPosition(c.aIndex, c.aPin, true);
+                else if (c.aConn >= 0 && c.aConn < (int)n && c.aConnAux >= 0 && c.aConnAux < (int)m_connections[c.aConn].auxOutputs.size()) p1 = CachedAuxPixel(c.aConn, c.aConnAux);
+                else p1 = wxPoint(c.x1, c.y1);
+                p2 = (c.bIndex >= 0 && c.bIndex < (int)m_elements.size()) ? GetConnectorPosition(c.bIndex, c.bPin, false) : wxPoint(c.x2, c.y2);
+                batch.push_back(RouteRequest{ p1, p2, c.aIndex, c.bIndex, {} });
+                batchConn.push_back(ci);
+            }
+            if (batch.empty()) continue;
+            // 长连接先领取，减少并行尾部等待；排序只影响调度，不影响结果
+            std::vector<size_t> order(batch.size());
+            for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+            auto length = [&](size_t k) { return std::abs(batch[k].end.x - batch[k].start.x) + std::abs(batch[k].end.y - batch[k].start.y); };
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return length(a) > length(b); });
+            std::vector<RouteRequest> sorted;
+            sorted.reserve(batch.size());
+            for (size_t k : order) sorted.push_back(batch[k]);
+            RouteBatch(sorted);
+            for (size_t k = 0; k < order.size(); ++k) batch[order[k]].turns = std::move(sorted[k].turns);
+
+            // 按连接下标顺序提交
+            for (size_t k = 0; k < batch.size(); ++k) {
+                auto& conn = m_connections[batchConn[k]];
+                std::vector<wxPoint> oldAux;
+                for (size_t ai = 0; ai < conn.auxOutputs.size(); ++ai) oldAux.push_back(CachedAuxPixel(batchConn[k], ai));
+                conn.x1 = batch[k].start.x; conn.y1 = batch[k].start.y;
+                conn.x2 = batch[k].end.x; conn.y2 = batch[k].end.y;
+                conn.turningPoints = std::move(batch[k].turns);
+                conn.Touch();
+                if (!oldAux.empty()) {
+                    const std::vector<wxPoint>& poly = ConnectionPolyline(batchConn[k]);
+                    for (size_t ai = 0; ai < oldAux.size(); ++ai) {
+                        int newSeg; double newT; wxPoint newPt;
+                        std::tie(newSeg, newT, newPt) = ProjectPointToPolylineDetailed(oldAux[ai], poly);
+                        if (newSeg < 0) { conn.auxOutputs[ai].segIndex = 0; conn.auxOutputs[ai].t = 0.0; }
+                        else { conn.auxOutputs[ai].segIndex = newSeg; conn.auxOutputs[ai].t = newT; }
+                    }
+                    conn.Touch();
+                }
+            }
+            rerouted += batch.size();
+        }
+        m_perf.ripup.Add(timer.ElapsedMs());
+        MinimapReset();
+        m_dirty = true; m_backValid = false; RebuildBackbuffer(); ScheduleAutosave();
+        Refresh();
+        return rerouted;
+    }
 
     // Export netlist (JSON)
     bool ExportNetlist(const std::string& filename)
@@ -1183,195 +1970,49 @@ public:
         catch (...) { return false; }
     }
 
-    // 导出 BookShelf（保持合并实现）
-    bool ExportBookShelf(const std::string& nodeFile, const std::string& netFile)
+    // 导出 BookShelf：base.aux/.node/.net/.pl/.scl，连接按线网合并为多引脚线网
+    bool ExportBookShelf(const std::string& base)
     {
-        try {
-            std::map<std::pair<int, int>, std::string> extMap;
-            int extCounter = 0;
-            for (const auto& c : m_connections) {
-                if (c.aIndex < 0) {
-                    std::pair<int, int> key(c.x1, c.y1);
-                    if (extMap.find(key) == extMap.end()) extMap[key] = "ext" + std::to_string(extCounter++);
-                }
-                if (c.bIndex < 0) {
-                    std::pair<int, int> key(c.x2, c.y2);
-                    if (extMap.find(key) == extMap.end()) extMap[key] = "ext" + std::to_string(extCounter++);
-                }
-            }
-            // NODE
-            {
-                std::ofstream nodeofs(nodeFile);
-                if (!nodeofs.is_open()) return false;
-                nodeofs << "UCLA nodes 1.0\n";
-                size_t numNodes = m_elements.size() + extMap.size();
-                nodeofs << "NumNodes : " << numNodes << "\n";
-                nodeofs << "NumTerminals : " << extMap.size() << "\n";
-                for (size_t i = 0; i < m_elements.size(); ++i) {
-                    const auto& e = m_elements[i];
-                    int w = std::max(1, (int)std::round(60 * e.size));
-                    int h = std::max(1, (int)std::round(40 * e.size));
-                    nodeofs << "comp" << i << " " << w << " " << h << "\n";
-                }
-                for (const auto& kv : extMap) nodeofs << kv.second << " 1 1 terminal\n";
-                nodeofs.close();
-            }
-            // NET
-            {
-                std::ofstream netofs(netFile);
-                if (!netofs.is_open()) return false;
-                netofs << "UCLA nets 1.0\n";
-                netofs << "NumNets : " << m_connections.size() << "\n";
-                size_t totalPins = 0;
-                for (const auto& c : m_connections) totalPins += 2;
-                netofs << "NumPins : " << totalPins << "\n";
-                netofs.setf(std::ios::fixed);
-                netofs << std::setprecision(6);
-                for (size_t i = 0; i < m_connections.size(); ++i) {
-                    const auto& c = m_connections[i];
-                    int degree = 2;
-                    netofs << "NetDegree : " << degree << " n" << i << "\n";
-                    {
-                        std::string nodeName;
-                        double x = (double)c.x1; double y = (double)c.y1;
-                        if (c.aIndex >= 0 && c.aIndex < (int)m_elements.size()) nodeName = "comp" + std::to_string(c.aIndex);
-                        else {
-                            auto it = extMap.find(std::make_pair(c.x1, c.y1));
-                            if (it != extMap.end()) nodeName = it->second; else nodeName = "ext_unknown";
-                        }
-                        netofs << " " << nodeName << " O : " << x << " " << y << "\n";
-                    }
-                    {
-                        std::string nodeName;
-                        double x = (double)c.x2; double y = (double)c.y2;
-                        if (c.bIndex >= 0 && c.bIndex < (int)m_elements.size()) nodeName = "comp" + std::to_string(c.bIndex);
-                        else {
-                            auto it = extMap.find(std::make_pair(c.x2, c.y2));
-                            if (it != extMap.end()) nodeName = it->second; else nodeName = "ext_unknown";
-                        }
-                        netofs << " " << nodeName << " I : " << x << " " << y << "\n";
-                    }
-                }
-                netofs.close();
-            }
-            return true;
-        }
-        catch (...) { return false; }
+        return WriteBookShelf(base, m_elements, m_connections);
     }
 
     // 导入通用网表（兼容多种结构）
     bool ImportNetlist(const std::string& filename)
     {
-        std::ifstream ifs(filename);
-        if (!ifs.is_open()) return false;
-        json root;
-        try { ifs >> root; }
-        catch (const std::exception& e) { wxMessageBox(wxString("读取或解析网表失败: ") + e.what(), "Import Error", wxOK | wxICON_ERROR); return false; }
-        const json* nl = nullptr;
-        if (root.contains("netlist") && root["netlist"].is_object()) nl = &root["netlist"];
-        else nl = &root;
-
-        m_elements.clear(); m_connections.clear();
-        bool usedIdIndexing = false; std::map<int, ElementInfo> compById; int maxId = -1;
-        if (nl->contains("components") && (*nl)["components"].is_array()) {
-            for (const auto& comp : (*nl)["components"]) {
-                ElementInfo e;
-                e.type = comp.value("type", std::string());
-                e.color = comp.value("color", std::string("black"));
-                e.thickness = comp.value("thickness", 1);
-                e.x = comp.value("x", 0);
-                e.y = comp.value("y", 0);
-                e.size = comp.value("size", 1);
-                e.rotationIndex = comp.value("rotationIndex", 0);
-                e.inputs = comp.value("inputs", 0);
-                e.outputs = comp.value("outputs", 0);
-                if (comp.contains("id")) {
-                    int id = comp["id"].get<int>(); usedIdIndexing = true; compById[id] = e; if (id > maxId) maxId = id;
-                }
-                else m_elements.push_back(e);
-            }
-            if (usedIdIndexing) {
-                m_elements.assign(maxId + 1, ElementInfo());
-                for (const auto& kv : compById) if (kv.first >= 0 && kv.first < (int)m_elements.size()) m_elements[kv.first] = kv.second;
-            }
-        }
-        else if (nl->contains("elements") && (*nl)["elements"].is_array()) {
-            for (const auto& comp : (*nl)["elements"]) {
-                ElementInfo e;
-                e.type = comp.value("type", std::string());
-                e.color = comp.value("color", std::string("black"));
-                e.thickness = comp.value("thickness", 1);
-                e.x = comp.value("x", 0);
-                e.y = comp.value("y", 0);
-                e.size = comp.value("size", 1);
-                e.rotationIndex = comp.value("rotationIndex", 0);
-                e.inputs = comp.value("inputs", 0);
-                e.outputs = comp.value("outputs", 0);
-                m_elements.push_back(e);
-            }
-        }
-
-        if (nl->contains("nets") && (*nl)["nets"].is_array()) {
-            for (const auto& net : (*nl)["nets"]) {
-                if (!net.contains("endpoints") || !net["endpoints"].is_array()) continue;
-                std::vector<json> endpoints;
-                for (const auto& ep : net["endpoints"]) endpoints.push_back(ep);
-                if (endpoints.size() == 2) {
-                    ConnectionInfo c;
-                    const auto& a = endpoints[0]; const auto& b = endpoints[1];
-                    c.aIndex = a.value("compId", -1); c.aPin = a.value("pin", -1);
-                    if (a.contains("pos") && a["pos"].is_array() && a["pos"].size() == 2) { c.x1 = a["pos"][0].get<int>(); c.y1 = a["pos"][1].get<int>(); }
-                    c.bIndex = b.value("compId", -1); c.bPin = b.value("pin", -1);
-                    if (b.contains("pos") && b["pos"].is_array() && b["pos"].size() == 2) { c.x2 = b["pos"][0].get<int>(); c.y2 = b["pos"][1].get<int>(); }
-                    if (net.contains("turningPoints") && net["turningPoints"].is_array()) for (const auto& p : net["turningPoints"]) if (p.is_array() && p.size() == 2) c.turningPoints.push_back(wxPoint(p[0].get<int>(), p[1].get<int>()));
-                    m_connections.push_back(c);
-                }
-                else if (endpoints.size() > 2) {
-                    const auto& center = endpoints[0];
-                    for (size_t k = 1; k < endpoints.size(); ++k) {
-                        const auto& other = endpoints[k];
-                        ConnectionInfo c;
-                        c.aIndex = center.value("compId", -1); c.aPin = center.value("pin", -1);
-                        if (center.contains("pos") && center["pos"].is_array() && center["pos"].size() == 2) { c.x1 = center["pos"][0].get<int>(); c.y1 = center["pos"][1].get<int>(); }
-                        c.bIndex = other.value("compId", -1); c.bPin = other.value("pin", -1);
-                        if (other.contains("pos") && other["pos"].is_array() && other["pos"].size() == 2) { c.x2 = other["pos"][0].get<int>(); c.y2 = other["pos"][1].get<int>(); }
-                        m_connections.push_back(c);
-                    }
-                }
-            }
-        }
-        else if (nl->contains("connections") && (*nl)["connections"].is_array()) {
-            for (const auto& cjs : (*nl)["connections"]) {
-                ConnectionInfo c;
-                c.aIndex = cjs.value("a", -1); c.aPin = cjs.value("aPin", -1);
-                c.bIndex = cjs.value("b", -1); c.bPin = cjs.value("bPin", -1);
-                c.x1 = cjs.value("x1", 0); c.y1 = cjs.value("y1", 0);
-                c.x2 = cjs.value("x2", 0); c.y2 = cjs.value("y2", 0);
-                c.aConn = cjs.value("aConn", -1); c.aConnAux = cjs.value("aConnAux", -1);
-                if (cjs.contains("turningPoints") && cjs["turningPoints"].is_array()) for (const auto& p : cjs["turningPoints"]) if (p.is_array() && p.size() == 2) c.turningPoints.push_back(wxPoint(p[0].get<int>(), p[1].get<int>()));
-                if (cjs.contains("auxOutputs") && cjs["auxOutputs"].is_array()) {
-                    for (const auto& av : cjs["auxOutputs"]) {
-                        ConnectionInfo::AuxOutput ao;
-                        if (av.is_object()) { ao.segIndex = av.value("seg", 0); ao.t = av.value("t", 0.0); }
-                        else if (av.is_array() && av.size() == 2) {
-                            int px = av[0].get<int>(); int py = av[1].get<int>();
-                            std::vector<wxPoint> poly; poly.emplace_back(c.x1, c.y1);
-                            for (const auto& tp : c.turningPoints) poly.push_back(tp);
-                            poly.emplace_back(c.x2, c.y2);
-                            int seg; double t; wxPoint q;
-                            std::tie(seg, t, q) = ProjectPointToPolylineDetailed(wxPoint(px, py), poly);
-                            ao.segIndex = seg < 0 ? 0 : seg;
-                            ao.t = t;
-                        }
-                        c.auxOutputs.push_back(ao);
-                    }
-                }
-                m_connections.push_back(c);
-            }
+        // 流式解析到临时模型，解析失败时当前设计保持不变
+        std::vector<ElementInfo> elements;
+        std::vector<ConnectionInfo> connections;
+        std::string error;
+        if (!ReadNetlistJson(filename, elements, connections, &error)) {
+            wxMessageBox(wxString("读取或解析网表失败: ") + error.c_str(), "Import Error", wxOK | wxICON_ERROR);
+            return false;
         }
+        SaveStateForUndo();
+        m_elements.swap(elements);
+        m_connections.swap(connections);
+
+        m_pinIndex.Rebuild(m_elements.size(), m_connections);
+        m_obstacles.Rebuild(m_elements);
+        MinimapReset();
+        m_dirty = true;
+        ScheduleAutosave();
+        m_backValid = false; RebuildBackbuffer(); Refresh();
+        return true;
+    }
 
-        bool saved = SaveElementsAndConnectionsToFile();
-        if (!saved) wxMessageBox("导入成功，但保存到 Elementlib.json 失败（可能没有写权限）。", "Import", wxOK | wxICON_WARNING);
+    // 导入 BookShelf 基准（.aux 或 .nodes），替换当前设计（可撤销）；不自动布线，连线按端点直连显示
+    bool ImportBookShelf(const std::string& path, BookShelfDesign& design, std::string* error)
+    {
+        if (!ReadBookShelf(path, design, error)) return false;
+        SaveStateForUndo();
+        m_elements = std::move(design.elements);
+        m_connections = std::move(design.connections);
+        design.elements.clear(); design.connections.clear();
+        m_pinIndex.Rebuild(m_elements.size(), m_connections);
+        m_obstacles.Rebuild(m_elements);
+        MinimapReset();
+        m_dirty = true;
+        ScheduleAutosave();
         m_backValid = false; RebuildBackbuffer(); Refresh();
         return true;
     }
@@ -1401,26 +2042,139 @@ public:
         if (value != 0 && value != 1) return;
         if ((int)m_elementOutputs.size() != (int)m_elements.size()) m_elementOutputs.assign(m_elements.size(), -1);
         m_elementOutputs[elemIndex] = value;
-        PropagateSignals();
-        m_backValid = false;
-        RebuildBackbuffer();
+        SignalDelta delta = PropagateSignals();
+        delta.elements.push_back(elemIndex);
+        // 只重绘信号变化的连线与数值标签
+        UpdateSimOverlay(delta);
+    }
+
+    // ---- 性能 HUD ----
+    bool IsPerfHudVisible() const { return m_showPerfHud; }
+    void SetPerfHudVisible(bool show)
+    {
+        m_showPerfHud = show;
+        if (show) m_perfTimer.Start(PerfRefreshMs);
+        else m_perfTimer.Stop();
+        if (!m_perfHudRect.IsEmpty()) RefreshRect(m_perfHudRect);
         Refresh();
     }
 
+    // 状态栏摘要：各子系统 p50/p99
+    wxString PerfStatusText() const
+    {
+        return wxString::Format("rebuild %.1f/%.1f ms | paint %.1f/%.1f ms | route/drag %.0f calls %.1f/%.1f ms | sim %.0f it %.1f/%.1f ms | save %.1f/%.1f ms",
+            m_perf.rebuild.Percentile(0.5), m_perf.rebuild.Percentile(0.99),
+            m_perf.paint.Percentile(0.5), m_perf.paint.Percentile(0.99),
+            m_perf.routeCalls.Percentile(0.5), m_perf.routeMs.Percentile(0.5), m_perf.routeMs.Percentile(0.99),
+            m_perf.simIters.Percentile(0.5), m_perf.simMs.Percentile(0.5), m_perf.simMs.Percentile(0.99),
+            m_perf.save.Percentile(0.5), m_perf.save.Percentile(0.99));
+    }
+
+    // 定时刷新 HUD 区域与状态栏（统计在其它区域重绘时也会变化）
+    void OnPerfTimer(wxTimerEvent&)
+    {
+        if (!m_showPerfHud) return;
+        if (!m_perfHudRect.IsEmpty()) RefreshRect(m_perfHudRect);
+        ShowStatus(PerfStatusText());
+    }
+
+    // 左上角绘制各项耗时（设备坐标，叠在所有图层之上）
+    void DrawPerfHud(wxDC& dc)
+    {
+        dc.SetUserScale(1.0, 1.0);
+        dc.SetLogicalOrigin(0, 0);
+        const std::string lines[] = {
+            m_perf.rebuild.Summary("rebuild"),
+            m_perf.paint.Summary("paint"),
+            m_perf.routeCalls.Summary("route/drag", "calls"),
+            m_perf.routeMs.Summary("route ms"),
+            m_perf.simIters.Summary("sim iters", "iter"),
+            m_perf.simMs.Summary("sim"),
+            m_perf.save.Summary("save"),
+            m_perf.compact.Summary("compact"),
+            m_perf.place.Summary("place"),
+            m_perf.autoroute.Summary("autoroute"),
+            m_perf.ripup.Summary("rip-up"),
+        };
+        dc.SetFont(wxFont(8, wxFONTFAMILY_TELETYPE, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL));
+        int lineH = 0, maxW = 0;
+        for (const auto& l : lines) {
+            wxSize ext = dc.GetTextExtent(l);
+            lineH = std::max(lineH, ext.y);
+            maxW = std::max(maxW, ext.x);
+        }
+        const int pad = 4;
+        m_perfHudRect = wxRect(4, 4, maxW + 2 * pad, lineH * (int)(sizeof(lines) / sizeof(lines[0])) + 2 * pad);
+        dc.SetPen(wxPen(wxColour(128, 128, 128), 1));
+        dc.SetBrush(wxBrush(wxColour(255, 255, 224)));
+        dc.DrawRectangle(m_perfHudRect);
+        dc.SetTextForeground(wxColour(0, 0, 0));
+        int y = m_perfHudRect.y + pad;
+        for (const auto& l : lines) { dc.DrawText(l, m_perfHudRect.x + pad, y); y += lineH; }
+    }
+
 private:
     // 数据
     std::vector<ElementInfo> m_elements;
     std::vector<ConnectionInfo> m_connections;
+    PinOccupancyIndex m_pinIndex; // 随 m_connections 增删同步维护
+    ObstacleMap m_obstacles;      // 路由障碍图，随 m_elements 增删/移动同步维护
 
     // 仿真相关
     std::vector<int> m_connectionSignals; // -1 unknown, 0,1
     std::vector<int> m_elementOutputs;
     bool m_simulating;
 
-    // 后备位图
+    // 后备位图（静态几何层：网格、连线默认颜色、元件、端点）
     wxBitmap m_backBitmap;
     bool m_backValid;
 
+    // 仿真叠加层：静态层 + 按信号着色的连线与数值标签，信号变化时按脏矩形局部重绘
+    struct SignalDelta {
+        std::vector<int> connections;
+        std::vector<int> elements;
+    };
+    wxBitmap m_simBitmap;
+    bool m_simValid = false;
+    std::vector<wxRect> m_simWireBounds; // 每条连线叠加图形的世界坐标包围盒
+    // 叠加层位图按 SimBucketPx 像素分格，每格登记与之相交的连线/标签索引（RebuildSimOverlay 时建立）
+    std::vector<std::vector<int>> m_simWireBuckets;
+    std::vector<std::vector<int>> m_simLabelBuckets;
+    int m_simBucketCols = 0, m_simBucketRows = 0;
+    static constexpr int SimBucketPx = 64;
+    static constexpr size_t MaxSimDirtyRects = 64;
+    static constexpr int ElementPinRadius = 4;
+
+    // 视图变换：屏幕坐标 = (世界坐标 - m_viewOrigin) * m_zoom
+    double m_zoom = 1.0;
+    wxPoint m_viewOrigin{ 0, 0 };
+    static constexpr double MinZoom = 0.02;
+    static constexpr double MaxZoom = 4.0;
+    static constexpr int DensityCellPx = 4;
+
+    // 元件精灵缓存（缩放变化时自动失效，系统主题变化时手动清空）
+    ElementSpriteCache m_spriteCache;
+
+    // 性能统计：各子系统最近样本的滚动分位数，HUD 与状态栏显示
+    struct CanvasPerf {
+        RollingStat rebuild;     // RebuildBackbuffer 耗时
+        RollingStat paint;       // OnPaint 贴图与临时图形耗时（不含重建）
+        RollingStat routeCalls;  // 每次拖拽结束的路由调用次数
+        RollingStat routeMs;     // 每次拖拽结束的路由总耗时
+        RollingStat simIters;    // PropagateSignals 迭代轮数
+        RollingStat simMs;       // PropagateSignals 耗时
+        RollingStat save;        // 保存耗时（界面线程：追加日志或同步写出）
+        RollingStat compact;     // 后台整体写出耗时
+        RollingStat place;       // 自动布局耗时（不含随后的布线）
+        RollingStat autoroute;   // 整体协商布线耗时（不计入拖拽路由统计）
+        RollingStat ripup;       // 拆除重布（全部/可见）总耗时（不计入拖拽路由统计）
+    } m_perf;
+    bool m_showPerfHud = false;
+    wxTimer m_perfTimer;
+    wxRect m_perfHudRect;
+    static constexpr int PerfRefreshMs = 500;
+    static constexpr int DensitySaturation = 6;
+
     // 拖拽
     bool m_dragging;
     int m_dragIndex;
@@ -1428,6 +2182,52 @@ private:
     wxPoint m_dragStart;
     wxPoint m_dragCurrent;
     wxPoint m_prevDragCurrent;
+    wxPoint m_pendingDragPos;          // 合并后的最新拖拽位置
+    bool m_dragMovePending = false;    // 已排队 ProcessDragMove
+
+    // 拖拽时跟随的连线：先显示 L 形预览，后台完整路由完成后替换为路由结果
+    struct DragWire {
+        size_t conn = 0;
+        bool movesStart = false;       // 被拖元件是起点
+        bool movesEnd = false;         // 被拖元件是终点
+        wxPoint baseStart, baseEnd;    // 拖拽开始时的端点
+        wxPoint start, end;            // 当前端点
+        std::vector<wxPoint> turns;    // 后台路由得到的转折点（routed 时有效）
+        std::vector<wxPoint> poly;     // 当前显示的折线
+        bool routed = false;
+    };
+    std::vector<DragWire> m_dragWires;
+    std::vector<char> m_dragHiddenConn;  // 静态层中隐藏的连线（拖拽中由预览代替）
+    bool m_dragWiresInit = false;
+    LatestTaskWorker m_routeWorker;
+    // 后台详细布局：只有最新一次启动的结果有效
+    LatestTaskWorker m_placeWorker;
+    uint64_t m_placeGen = 0;
+    bool m_placeRunning = false;
+    // 自动保存：编辑日志与后台整体写出
+    DesignJournal m_journal;
+    JournalMark m_savedMark;             // 设计文件当前对应的日志位置
+    wxTimer m_autosaveTimer;
+    LatestTaskWorker m_saveWorker;
+    bool m_compactRunning = false;
+    bool m_compactAgain = false;         // 写出期间又有新的编辑
+    static constexpr const char* AutosaveFile = "Elementlib.json";
+    static constexpr const char* AutosaveBinary = "Elementlib.lgdb";
+    static constexpr const char* AutosaveBookShelf = "Elementlib";
+    static constexpr const char* JournalFile = "Elementlib.journal";
+    static constexpr int AutosaveQuietMs = 1500;
+    static constexpr uint64_t AutosaveMaxEntries = 200;  // 日志超过此条数时不等停顿直接整体写出
+    uint64_t m_dragRouteGen = 0;
+
+    // 连线预览的后台路由结果（与端点、起点元件一致时才使用）
+    struct ConnectPreview {
+        wxPoint start, end;
+        int exceptA = -1;
+        std::vector<wxPoint> turns;
+        bool valid = false;
+    } m_connectPreview;
+    uint64_t m_connectRouteGen = 0;
+    bool IsDragHidden(size_t ci) const { return ci < m_dragHiddenConn.size() && m_dragHiddenConn[ci]; }
 
     // 连线
     bool m_connecting;
@@ -1444,6 +2244,10 @@ private:
     // 选中
     int m_selectedIndex;
     PropertyPanel* m_propPanel;
+    MinimapPanel* m_minimap = nullptr;
+    void MinimapDirty(const wxRect& world) { if (m_minimap) m_minimap->InvalidateWorld(world); }
+    void MinimapConnectionChanged(size_t ci) { if (m_minimap) m_minimap->InvalidateConnection(ci); }
+    void MinimapReset() { if (m_minimap) m_minimap->InvalidateAll(); }
     int m_selectedConnectionIndex;
 
     // 未保存
@@ -1490,25 +2294,32 @@ private:
         return wxPoint(gx, gy);
     }
 
-    // 支持多个输出/输入分布
-    wxPoint GetOutputPoint(const ElementInfo& e, int pinIndex = 0) const {
-        int sz = std::max(1, e.size);
-        int w = BaseElemWidth * sz;
-        int h = BaseElemHeight * sz;
-        int n = std::max(1, e.outputs);
-        float step = (float)h / (n + 1);
-        int py = e.y + (int)(step * (pinIndex + 1));
-        return wxPoint(e.x + w, py);
-    }
-    wxPoint GetInputPoint(const ElementInfo& e, int pinIndex) const {
-        int sz = std::max(1, e.size);
-        int w = BaseElemWidth * sz;
-        int h = BaseElemHeight * sz;
-        int n = std::max(1, e.inputs);
-        float step = (float)h / (n + 1);
-        int py = e.y + (int)(step * (pinIndex + 1));
-        return wxPoint(e.x, py);
+    // 屏幕/世界坐标换算
+    wxPoint ScreenToWorld(const wxPoint& p) const {
+        return wxPoint(m_viewOrigin.x + (int)std::floor(p.x / m_zoom), m_viewOrigin.y + (int)std::floor(p.y / m_zoom));
+    }
+    wxPoint WorldToScreen(const wxPoint& p) const {
+        return wxPoint((int)std::lround((p.x - m_viewOrigin.x) * m_zoom), (int)std::lround((p.y - m_viewOrigin.y) * m_zoom));
+    }
+    wxRect WorldToScreen(const wxRect& r) const {
+        int x0 = (int)std::floor((r.x - m_viewOrigin.x) * m_zoom);
+        int y0 = (int)std::floor((r.y - m_viewOrigin.y) * m_zoom);
+        int x1 = (int)std::ceil((r.x + r.width - m_viewOrigin.x) * m_zoom);
+        int y1 = (int)std::ceil((r.y + r.height - m_viewOrigin.y) * m_zoom);
+        return wxRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
     }
+    wxRect VisibleWorldRect() const {
+        wxSize sz = GetClientSize();
+        return wxRect(m_viewOrigin.x, m_viewOrigin.y, (int)std::ceil(sz.x / m_zoom) + 1, (int)std::ceil(sz.y / m_zoom) + 1);
+    }
+    void ApplyViewTransform(wxDC& dc) const {
+        dc.SetUserScale(m_zoom, m_zoom);
+        dc.SetLogicalOrigin(m_viewOrigin.x, m_viewOrigin.y);
+    }
+
+    // 支持多个输出/输入分布
+    wxPoint GetOutputPoint(const ElementInfo& e, int pinIndex = 0) const { return ElementOutputPoint(e, pinIndex); }
+    wxPoint GetInputPoint(const ElementInfo& e, int pinIndex) const { return ElementInputPoint(e, pinIndex); }
     wxPoint GetConnectorPosition(int elemIndex, int pinIndex, bool isOutput) const {
         if (elemIndex < 0 || elemIndex >= (int)m_elements.size()) return wxPoint(0, 0);
         const ElementInfo& e = m_elements[elemIndex];
@@ -1538,7 +2349,7 @@ private:
         for (int ci = (int)m_connections.size() - 1; ci >= 0; --ci) {
             const auto& c = m_connections[ci];
             for (int ai = (int)c.auxOutputs.size() - 1; ai >= 0; --ai) {
-                wxPoint ap = AuxOutputToPixel(c.auxOutputs[ai], c, m_elements);
+                wxPoint ap = CachedAuxPixel(ci, ai);
                 if (DistanceSquared(ap, p) <= ConnectorRadius * ConnectorRadius) {
                     res.hit = true;
                     res.isOutput = true;
@@ -1600,56 +2411,26 @@ private:
         return poly;
     }
 
-    // 投影点到段，返回 t 与最近点
-    static std::pair<double, wxPoint> ProjectPointToSegmentT(const wxPoint& a, const wxPoint& b, const wxPoint& p) {
-        int dx = b.x - a.x;
-        int dy = b.y - a.y;
-        if (dx == 0 && dy == 0) return { 0.0, a };
-        double denom = double(dx) * dx + double(dy) * dy;
-        double t = ((p.x - a.x) * (double)dx + (p.y - a.y) * (double)dy) / denom;
-        if (t < 0.0) t = 0.0;
-        if (t > 1.0) t = 1.0;
-        wxPoint q((int)std::round(a.x + t * dx), (int)std::round(a.y + t * dy));
-        return { t, q };
-    }
+    // 确保连接 ci 的几何缓存有效（见 CircuitModel.h）
+    void EnsureConnectionGeometry(size_t ci) const { ::EnsureConnectionGeometry(m_elements, m_connections, ci); }
 
-    static std::tuple<int, double, wxPoint> ProjectPointToPolylineDetailed(const wxPoint& p, const std::vector<wxPoint>& pts) {
-        if (pts.size() < 2) return { -1, 0.0, p };
-        int bestSeg = -1;
-        double bestT = 0.0;
-        int bestSq = INT_MAX;
-        wxPoint bestPt = pts.front();
-        for (size_t i = 1; i < pts.size(); ++i) {
-            auto pr = ProjectPointToSegmentT(pts[i - 1], pts[i], p);
-            double t = pr.first;
-            wxPoint q = pr.second;
-            int dx = p.x - q.x;
-            int dy = p.y - q.y;
-            int d2 = dx * dx + dy * dy;
-            if (d2 < bestSq) {
-                bestSq = d2;
-                bestSeg = (int)i - 1;
-                bestT = t;
-                bestPt = q;
-            }
-        }
-        return { bestSeg, bestT, bestPt };
+    // 读取缓存的折线 / aux 点像素位置（按需重算，命中时不分配内存）
+    const std::vector<wxPoint>& ConnectionPolyline(size_t ci) const
+    {
+        EnsureConnectionGeometry(ci);
+        return m_connections[ci].geom.poly;
+    }
+    wxPoint CachedAuxPixel(size_t ci, size_t ai) const
+    {
+        EnsureConnectionGeometry(ci);
+        const auto& px = m_connections[ci].geom.auxPixels;
+        return ai < px.size() ? px[ai] : wxPoint(m_connections[ci].x1, m_connections[ci].y1);
     }
 
     static wxPoint AuxOutputToPixel(const ConnectionInfo::AuxOutput& ao, const ConnectionInfo& c, const std::vector<ElementInfo>& elements) {
         auto poly = BuildConnectionPolyline(c, elements);
         if (poly.size() < 2) return wxPoint(c.x1, c.y1);
-        int seg = ao.segIndex;
-        if (seg < 0) seg = 0;
-        if (seg >= (int)poly.size() - 1) seg = (int)poly.size() - 2;
-        const wxPoint& a = poly[seg];
-        const wxPoint& b = poly[seg + 1];
-        int dx = b.x - a.x;
-        int dy = b.y - a.y;
-        double t = ao.t;
-        if (t < 0.0) t = 0.0;
-        if (t > 1.0) t = 1.0;
-        return wxPoint((int)std::round(a.x + t * dx), (int)std::round(a.y + t * dy));
+        return PointOnPolyline(poly, ao);
     }
 
     // FindConnectionSegmentHit：返回最近 segment 的 conn/seg/t/nearest
@@ -1663,7 +2444,7 @@ private:
 
         for (int ci = 0; ci < (int)m_connections.size(); ci++) {
             const auto& c = m_connections[ci];
-            std::vector<wxPoint> pts = BuildConnectionPolyline(c, m_elements);
+            const std::vector<wxPoint>& pts = ConnectionPolyline(ci);
             for (size_t i = 1; i < pts.size(); ++i) {
                 auto pr = ProjectPointToSegmentT(pts[i - 1], pts[i], p);
                 double t = pr.first;
@@ -1681,7 +2462,7 @@ private:
                 }
             }
             for (int ai = 0; ai < (int)c.auxOutputs.size(); ++ai) {
-                wxPoint ap = AuxOutputToPixel(c.auxOutputs[ai], c, m_elements);
+                wxPoint ap = CachedAuxPixel(ci, ai);
                 int dx = p.x - ap.x;
                 int dy = p.y - ap.y;
                 int d2 = dx * dx + dy * dy;
@@ -1716,7 +2497,7 @@ private:
 
         if (c.aIndex >= 0) {
             if (c.aIndex >= (int)m_elements.size()) return false;
-            if (c.aPin < -1 || c.aPin > 0) return false;
+            if (c.aPin < -1 || c.aPin >= std::max(1, m_elements[c.aIndex].outputs)) return false;
         }
         else {
             if (c.aConn >= 0) {
@@ -1730,10 +2511,16 @@ private:
     }
 
     void CleanConnections() {
+        bool allValid = true;
+        for (const auto& c : m_connections) if (!IsConnectionValid(c)) { allValid = false; break; }
+        if (allValid) return;
         std::vector<ConnectionInfo> keep;
         keep.reserve(m_connections.size());
         for (const auto& c : m_connections) if (IsConnectionValid(c)) keep.push_back(c);
-        if (keep.size() != m_connections.size()) m_connections.swap(keep);
+        if (keep.size() != m_connections.size()) {
+            m_connections.swap(keep);
+            m_pinIndex.Rebuild(m_elements.size(), m_connections);
+        }
     }
 
     // Load / Save
@@ -1741,144 +2528,179 @@ private:
     {
         m_elements.clear();
         m_connections.clear();
-        std::ifstream file("Elementlib.json");
-        if (!file.is_open()) { m_dirty = false; return; }
-        try {
-            json j; file >> j;
-            if (j.contains("elements") && j["elements"].is_array()) {
-                for (const auto& comp : j["elements"]) {
-                    ElementInfo e;
-                    e.type = comp.value("type", std::string());
-                    e.color = comp.value("color", std::string("black"));
-                    e.thickness = comp.value("thickness", 1);
-                    e.x = comp.value("x", 0);
-                    e.y = comp.value("y", 0);
-                    e.size = comp.value("size", 1);
-                    e.rotationIndex = comp.value("rotationIndex", 0);
-                    e.inputs = comp.value("inputs", 0);
-                    e.outputs = comp.value("outputs", 0);
-                    m_elements.push_back(e);
-                }
-            }
-            if (j.contains("connections") && j["connections"].is_array()) {
-                for (const auto& c : j["connections"]) {
-                    ConnectionInfo ci;
-                    ci.aIndex = c.value("a", -1);
-                    ci.aPin = c.value("aPin", -1);
-                    ci.bIndex = c.value("b", -1);
-                    ci.bPin = c.value("bPin", -1);
-                    ci.x1 = c.value("x1", 0);
-                    ci.y1 = c.value("y1", 0);
-                    ci.x2 = c.value("x2", 0);
-                    ci.y2 = c.value("y2", 0);
-                    ci.aConn = c.value("aConn", -1);
-                    ci.aConnAux = c.value("aConnAux", -1);
-                    if (c.contains("turningPoints") && c["turningPoints"].is_array()) {
-                        for (const auto& p : c["turningPoints"]) ci.turningPoints.push_back(wxPoint(p[0], p[1]));
-                    }
-                    if (c.contains("auxOutputs") && c["auxOutputs"].is_array()) {
-                        for (const auto& av : c["auxOutputs"]) {
-                            ConnectionInfo::AuxOutput ao;
-                            if (av.is_object()) {
-                                ao.segIndex = av.value("seg", 0);
-                                ao.t = av.value("t", 0.0);
-                            }
-                            else if (av.is_array() && av.size() == 2) {
-                                int px = av[0].get<int>();
-                                int py = av[1].get<int>();
-                                std::vector<wxPoint> poly;
-                                poly.emplace_back(ci.x1, ci.y1);
-                                for (const auto& tp : ci.turningPoints) poly.push_back(tp);
-                                poly.emplace_back(ci.x2, ci.y2);
-                                int seg; double t; wxPoint q;
-                                std::tie(seg, t, q) = ProjectPointToPolylineDetailed(wxPoint(px, py), poly);
-                                ao.segIndex = seg < 0 ? 0 : seg;
-                                ao.t = t;
-                            }
-                            ci.auxOutputs.push_back(ao);
-                        }
-                    }
-                    m_connections.push_back(ci);
-                }
-            }
+        JournalMark mark;
+        // 二进制文件不比 JSON 旧时直接映射读取（JSON 可能被手工编辑过，此时以 JSON 为准）
+        if (!PreferBinaryAutosave() || !LoadDesignBinary(AutosaveBinary, m_elements, m_connections, &mark)) {
+            m_elements.clear();
+            m_connections.clear();
+            mark = JournalMark();
+            LoadDesignFile(AutosaveFile, m_elements, m_connections, &mark);
         }
-        catch (...) {}
+        m_savedMark = mark;
+        // 上次没有正常退出时，日志中还有未并入设计文件的编辑，在文件内容之上重放
+        m_journal.Capture(m_elements, m_connections);
+        uint64_t journalBytes = 0;
+        const uint64_t replayedSeq = ReplayDesignJournal(JournalFile, mark, m_elements, m_connections, &journalBytes);
+        const bool replayed = replayedSeq > mark.seq;
+        // 重放后的模型就是日志当前记录到的内容，之后相对它比较
+        if (replayed) m_journal.Capture(m_elements, m_connections);
         CleanConnections();
+        m_pinIndex.Rebuild(m_elements.size(), m_connections);
+        m_obstacles.Rebuild(m_elements);
+        MinimapReset();
         m_dirty = false;
         m_backValid = false;
         m_connectionSignals.clear();
         m_elementOutputs.clear();
+
+        if (!replayed) {
+            // 日志中没有设计文件之外的编辑：从设计文件的编号重新开始
+            if (mark.base == 0) mark = JournalMark{ DesignJournal::NewBase(), 0 };
+            m_journal.Restart(JournalFile, mark);
+            if (!AppendToJournal() || PendingJournalEntries() > 0) m_autosaveTimer.StartOnce(AutosaveQuietMs);
+            return;
+        }
+        // 重放过的编辑只在日志里：保留日志（截掉写坏的末尾）接着追加，直到后台整体写出成功才截断。
+        // 接不上或追加失败时不能换新日志（会丢掉这些编辑），改为同步整体写出
+        DesignJournal::AppendResult r = DesignJournal::AppendResult::Failed;
+        if (m_journal.Resume(JournalFile, JournalMark{ mark.base, replayedSeq }, journalBytes))
+            r = m_journal.Append(m_elements, m_connections);
+        if (r == DesignJournal::AppendResult::Unchanged || r == DesignJournal::AppendResult::Appended)
+            m_autosaveTimer.StartOnce(AutosaveQuietMs);
+        else if (!CompactNow())
+            ShowStatus("自动保存失败：恢复的编辑无法写入 Elementlib.json（可能没有写权限）");
     }
 
-    bool SaveElementsAndConnectionsToFile(const std::string& filename = "Elementlib.json")
+    // 同步整体写出当前模型并以新编号重新开始日志；JSON 与二进制都写不出时返回 false，现有日志保持不动
+    bool CompactNow()
     {
-        for (auto& c : m_connections) {
-            if (c.aIndex >= 0 && c.aIndex < (int)m_elements.size()) {
-                wxPoint p = GetConnectorPosition(c.aIndex, c.aPin, true);
-                c.x1 = p.x; c.y1 = p.y;
-            }
-            if (c.bIndex >= 0 && c.bIndex < (int)m_elements.size()) {
-                wxPoint p = GetConnectorPosition(c.bIndex, c.bPin, false);
-                c.x2 = p.x; c.y2 = p.y;
-            }
-            if (c.aConn >= 0 && c.aConn < (int)m_connections.size() && c.aConnAux >= 0) {
-                const auto& parent = m_connections[c.aConn];
-                if (c.aConnAux < (int)parent.auxOutputs.size()) {
-                    wxPoint p = AuxOutputToPixel(parent.auxOutputs[c.aConnAux], parent, m_elements);
-                    c.x1 = p.x; c.y1 = p.y;
-                }
-            }
+        const JournalMark mark{ DesignJournal::NewBase(), 0 };
+        const bool jsonOk = SaveDesignFile(AutosaveFile, m_elements, m_connections, mark);
+        if (!SaveDesignBinary(AutosaveBinary, m_elements, m_connections, mark) && !jsonOk) return false;
+        WriteBookShelf(AutosaveBookShelf, m_elements, m_connections);
+        m_savedMark = mark;
+        m_journal.Restart(JournalFile, mark);
+        m_journal.Capture(m_elements, m_connections);
+        return true;
+    }
+
+    static bool PreferBinaryAutosave()
+    {
+        std::error_code ec;
+        const auto bin = std::filesystem::last_write_time(AutosaveBinary, ec);
+        if (ec) return false;
+        const auto text = std::filesystem::last_write_time(AutosaveFile, ec);
+        return ec || bin >= text;
+    }
+
+    // 自动保存：变化立即追加到编辑日志（代价与改动量成正比），
+    // 停顿 AutosaveQuietMs 后在后台把模型副本整体写到 Elementlib.json 与 BookShelf 文件并截断日志；
+    // 写出结果在 FinishCompaction 中报告。hint 为本次编辑改动过的下标（见 DesignJournal::Append），
+    // 给出时记录日志的代价与设计规模无关
+    void ScheduleAutosave(const JournalHint* hint = nullptr)
+    {
+        PerfTimer saveTimer;
+        if (!AppendToJournal(hint) || PendingJournalEntries() >= AutosaveMaxEntries) StartCompaction();
+        else if (PendingJournalEntries() > 0) m_autosaveTimer.StartOnce(AutosaveQuietMs);
+        m_dirty = false;
+        m_perf.save.Add(saveTimer.ElapsedMs());
+    }
+
+    // 把模型变化追加到日志；变化过多或写入失败时换用新编号重新开始日志并返回 false，此时应尽快整体写出
+    bool AppendToJournal(const JournalHint* hint = nullptr)
+    {
+        DesignJournal::AppendResult r = m_journal.Append(m_elements, m_connections, hint);
+        if (r == DesignJournal::AppendResult::Unchanged || r == DesignJournal::AppendResult::Appended) return true;
+        m_journal.Restart(JournalFile, JournalMark{ DesignJournal::NewBase(), 0 });
+        m_journal.Capture(m_elements, m_connections);
+        return false;
+    }
+
+    // 日志中尚未并入设计文件的记录数；编号不同说明设计文件落后于整个日志
+    uint64_t PendingJournalEntries() const
+    {
+        const JournalMark cur = m_journal.Mark();
+        if (cur.base != m_savedMark.base) return cur.seq + 1;
+        return cur.seq > m_savedMark.seq ? cur.seq - m_savedMark.seq : 0;
+    }
+
+    // 在后台整体写出当前模型的副本；已有写出在进行时，待其完成后再写一次
+    void StartCompaction()
+    {
+        m_autosaveTimer.Stop();
+        if (m_compactRunning) { m_compactAgain = true; return; }
+        CleanConnections();
+        AppendToJournal();
+        if (PendingJournalEntries() == 0) return;
+        const JournalMark mark = m_journal.Mark();
+        auto elements = std::make_shared<const std::vector<ElementInfo>>(m_elements);
+        auto connections = std::make_shared<const std::vector<ConnectionInfo>>(m_connections);
+        m_compactRunning = true;
+        m_saveWorker.Submit([this, mark, elements, connections](const std::atomic<bool>& cancelled) {
+            PerfTimer timer;
+            // 二进制最后写，修改时间不早于 JSON，启动时据此优先读取
+            bool ok = SaveDesignFile(AutosaveFile, *elements, *connections, mark, &cancelled);
+            if (cancelled) return;
+            ok = SaveDesignBinary(AutosaveBinary, *elements, *connections, mark, &cancelled) && ok;
+            if (cancelled) return;
+            ok = WriteBookShelf(AutosaveBookShelf, *elements, *connections) && ok;
+            const double ms = timer.ElapsedMs();
+            CallAfter([this, mark, ok, ms]() { FinishCompaction(mark, ok, ms); });
+        });
+    }
+
+    void FinishCompaction(const JournalMark& mark, bool ok, double ms)
+    {
+        m_compactRunning = false;
+        m_perf.compact.Add(ms);
+        if (!ok) ShowStatus("自动保存失败：无法写入 Elementlib.json（可能没有写权限）");
+        if (ok) {
+            m_savedMark = mark;
+            // 写出期间没有新的编辑：日志内容已全部并入设计文件
+            const JournalMark cur = m_journal.Mark();
+            if (cur.base == mark.base && cur.seq == mark.seq) m_journal.Restart(JournalFile, mark);
         }
+        if (m_compactAgain) {
+            m_compactAgain = false;
+            m_autosaveTimer.StartOnce(AutosaveQuietMs);
+        }
+    }
+
+    // 退出前：停下后台写出，已记入日志但尚未并入设计文件的编辑同步写出（未记入日志的改动视为放弃）
+    void FlushAutosave()
+    {
+        m_autosaveTimer.Stop();
+        m_saveWorker.Stop();
+        if (PendingJournalEntries() == 0) return;
+        const JournalMark mark = m_journal.Mark();
+        const bool jsonOk = SaveDesignFile(AutosaveFile, m_elements, m_connections, mark);
+        if (!SaveDesignBinary(AutosaveBinary, m_elements, m_connections, mark) && !jsonOk) return;
+        WriteBookShelf(AutosaveBookShelf, m_elements, m_connections);
+        m_journal.Restart(JournalFile, mark);
+    }
+
+    // 同步写出到指定文件（另存为/导出）
+    bool SaveElementsAndConnectionsToFile(const std::string& filename)
+    {
+        PerfTimer saveTimer;
+        bool ok = WriteDesignFile(filename);
+        m_perf.save.Add(saveTimer.ElapsedMs());
+        return ok;
+    }
+
+    bool WriteDesignFile(const std::string& filename)
+    {
         CleanConnections();
-        try {
-            json j; j["elements"] = json::array();
-            for (const auto& e : m_elements) {
-                json item;
-                item["type"] = e.type;
-                item["color"] = e.color;
-                item["thickness"] = e.thickness;
-                item["x"] = e.x; item["y"] = e.y;
-                item["size"] = e.size;
-                item["rotationIndex"] = e.rotationIndex;
-                item["inputs"] = e.inputs;
-                item["outputs"] = e.outputs;
-                j["elements"].push_back(item);
-            }
-            j["connections"] = json::array();
-            for (const auto& c : m_connections) {
-                json cj;
-                cj["a"] = c.aIndex; cj["aPin"] = c.aPin;
-                cj["b"] = c.bIndex; cj["bPin"] = c.bPin;
-                cj["x1"] = c.x1; cj["y1"] = c.y1;
-                cj["x2"] = c.x2; cj["y2"] = c.y2;
-                cj["aConn"] = c.aConn; cj["aConnAux"] = c.aConnAux;
-                cj["turningPoints"] = json::array();
-                for (const auto& p : c.turningPoints) cj["turningPoints"].push_back({ p.x, p.y });
-                cj["auxOutputs"] = json::array();
-                for (const auto& ao : c.auxOutputs) {
-                    wxPoint pt = AuxOutputToPixel(ao, c, m_elements);
-                    json ajo; ajo["seg"] = ao.segIndex; ajo["t"] = ao.t; ajo["pos"] = { pt.x, pt.y };
-                    cj["auxOutputs"].push_back(ajo);
-                }
-                j["connections"].push_back(cj);
-            }
-            std::ofstream ofs(filename);
-            if (!ofs.is_open()) return false;
-            ofs << j.dump(4);
-            ofs.close();
-
-            std::string base = filename;
-            size_t pos = base.find_last_of('.');
-            if (pos != std::string::npos) base = base.substr(0, pos);
-            std::string nodeFile = base + ".node";
-            std::string netFile = base + ".net";
-            bool bsOk = ExportBookShelf(nodeFile, netFile);
-            m_dirty = false;
-            return bsOk;
-        }
-        catch (...) {
-            return false;
+        if (IsDesignBinaryPath(filename)) {
+            if (!SaveDesignBinary(filename, m_elements, m_connections)) return false;
         }
+        else if (!SaveDesignFile(filename, m_elements, m_connections)) return false;
+        std::string base = filename;
+        size_t pos = base.find_last_of('.');
+        if (pos != std::string::npos) base = base.substr(0, pos);
+        bool bsOk = ExportBookShelf(base);
+        m_dirty = false;
+        return bsOk;
     }
 
 
@@ -1896,6 +2718,7 @@ private:
     void StopSimulation()
     {
         m_simulating = false;
+        m_simValid = false;
         m_connectionSignals.clear();
         m_elementOutputs.clear();
         m_backValid = false; RebuildBackbuffer(); Refresh();
@@ -1908,11 +2731,16 @@ private:
     }
 
     // PropagateSignals：两步迭代直到稳定（简化规则：元素输出 = invert(first known input)；Input 元件输出由 m_elementOutputs 固定）
-    void PropagateSignals()
+    // 返回本次传播中信号发生变化的连线与元件，供仿真叠加层局部重绘
+    SignalDelta PropagateSignals()
     {
-        if (m_connections.empty()) return;
+        PerfTimer simTimer;
+        SignalDelta delta;
+        if (m_connections.empty()) return delta;
         if ((int)m_connectionSignals.size() != (int)m_connections.size()) m_connectionSignals.assign(m_connections.size(), -1);
         if ((int)m_elementOutputs.size() != (int)m_elements.size()) m_elementOutputs.assign(m_elements.size(), -1);
+        const std::vector<int> prevConnectionSignals = m_connectionSignals;
+        const std::vector<int> prevElementOutputs = m_elementOutputs;
 
         bool changed = true;
         int iter = 0;
@@ -1985,10 +2813,26 @@ private:
             }
         }
 
+        for (size_t ci = 0; ci < m_connectionSignals.size(); ++ci)
+            if (m_connectionSignals[ci] != prevConnectionSignals[ci]) delta.connections.push_back((int)ci);
+        for (size_t ei = 0; ei < m_elementOutputs.size(); ++ei)
+            if (m_elementOutputs[ei] != prevElementOutputs[ei]) delta.elements.push_back((int)ei);
+        m_perf.simIters.Add(std::min(iter, maxIter));
+        m_perf.simMs.Add(simTimer.ElapsedMs());
+        return delta;
     }
 
-    // RebuildBackbuffer & 绘制
+    // RebuildBackbuffer & 绘制：先重建静态层，仿真态再整体重建叠加层
     void RebuildBackbuffer()
+    {
+        PerfTimer rebuildTimer;
+        RebuildStaticLayer();
+        m_simValid = false;
+        if (m_simulating && m_backValid) RebuildSimOverlay();
+        m_perf.rebuild.Add(rebuildTimer.ElapsedMs());
+    }
+
+    void RebuildStaticLayer()
     {
         wxSize sz = GetClientSize();
         if (sz.x <= 0 || sz.y <= 0) { m_backValid = false; return; }
@@ -1996,25 +2840,38 @@ private:
         wxMemoryDC mdc(m_backBitmap);
         mdc.SetBackground(wxBrush(GetBackgroundColour()));
         mdc.Clear();
+
+        LodTier tier = SelectLodTier(m_zoom);
+        if (tier == LodTier::Density) {
+            DrawDensityRaster(mdc, sz);
+            mdc.SelectObject(wxNullBitmap);
+            m_backValid = true;
+            return;
+        }
+
+        ApplyViewTransform(mdc);
         DrawGrid(mdc);
 
+        // 视口裁剪：只绘制与可见区域相交的连线与元件
+        wxRect view = VisibleWorldRect();
+        view.Inflate(20, 20);
+        const bool full = (tier == LodTier::Full);
+        const double wireTol = LodWirePixelTolerance / m_zoom;
+
         const int auxRadius = 3;
         for (size_t ci = 0; ci < m_connections.size(); ++ci) {
+            if (IsDragHidden(ci)) continue;
             const auto& c = m_connections[ci];
-            ConnectionInfo tc = c;
-            if (tc.aConn >= 0 && tc.aConn < (int)m_connections.size() && tc.aConnAux >= 0) {
-                const auto& parent = m_connections[tc.aConn];
-                if (tc.aConnAux < (int)parent.auxOutputs.size()) {
-                    wxPoint sp = AuxOutputToPixel(parent.auxOutputs[tc.aConnAux], parent, m_elements);
-                    tc.x1 = sp.x; tc.y1 = sp.y;
-                }
-            }
-            bool isOutputToInput = ((tc.aIndex >= 0) || (tc.aConn >= 0)) && (tc.bIndex >= 0);
+            const std::vector<wxPoint>& poly = ConnectionPolyline(ci);
+            if (!view.Intersects(PolylineBounds(poly))) continue;
+            bool isOutputToInput = ((c.aIndex >= 0) || (c.aConn >= 0)) && (c.bIndex >= 0);
             wxColour lineColor = isOutputToInput ? wxColour(0, 128, 0) : wxColour(0, 0, 0);
-            // 仿真态时根据信号显示颜色
-            if (m_simulating && (int)ci < (int)m_connectionSignals.size() && m_connectionSignals[ci] != -1) {
-                int sig = m_connectionSignals[ci];
-                lineColor = (sig == 0) ? wxColour(30, 144, 255) : wxColour(0, 160, 0);
+            // 简化层级：合并近似共线的折段，不画 aux 点
+            if (!full) {
+                mdc.SetPen(wxPen(lineColor, 2));
+                std::vector<wxPoint> simple = SimplifyPolylineForLod(poly, wireTol);
+                mdc.DrawLines((int)simple.size(), simple.data());
+                continue;
             }
             // 选中高亮
             if ((int)ci == m_selectedConnectionIndex) {
@@ -2023,92 +2880,387 @@ private:
             else {
                 mdc.SetPen(wxPen(lineColor, 2));
             }
-            DrawConnection(mdc, tc, m_elements, lineColor);
+            DrawConnection(mdc, poly, lineColor);
 
             mdc.SetBrush(wxBrush(lineColor));
             mdc.SetPen(wxPen(lineColor, 1));
-            for (const auto& ao : c.auxOutputs) {
-                wxPoint pt = AuxOutputToPixel(ao, c, m_elements);
-                mdc.DrawCircle(pt.x, pt.y, auxRadius);
-            }
+            for (const auto& pt : c.geom.auxPixels) mdc.DrawCircle(pt.x, pt.y, auxRadius);
         }
 
         // 元件绘制
+        if (!full) {
+            // 简化层级：只画外框，颜色未变化时复用画笔
+            mdc.SetBrush(*wxWHITE_BRUSH);
+            const ElementInfo* penOwner = nullptr;
+            for (const auto& comp : m_elements) {
+                if (!view.Intersects(ElementRect(wxPoint(comp.x, comp.y), comp.size))) continue;
+                if (!penOwner || penOwner->color != comp.color || penOwner->thickness != comp.thickness) {
+                    mdc.SetPen(wxPen(wxColour(comp.color), comp.thickness));
+                    penOwner = &comp;
+                }
+                DrawElementBox(mdc, comp.x, comp.y, comp.size);
+            }
+            mdc.SelectObject(wxNullBitmap);
+            m_backValid = true;
+            return;
+        }
+        // 完整层级：元件以精灵贴图绘制（设备坐标），每种外观只渲染一次
+        mdc.SetUserScale(1.0, 1.0);
+        mdc.SetLogicalOrigin(0, 0);
         for (const auto& comp : m_elements) {
-            DrawElement(mdc, comp.type, comp.color, comp.thickness, comp.x, comp.y, comp.size);
+            if (!view.Intersects(ElementRect(wxPoint(comp.x, comp.y), comp.size))) continue;
+            wxPoint dev = WorldToScreen(wxPoint(comp.x, comp.y));
+            m_spriteCache.Draw(mdc, comp.type, comp.color, comp.thickness, comp.size, m_zoom, dev.x, dev.y);
         }
+        ApplyViewTransform(mdc);
 
-        // 绘制端点与仿真值显示
-        const int pinRadius = 4;
+        // 绘制端点（仿真数值在叠加层绘制）
         for (int i = 0; i < (int)m_elements.size(); ++i) {
             const ElementInfo& e = m_elements[i];
-            // 输出端点
-            if (e.type != "Output") {
-                int nOutputs = std::max(0, e.outputs);
-                if (nOutputs == 0) nOutputs = 1;
-                for (int op = 0; op < nOutputs; ++op) {
-                    wxPoint outPt = GetOutputPoint(e, op);
-                    bool outConnected = false;
-                    for (const auto& c : m_connections) if (c.aIndex == i && c.aPin == op) { outConnected = true; break; }
-                    wxColour outColor = outConnected ? wxColour(0, 128, 0) : wxColour(30, 144, 255);
-                    mdc.SetBrush(wxBrush(outColor)); mdc.SetPen(wxPen(outColor, 1));
-                    mdc.DrawCircle(outPt.x, outPt.y, pinRadius);
-                }
+            if (view.Intersects(ElementRect(wxPoint(e.x, e.y), e.size))) DrawElementPins(mdc, i);
+        }
+
+        mdc.SelectObject(wxNullBitmap);
+        m_backValid = true;
+    }
+
+    // ---- 仿真叠加层 ----
+    static wxColour SignalColour(int sig) { return (sig == 0) ? wxColour(30, 144, 255) : wxColour(0, 160, 0); }
+
+    // 元件 i 的输入/输出端点（dc 需已应用视图变换），按是否已连接着色
+    void DrawElementPins(wxDC& dc, int i)
+    {
+        const int pinRadius = ElementPinRadius;
+        const ElementInfo& e = m_elements[i];
+        // 输出端点
+        if (e.type != "Output") {
+            int nOutputs = std::max(0, e.outputs);
+            if (nOutputs == 0) nOutputs = 1;
+            for (int op = 0; op < nOutputs; ++op) {
+                wxPoint outPt = GetOutputPoint(e, op);
+                bool outConnected = m_pinIndex.IsOutputUsed(i, op);
+                wxColour outColor = outConnected ? wxColour(0, 128, 0) : wxColour(30, 144, 255);
+                dc.SetBrush(wxBrush(outColor)); dc.SetPen(wxPen(outColor, 1));
+                dc.DrawCircle(outPt.x, outPt.y, pinRadius);
             }
-            // 输入端点
-            if (e.type != "Input") {
-                int nInputs = std::max(0, e.inputs);
-                if (nInputs == 0) nInputs = 1;
-                for (int pin = 0; pin < nInputs; ++pin) {
-                    wxPoint inPt = GetInputPoint(e, pin);
-                    bool inConnected = false;
-                    for (const auto& c : m_connections) if (c.bIndex == i && c.bPin == pin) { inConnected = true; break; }
-                    wxColour inColor = inConnected ? wxColour(0, 128, 0) : wxColour(30, 144, 255);
-                    mdc.SetBrush(wxBrush(inColor)); mdc.SetPen(wxPen(inColor, 1));
-                    mdc.DrawCircle(inPt.x, inPt.y, pinRadius);
-                }
+        }
+        // 输入端点
+        if (e.type != "Input") {
+            int nInputs = std::max(0, e.inputs);
+            if (nInputs == 0) nInputs = 1;
+            for (int pin = 0; pin < nInputs; ++pin) {
+                wxPoint inPt = GetInputPoint(e, pin);
+                bool inConnected = m_pinIndex.IsInputUsed(i, pin);
+                wxColour inColor = inConnected ? wxColour(0, 128, 0) : wxColour(30, 144, 255);
+                dc.SetBrush(wxBrush(inColor)); dc.SetPen(wxPen(inColor, 1));
+                dc.DrawCircle(inPt.x, inPt.y, pinRadius);
             }
+        }
+    }
 
-            // 仿真显示
-            if (m_simulating) {
-                if (IsInputType(e.type)) {
-                    int val = -1;
-                    if (i >= 0 && i < (int)m_elementOutputs.size()) val = m_elementOutputs[i];
-                    if (val != -1) {
-                        wxString vs = wxString::Format("%d", val);
-                        int fontSize = std::max(8, 12 * e.size);
-                        wxFont font(fontSize, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-                        mdc.SetFont(font);
-                        mdc.SetTextForeground(wxColour(0, 0, 0));
-                        int w = BaseElemWidth * std::max(1, e.size);
-                        int x = e.x + w / 2 - fontSize / 2;
-                        int y = e.y - fontSize - 4;
-                        mdc.DrawText(vs, x, y);
-                    }
-                }
-                else {
-                    int outv = -1; if (i >= 0 && i < (int)m_elementOutputs.size()) outv = m_elementOutputs[i];
-                    if (outv != -1) {
-                        wxString vs = wxString::Format("%d", outv);
-                        int fontSize = std::max(8, 12 * e.size);
-                        wxFont font(fontSize, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
-                        mdc.SetFont(font);
-                        mdc.SetTextForeground(wxColour(0, 0, 0));
-                        mdc.DrawText(vs, e.x + std::max(10, BaseElemWidth * e.size) + 6, e.y + BaseElemHeight * e.size / 2 - 8);
-                    }
-                }
+    // 在叠加层的信号连线之上补画元件 i（本体与端点），保持与静态层相同的层次：连线在下，元件在上
+    void DrawElementOnTop(wxDC& dc, int i, bool full)
+    {
+        const ElementInfo& e = m_elements[i];
+        if (!full) {
+            dc.SetBrush(*wxWHITE_BRUSH);
+            dc.SetPen(wxPen(wxColour(e.color), e.thickness));
+            DrawElementBox(dc, e.x, e.y, e.size);
+            return;
+        }
+        dc.SetUserScale(1.0, 1.0);
+        dc.SetLogicalOrigin(0, 0);
+        wxPoint dev = WorldToScreen(wxPoint(e.x, e.y));
+        m_spriteCache.Draw(dc, e.type, e.color, e.thickness, e.size, m_zoom, dev.x, dev.y);
+        ApplyViewTransform(dc);
+        DrawElementPins(dc, i);
+    }
+
+    // 元件本体连同端点圆的世界坐标包围盒
+    wxRect ElementPaintRect(const ElementInfo& e) const
+    {
+        wxRect r = ElementRect(wxPoint(e.x, e.y), e.size);
+        r.Inflate(ElementPinRadius + 1, ElementPinRadius + 1);
+        return r;
+    }
+
+    // 与世界矩形 r 相交的元件：经障碍图按区块查询候选，升序去重（与整体绘制的先后一致）
+    std::vector<int> ElementsInRect(const wxRect& r) const
+    {
+        wxRect q = r;
+        q.Inflate(ElementPinRadius + 1, ElementPinRadius + 1);
+        ObstacleMap::CellRect cells;
+        cells.gx0 = q.x / ObstacleMap::GridSize;
+        cells.gy0 = q.y / ObstacleMap::GridSize;
+        cells.gx1 = (q.x + q.width) / ObstacleMap::GridSize;
+        cells.gy1 = (q.y + q.height) / ObstacleMap::GridSize;
+        std::vector<int> out;
+        m_obstacles.ForEachElementNear(cells, [&](int ei) {
+            if (ei >= 0 && ei < (int)m_elements.size() && ElementPaintRect(m_elements[ei]).Intersects(r)) out.push_back(ei);
+        });
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    // 叠加层分桶：位图按 SimBucketPx 像素分格，世界矩形 world 覆盖的格子（闭区间），不在位图内时返回 false
+    bool SimBucketRange(const wxRect& world, int& c0, int& r0, int& c1, int& r1) const
+    {
+        wxRect dev = WorldToScreen(world).Intersect(wxRect(0, 0, m_simBucketCols * SimBucketPx, m_simBucketRows * SimBucketPx));
+        if (dev.IsEmpty()) return false;
+        c0 = dev.x / SimBucketPx; r0 = dev.y / SimBucketPx;
+        c1 = (dev.x + dev.width - 1) / SimBucketPx; r1 = (dev.y + dev.height - 1) / SimBucketPx;
+        return true;
+    }
+
+    void AddToSimBuckets(std::vector<std::vector<int>>& buckets, const wxRect& world, int idx)
+    {
+        int c0, r0, c1, r1;
+        if (!SimBucketRange(world, c0, r0, c1, r1)) return;
+        for (int r = r0; r <= r1; ++r)
+            for (int c = c0; c <= c1; ++c) buckets[(size_t)r * m_simBucketCols + c].push_back(idx);
+    }
+
+    // world 覆盖的格子中登记的条目，升序去重
+    std::vector<int> QuerySimBuckets(const std::vector<std::vector<int>>& buckets, const wxRect& world) const
+    {
+        std::vector<int> out;
+        int c0, r0, c1, r1;
+        if (buckets.size() != (size_t)m_simBucketCols * m_simBucketRows || !SimBucketRange(world, c0, r0, c1, r1)) return out;
+        for (int r = r0; r <= r1; ++r)
+            for (int c = c0; c <= c1; ++c) {
+                const auto& b = buckets[(size_t)r * m_simBucketCols + c];
+                out.insert(out.end(), b.begin(), b.end());
+            }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+
+    // 叠加层中是否有已知信号的连线与 world 相交（即其中的元件被信号连线盖住，需要补画）
+    bool SignalWireOver(const wxRect& world) const
+    {
+        int c0, r0, c1, r1;
+        if (!SimBucketRange(world, c0, r0, c1, r1)) return false;
+        for (int r = r0; r <= r1; ++r)
+            for (int c = c0; c <= c1; ++c)
+                for (int ci : m_simWireBuckets[(size_t)r * m_simBucketCols + c])
+                    if (ci < (int)m_connectionSignals.size() && m_connectionSignals[ci] != -1 && !IsDragHidden(ci)
+                        && m_simWireBounds[ci].Intersects(world)) return true;
+        return false;
+    }
+
+    // 仿真数值标签的位置与（世界坐标）包围盒
+    wxRect SimLabelRect(const ElementInfo& e, wxPoint* textPos = nullptr) const
+    {
+        int fontSize = std::max(8, 12 * e.size);
+        wxPoint pos;
+        if (IsInputType(e.type)) {
+            int w = BaseElemWidth * std::max(1, e.size);
+            pos = wxPoint(e.x + w / 2 - fontSize / 2, e.y - fontSize - 4);
+        }
+        else {
+            pos = wxPoint(e.x + std::max(10, BaseElemWidth * e.size) + 6, e.y + BaseElemHeight * e.size / 2 - 8);
+        }
+        if (textPos) *textPos = pos;
+        return wxRect(pos.x - 2, pos.y - 2, fontSize + 4, fontSize * 2 + 4);
+    }
+
+    // 已知信号的连线按信号着色重绘（未知信号保持静态层颜色），并补画两端端点与 aux 点
+    void DrawSignalWire(wxDC& dc, size_t ci, bool full, double wireTol)
+    {
+        if (ci >= m_connectionSignals.size() || m_connectionSignals[ci] == -1 || IsDragHidden(ci)) return;
+        const auto& c = m_connections[ci];
+        wxColour color = SignalColour(m_connectionSignals[ci]);
+        const std::vector<wxPoint>& poly = ConnectionPolyline(ci);
+        dc.SetPen(wxPen(color, 2));
+        if (!full) {
+            std::vector<wxPoint> simple = SimplifyPolylineForLod(poly, wireTol);
+            dc.DrawLines((int)simple.size(), simple.data());
+            return;
+        }
+        dc.DrawLines((int)poly.size(), poly.data());
+        dc.SetBrush(wxBrush(color));
+        dc.SetPen(wxPen(color, 1));
+        for (const auto& pt : c.geom.auxPixels) dc.DrawCircle(pt.x, pt.y, 3);
+        const wxColour pinColor(0, 128, 0);
+        dc.SetBrush(wxBrush(pinColor)); dc.SetPen(wxPen(pinColor, 1));
+        if (c.aIndex >= 0) dc.DrawCircle(poly.front().x, poly.front().y, 4);
+        if (c.bIndex >= 0) dc.DrawCircle(poly.back().x, poly.back().y, 4);
+    }
+
+    void DrawSignalLabel(wxDC& dc, size_t ei)
+    {
+        if (ei >= m_elementOutputs.size() || m_elementOutputs[ei] == -1) return;
+        const ElementInfo& e = m_elements[ei];
+        wxPoint pos;
+        SimLabelRect(e, &pos);
+        int fontSize = std::max(8, 12 * e.size);
+        dc.SetFont(wxFont(fontSize, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD));
+        dc.SetTextForeground(wxColour(0, 0, 0));
+        dc.DrawText(wxString::Format("%d", m_elementOutputs[ei]), pos.x, pos.y);
+    }
+
+    // 整体重建叠加层：复制静态层后绘制全部信号连线，补画被其盖住的元件，最后绘制标签（远景层级不显示信号）。
+    // 同时为可见范围内的连线与标签建立屏幕分桶，供局部更新查询
+    void RebuildSimOverlay()
+    {
+        m_simValid = false;
+        LodTier tier = SelectLodTier(m_zoom);
+        if (!m_backValid || tier == LodTier::Density) return;
+        int w = m_backBitmap.GetWidth(), h = m_backBitmap.GetHeight();
+        m_simBitmap = wxBitmap(w, h);
+        wxMemoryDC sdc(m_simBitmap);
+        {
+            wxMemoryDC bdc(m_backBitmap);
+            sdc.Blit(0, 0, w, h, &bdc, 0, 0);
+            bdc.SelectObject(wxNullBitmap);
+        }
+        ApplyViewTransform(sdc);
+        const bool full = (tier == LodTier::Full);
+        const double wireTol = LodWirePixelTolerance / m_zoom;
+        wxRect view = VisibleWorldRect();
+        view.Inflate(20, 20);
+
+        m_simBucketCols = (w + SimBucketPx - 1) / SimBucketPx;
+        m_simBucketRows = (h + SimBucketPx - 1) / SimBucketPx;
+        m_simWireBuckets.assign((size_t)m_simBucketCols * m_simBucketRows, std::vector<int>());
+        m_simLabelBuckets.assign(full ? m_simWireBuckets.size() : 0, std::vector<int>());
+
+        m_simWireBounds.assign(m_connections.size(), wxRect());
+        for (size_t ci = 0; ci < m_connections.size(); ++ci) {
+            wxRect bounds = PolylineBounds(ConnectionPolyline(ci));
+            bounds.Inflate(6, 6); // 线宽、端点与 aux 点半径
+            m_simWireBounds[ci] = bounds;
+            if (!view.Intersects(bounds)) continue;
+            AddToSimBuckets(m_simWireBuckets, bounds, (int)ci);
+            DrawSignalWire(sdc, ci, full, wireTol);
+        }
+        for (int ei = 0; ei < (int)m_elements.size(); ++ei) {
+            wxRect body = ElementPaintRect(m_elements[ei]);
+            if (view.Intersects(body) && SignalWireOver(body)) DrawElementOnTop(sdc, ei, full);
+        }
+        if (full) {
+            for (size_t ei = 0; ei < m_elements.size(); ++ei) {
+                wxRect label = SimLabelRect(m_elements[ei]);
+                if (!view.Intersects(label)) continue;
+                AddToSimBuckets(m_simLabelBuckets, label, (int)ei);
+                DrawSignalLabel(sdc, ei);
             }
         }
+        sdc.SelectObject(wxNullBitmap);
+        m_simValid = true;
+    }
 
-        mdc.SelectObject(wxNullBitmap);
-        m_backValid = true;
+    // 局部更新叠加层：对每个脏矩形先从静态层恢复，再在裁剪区内按 OnPaint 的层次重绘——
+    // 信号连线（分桶查询）、其上的元件（障碍图查询）、数值标签（分桶查询），不遍历全部连线与元件
+    void UpdateSimOverlay(const SignalDelta& delta)
+    {
+        if (!m_simulating) return;
+        if (!m_backValid || !m_simValid || m_simWireBounds.size() != m_connections.size()) {
+            RebuildBackbuffer(); Refresh(); return;
+        }
+        LodTier tier = SelectLodTier(m_zoom);
+        const bool full = (tier == LodTier::Full);
+        std::vector<wxRect> dirty;
+        for (int ci : delta.connections) if (ci >= 0 && ci < (int)m_simWireBounds.size()) dirty.push_back(m_simWireBounds[ci]);
+        if (full) for (int ei : delta.elements) if (ei >= 0 && ei < (int)m_elements.size()) dirty.push_back(SimLabelRect(m_elements[ei]));
+        if (dirty.empty()) return;
+        if (dirty.size() > MaxSimDirtyRects) { RebuildSimOverlay(); Refresh(); return; }
+
+        const double wireTol = LodWirePixelTolerance / m_zoom;
+        wxRect view = VisibleWorldRect();
+        wxRect bmpRect(0, 0, m_simBitmap.GetWidth(), m_simBitmap.GetHeight());
+        wxMemoryDC sdc(m_simBitmap);
+        wxMemoryDC bdc(m_backBitmap);
+        for (const wxRect& r : dirty) {
+            if (!view.Intersects(r)) continue;
+            wxRect dev = WorldToScreen(r).Intersect(bmpRect);
+            if (dev.IsEmpty()) continue;
+            sdc.DestroyClippingRegion();
+            sdc.SetUserScale(1.0, 1.0);
+            sdc.SetLogicalOrigin(0, 0);
+            sdc.Blit(dev.x, dev.y, dev.width, dev.height, &bdc, dev.x, dev.y);
+            ApplyViewTransform(sdc);
+            sdc.SetClippingRegion(r);
+            bool wireDrawn = false;
+            for (int ci : QuerySimBuckets(m_simWireBuckets, r)) {
+                if (!m_simWireBounds[ci].Intersects(r)) continue;
+                if (ci < (int)m_connectionSignals.size() && m_connectionSignals[ci] != -1) wireDrawn = true;
+                DrawSignalWire(sdc, ci, full, wireTol);
+            }
+            // 静态层中元件画在连线之上，信号连线重绘后把落在脏矩形内的元件补回上层
+            if (wireDrawn)
+                for (int ei : ElementsInRect(r)) DrawElementOnTop(sdc, ei, full);
+            if (full) {
+                for (int ei : QuerySimBuckets(m_simLabelBuckets, r))
+                    if (ei < (int)m_elements.size() && SimLabelRect(m_elements[ei]).Intersects(r)) DrawSignalLabel(sdc, ei);
+            }
+            RefreshRect(dev, false);
+        }
+        sdc.DestroyClippingRegion();
+        bdc.SelectObject(wxNullBitmap);
+        sdc.SelectObject(wxNullBitmap);
     }
 
+    // 网格点按世界坐标绘制（dc 需已应用视图变换），点距在屏幕上过密时不画
     void DrawGrid(wxDC& dc)
     {
+        if (10 * m_zoom < 4.0) return;
         dc.SetPen(*wxLIGHT_GREY_PEN);
-        int height, width; GetClientSize(&width, &height);
-        for (int i = 0; i < width; i += 10) for (int j = 0; j < height; j += 10) dc.DrawPoint(i, j);
+        wxRect view = VisibleWorldRect();
+        int x0 = (int)std::floor(view.x / 10.0) * 10;
+        int y0 = (int)std::floor(view.y / 10.0) * 10;
+        for (int i = x0; i < view.x + view.width; i += 10) for (int j = y0; j < view.y + view.height; j += 10) dc.DrawPoint(i, j);
+    }
+
+    // 远景层级：按 DensityCellPx 大小的屏幕格子统计元件覆盖数，生成栅格图后放大绘制
+    // dc 使用设备坐标（不应用视图变换）
+    void DrawDensityRaster(wxDC& dc, const wxSize& sz)
+    {
+        const int cell = DensityCellPx;
+        int cols = (sz.x + cell - 1) / cell;
+        int rows = (sz.y + cell - 1) / cell;
+        std::vector<uint16_t> counts((size_t)cols * rows, 0);
+        const double scale = m_zoom / cell; // 世界坐标 -> 格子坐标
+        for (const auto& e : m_elements) {
+            int s = std::max(1, e.size);
+            int c0 = (int)std::floor((e.x - m_viewOrigin.x) * scale);
+            int r0 = (int)std::floor((e.y - m_viewOrigin.y) * scale);
+            int c1 = (int)std::floor((e.x + BaseElemWidth * s - m_viewOrigin.x) * scale);
+            int r1 = (int)std::floor((e.y + BaseElemHeight * s - m_viewOrigin.y) * scale);
+            if (c1 < 0 || r1 < 0 || c0 >= cols || r0 >= rows) continue;
+            c0 = std::max(0, c0); r0 = std::max(0, r0);
+            c1 = std::min(cols - 1, c1); r1 = std::min(rows - 1, r1);
+            for (int r = r0; r <= r1; ++r) {
+                uint16_t* row = &counts[(size_t)r * cols];
+                for (int c = c0; c <= c1; ++c) if (row[c] != UINT16_MAX) ++row[c];
+            }
+        }
+
+        wxColour bg = GetBackgroundColour();
+        wxImage img(cols, rows);
+        unsigned char* data = img.GetData();
+        for (size_t i = 0; i < counts.size(); ++i) {
+            unsigned char* px = data + i * 3;
+            if (counts[i] == 0) { px[0] = bg.Red(); px[1] = bg.Green(); px[2] = bg.Blue(); continue; }
+            // 覆盖数越多颜色越深，DensitySaturation 个以上饱和
+            double level = std::min(1.0, counts[i] / (double)DensitySaturation);
+            px[0] = (unsigned char)(190 - 170 * level);
+            px[1] = (unsigned char)(190 - 170 * level);
+            px[2] = (unsigned char)(210 - 130 * level);
+        }
+        dc.DrawBitmap(wxBitmap(img.Scale(cols * cell, rows * cell, wxIMAGE_QUALITY_NEAREST)), 0, 0, false);
+    }
+
+    static wxRect PolylineBounds(const std::vector<wxPoint>& pts) {
+        if (pts.empty()) return wxRect();
+        int minX = pts[0].x, maxX = pts[0].x, minY = pts[0].y, maxY = pts[0].y;
+        for (const auto& p : pts) {
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        return wxRect(minX, minY, maxX - minX + 1, maxY - minY + 1);
     }
 
     // FindConnectionSegmentHit 的公开包装
@@ -2139,9 +3291,260 @@ void PropertyPanel::OnApply(wxCommandEvent& evt)
     int outputs = m_spinOutputs->GetValue();
     m_canvas->ApplyPropertiesToSelected(x, y, size, inputs, outputs);
 }
+
+// ---- MinimapPanel ----
+MinimapPanel::MinimapPanel(wxWindow* parent, CanvasPanel* canvas)
+    : wxPanel(parent, wxID_ANY), m_canvas(canvas)
+{
+    SetBackgroundStyle(wxBG_STYLE_PAINT);
+    SetMinSize(wxSize(-1, 150));
+    Bind(wxEVT_PAINT, &MinimapPanel::OnPaint, this);
+    Bind(wxEVT_SIZE, [this](wxSizeEvent& e) { InvalidateAll(); e.Skip(); });
+    Bind(wxEVT_LEFT_DOWN, &MinimapPanel::OnMouse, this);
+    Bind(wxEVT_LEFT_UP, &MinimapPanel::OnMouse, this);
+    Bind(wxEVT_MOTION, &MinimapPanel::OnMouse, this);
+    Bind(wxEVT_MOUSE_CAPTURE_LOST, [](wxMouseCaptureLostEvent&) {});
+}
+
+// 世界矩形 → 缓存图像素矩形（至少 1 像素，保证小元件也可见）
+wxRect MinimapPanel::WorldToImage(const wxRect& r) const
+{
+    int x0 = (int)std::floor((r.x - m_extent.x) * m_scale);
+    int y0 = (int)std::floor((r.y - m_extent.y) * m_scale);
+    int x1 = (int)std::floor((r.x + r.width - m_extent.x) * m_scale);
+    int y1 = (int)std::floor((r.y + r.height - m_extent.y) * m_scale);
+    return wxRect(x0, y0, std::max(1, x1 - x0), std::max(1, y1 - y0));
+}
+
+void MinimapPanel::FillImageRect(const wxRect& r, const wxRect& clip, unsigned char cr, unsigned char cg, unsigned char cb)
+{
+    wxRect c = r.Intersect(clip);
+    if (c.IsEmpty()) return;
+    unsigned char* data = m_image.GetData();
+    const int w = m_image.GetWidth();
+    for (int y = c.y; y < c.y + c.height; ++y) {
+        unsigned char* px = data + ((size_t)y * w + c.x) * 3;
+        for (int x = 0; x < c.width; ++x, px += 3) { px[0] = cr; px[1] = cg; px[2] = cb; }
+    }
+}
+
+// Bresenham 画线，逐点按 clip 裁剪
+void MinimapPanel::DrawImageLine(wxPoint a, wxPoint b, const wxRect& clip, unsigned char cr, unsigned char cg, unsigned char cb)
+{
+    unsigned char* data = m_image.GetData();
+    const int w = m_image.GetWidth();
+    int dx = std::abs(b.x - a.x), sx = a.x < b.x ? 1 : -1;
+    int dy = -std::abs(b.y - a.y), sy = a.y < b.y ? 1 : -1;
+    int err = dx + dy;
+    for (;;) {
+        if (clip.Contains(a)) {
+            unsigned char* px = data + ((size_t)a.y * w + a.x) * 3;
+            px[0] = cr; px[1] = cg; px[2] = cb;
+        }
+        if (a == b) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; a.x += sx; }
+        if (e2 <= dx) { err += dx; a.y += sy; }
+    }
+}
+
+// 缓存图像素矩形 → 世界矩形，外扩一个像素对应的世界距离（WorldToImage 会把小元件放大到 1 像素）
+wxRect MinimapPanel::ImageToWorld(const wxRect& px) const
+{
+    const int margin = (int)std::ceil(1.0 / m_scale) + 1;
+    int x0 = m_extent.x + (int)std::floor(px.x / m_scale) - margin;
+    int y0 = m_extent.y + (int)std::floor(px.y / m_scale) - margin;
+    int x1 = m_extent.x + (int)std::ceil((px.x + px.width) / m_scale) + margin;
+    int y1 = m_extent.y + (int)std::ceil((px.y + px.height) / m_scale) + margin;
+    return wxRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+// 像素矩形覆盖的分块范围（闭区间），与缓存图不相交时返回 false
+bool MinimapPanel::ChunkRange(const wxRect& px, int& c0, int& r0, int& c1, int& r1) const
+{
+    wxRect c = px.Intersect(wxRect(0, 0, m_chunkCols * WireChunkPx, m_chunkRows * WireChunkPx));
+    if (c.IsEmpty()) return false;
+    c0 = c.x / WireChunkPx; r0 = c.y / WireChunkPx;
+    c1 = (c.x + c.width - 1) / WireChunkPx; r1 = (c.y + c.height - 1) / WireChunkPx;
+    return true;
+}
+
+// 按 m_wireWorld[ci] 把连线登记到（或移出）覆盖的分块
+void MinimapPanel::IndexWire(size_t ci, bool add)
+{
+    if (ci >= m_wireWorld.size() || m_wireWorld[ci].IsEmpty()) return;
+    wxRect px = WorldToImage(m_wireWorld[ci]);
+    px.Inflate(1, 1);
+    int c0, r0, c1, r1;
+    if (!ChunkRange(px, c0, r0, c1, r1)) return;
+    for (int r = r0; r <= r1; ++r)
+        for (int c = c0; c <= c1; ++c) {
+            auto& chunk = m_wireChunks[(size_t)r * m_chunkCols + c];
+            if (add) chunk.push_back((int)ci);
+            else chunk.erase(std::remove(chunk.begin(), chunk.end(), (int)ci), chunk.end());
+        }
+}
+
+void MinimapPanel::InvalidateConnection(size_t ci)
+{
+    if (!m_canvas || ci >= m_canvas->GetConnectionCount()) return;
+    // 整体重建时会重新登记全部连线
+    if (m_fullRebuild || !m_image.IsOk()) { Refresh(); return; }
+    if (ci < m_wireWorld.size()) {
+        InvalidateWorld(m_wireWorld[ci]);
+        IndexWire(ci, false);
+    }
+    else m_wireWorld.resize(ci + 1, wxRect());
+    m_wireWorld[ci] = m_canvas->GetConnectionBounds(ci);
+    IndexWire(ci, true);
+    InvalidateWorld(m_wireWorld[ci]);
+}
+
+void MinimapPanel::ConnectionErased(size_t ci)
+{
+    if (m_fullRebuild || !m_image.IsOk() || ci >= m_wireWorld.size()) { InvalidateAll(); return; }
+    InvalidateWorld(m_wireWorld[ci]);
+    IndexWire(ci, false);
+    m_wireWorld.erase(m_wireWorld.begin() + ci);
+    for (auto& chunk : m_wireChunks)
+        for (int& w : chunk) if (w > (int)ci) --w;
+}
+
+// 重画缓存图中的一块像素区域：先清背景，再画与之相交的连线（分块索引）和元件（画布障碍图），按下标顺序绘制
+void MinimapPanel::RenderRegion(const wxRect& pixelRect)
+{
+    wxRect clip = pixelRect.Intersect(wxRect(0, 0, m_image.GetWidth(), m_image.GetHeight()));
+    if (clip.IsEmpty()) return;
+    FillImageRect(clip, clip, 248, 248, 248);
+
+    auto toImage = [&](const wxPoint& p) {
+        return wxPoint((int)std::floor((p.x - m_extent.x) * m_scale), (int)std::floor((p.y - m_extent.y) * m_scale));
+    };
+    std::vector<int> wires;
+    int c0, r0, c1, r1;
+    if (ChunkRange(clip, c0, r0, c1, r1)) {
+        for (int r = r0; r <= r1; ++r)
+            for (int c = c0; c <= c1; ++c) {
+                const auto& chunk = m_wireChunks[(size_t)r * m_chunkCols + c];
+                wires.insert(wires.end(), chunk.begin(), chunk.end());
+            }
+        std::sort(wires.begin(), wires.end());
+        wires.erase(std::unique(wires.begin(), wires.end()), wires.end());
+    }
+    for (int ci : wires) {
+        if (ci >= (int)m_canvas->GetConnectionCount()) continue;
+        const std::vector<wxPoint>& poly = m_canvas->GetConnectionPolyline(ci);
+        if (poly.size() < 2) continue;
+        if (!WorldToImage(m_wireWorld[ci]).Intersects(clip)) continue;
+        for (size_t i = 1; i < poly.size(); ++i) DrawImageLine(toImage(poly[i - 1]), toImage(poly[i]), clip, 150, 170, 150);
+    }
+    const std::vector<ElementInfo>& elements = m_canvas->GetElements();
+    for (int ei : m_canvas->GetElementsInRect(ImageToWorld(clip))) {
+        const ElementInfo& e = elements[ei];
+        int sz = std::max(1, e.size);
+        wxRect r = WorldToImage(wxRect(e.x, e.y, BaseElemWidth * sz, BaseElemHeight * sz));
+        if (!r.Intersects(clip)) continue;
+        wxColour c(e.color);
+        FillImageRect(r, clip, c.Red() / 2 + 40, c.Green() / 2 + 40, c.Blue() / 2 + 40);
+    }
+}
+
+// 整体重建：按设计包围盒（加留白）确定缩放，建立连线分块索引并渲染整张缓存图
+void MinimapPanel::Rebuild()
+{
+    m_fullRebuild = false;
+    m_dirtyWorld.clear();
+    m_bitmapValid = false;
+    m_image = wxImage();
+    m_wireChunks.clear();
+    m_wireWorld.clear();
+    m_chunkCols = m_chunkRows = 0;
+    wxSize sz = GetClientSize();
+    if (!m_canvas || sz.x <= 0 || sz.y <= 0) return;
+
+    wxRect bounds;
+    bool any = false;
+    auto grow = [&](const wxRect& r) { bounds = any ? bounds.Union(r) : r; any = true; };
+    for (const auto& e : m_canvas->GetElements()) {
+        int s = std::max(1, e.size);
+        grow(wxRect(e.x, e.y, BaseElemWidth * s, BaseElemHeight * s));
+    }
+    m_wireWorld.resize(m_canvas->GetConnectionCount());
+    for (size_t ci = 0; ci < m_wireWorld.size(); ++ci) {
+        m_wireWorld[ci] = m_canvas->GetConnectionBounds(ci);
+        if (!m_wireWorld[ci].IsEmpty()) grow(m_wireWorld[ci]);
+    }
+    if (!any) bounds = wxRect(0, 0, 800, 600);
+
+    // 留白使小幅移出原范围的编辑仍可局部更新
+    bounds.Inflate(std::max(100, bounds.width / 10), std::max(100, bounds.height / 10));
+    m_extent = bounds;
+    m_scale = std::min(sz.x / (double)m_extent.width, sz.y / (double)m_extent.height);
+    int w = std::max(1, (int)(m_extent.width * m_scale));
+    int h = std::max(1, (int)(m_extent.height * m_scale));
+    m_imageOrigin = wxPoint((sz.x - w) / 2, (sz.y - h) / 2);
+    m_image = wxImage(w, h, false);
+    m_chunkCols = (w + WireChunkPx - 1) / WireChunkPx;
+    m_chunkRows = (h + WireChunkPx - 1) / WireChunkPx;
+    m_wireChunks.assign((size_t)m_chunkCols * m_chunkRows, std::vector<int>());
+    for (size_t ci = 0; ci < m_wireWorld.size(); ++ci) IndexWire(ci, true);
+    RenderRegion(wxRect(0, 0, w, h));
+}
+
+// 处理累积的脏区域；超出缓存范围或数量过多时退化为整体重建
+void MinimapPanel::FlushDirty()
+{
+    if (m_dirtyWorld.size() > MaxDirtyRects || !m_image.IsOk()) { Rebuild(); return; }
+    for (const auto& r : m_dirtyWorld) {
+        if (!m_extent.Contains(r)) { Rebuild(); return; }
+    }
+    for (const auto& r : m_dirtyWorld) {
+        wxRect px = WorldToImage(r);
+        px.Inflate(1, 1);
+        RenderRegion(px);
+    }
+    m_dirtyWorld.clear();
+    m_bitmapValid = false;
+}
+
+void MinimapPanel::OnPaint(wxPaintEvent& event)
+{
+    wxAutoBufferedPaintDC dc(this);
+    dc.SetBackground(wxBrush(wxColour(225, 225, 225)));
+    dc.Clear();
+    if (!m_canvas) return;
+    if (m_fullRebuild) Rebuild();
+    else if (!m_dirtyWorld.empty()) FlushDirty();
+    if (!m_image.IsOk()) return;
+    if (!m_bitmapValid) { m_bitmap = wxBitmap(m_image); m_bitmapValid = true; }
+    dc.DrawBitmap(m_bitmap, m_imageOrigin.x, m_imageOrigin.y, false);
+
+    // 当前视口框
+    wxRect view = WorldToImage(m_canvas->GetVisibleWorldRect());
+    view.Offset(m_imageOrigin.x, m_imageOrigin.y);
+    dc.SetPen(wxPen(wxColour(220, 0, 0), 1));
+    dc.SetBrush(*wxTRANSPARENT_BRUSH);
+    dc.DrawRectangle(view);
+}
+
+// 左键点击或拖动：把画布视口中心移到对应位置
+void MinimapPanel::OnMouse(wxMouseEvent& event)
+{
+    if (!m_canvas || !m_image.IsOk() || m_scale <= 0.0) { event.Skip(); return; }
+    if (event.LeftUp()) { if (HasCapture()) ReleaseMouse(); return; }
+    if (event.LeftDown()) { if (!HasCapture()) CaptureMouse(); }
+    else if (!(event.Dragging() && event.LeftIsDown())) { event.Skip(); return; }
+    wxPoint p = event.GetPosition();
+    wxPoint world(m_extent.x + (int)std::lround((p.x - m_imageOrigin.x) / m_scale),
+        m_extent.y + (int)std::lround((p.y - m_imageOrigin.y) / m_scale));
+    m_canvas->CenterViewOn(world);
+}
 //实现撤销功能
 void CanvasPanel::SaveStateForUndo()
 {
+    // 修改模型前先停下后台路由（连线预览直接读取 m_elements / m_obstacles）
+    m_routeWorker.CancelAndWait();
+    m_connectPreview.valid = false;
     // 保存当前状态到撤销栈（按值拷贝整个模型）
     Snapshot s;
     s.elements = m_elements;
@@ -2155,16 +3558,23 @@ void CanvasPanel::SaveStateForUndo()
 
 void CanvasPanel::Undo()
 {
+    // 拖拽开始时已保存撤销点，拖拽中撤销即放弃这次拖拽
+    CancelDrag();
     if (m_undoStack.empty()) {
         wxBell();
         return;
     }
+    m_routeWorker.CancelAndWait();
+    m_connectPreview.valid = false;
     // 恢复最近一次保存的状态
     Snapshot s = std::move(m_undoStack.back());
     m_undoStack.pop_back();
 
     m_elements = std::move(s.elements);
     m_connections = std::move(s.connections);
+    m_pinIndex.Rebuild(m_elements.size(), m_connections);
+    m_obstacles.Rebuild(m_elements);
+    MinimapReset();
 
     // 重置选择、仿真缓存与绘制状态
     m_selectedIndex = -1;
@@ -2180,12 +3590,17 @@ void CanvasPanel::Undo()
 
 bool MyApp::OnInit()
 {
-    try {
-        json j; j["elements"] = json::array(); j["connections"] = json::array();
-        std::ofstream ofs("Elementlib.json");
-        if (ofs.is_open()) { ofs << j.dump(4); ofs.close(); }
+    // 首次运行时写一个空设计；已有设计文件或编辑日志时保留，启动时据此恢复上次的设计和未写出的编辑
+    std::error_code ec;
+    if (!std::filesystem::exists("Elementlib.json", ec) && !std::filesystem::exists("Elementlib.lgdb", ec)
+        && !std::filesystem::exists("Elementlib.journal", ec)) {
+        try {
+            json j; j["elements"] = json::array(); j["connections"] = json::array();
+            std::ofstream ofs("Elementlib.json");
+            if (ofs.is_open()) { ofs << j.dump(4); ofs.close(); }
+        }
+        catch (...) {}
     }
-    catch (...) {}
     wxInitAllImageHandlers();
     MyFrame* frame = new MyFrame();
     frame->Show(true);
@@ -2201,7 +3616,9 @@ MyFrame::MyFrame()
     menuFile->Append(wxID_NEW, "New         Crtl+N");
     menuFile->Append(wxID_EXIT, "Exit");
     menuFile->Append(ID_FILE_OPENRECENT, "Import Netlist...");
+    menuFile->Append(ID_FILE_IMPORT_BOOKSHELF, "Import BookShelf...");
     menuFile->Append(ID_FILE_SAVE, "Export Netlist...");
+    menuFile->Append(ID_FILE_EXPORT_IMAGE, "Export Image...");
 
     wxMenu* menuEdit = new wxMenu;
     menuEdit->Append(ID_CUT, "Cut");
@@ -2209,12 +3626,22 @@ MyFrame::MyFrame()
 
     wxMenu* menuProject = new wxMenu;
     menuProject->Append(ID_PROJECT_ADD_CIRCUIT, "Add Circuit");
+    menuProject->Append(ID_PROJECT_AUTOROUTE, "Autoroute All");
+    menuProject->Append(ID_PROJECT_REROUTE_ALL, "Rip-up && Reroute All");
+    menuProject->Append(ID_PROJECT_REROUTE_VIEW, "Rip-up && Reroute Visible Area");
+    menuProject->Append(ID_PROJECT_PLACE_ALL, "Auto Place All");
+    menuProject->Append(ID_PROJECT_ANNEAL, "Refine Placement (Annealing)");
+    menuProject->Append(ID_PROJECT_CANCEL_PLACE, "Cancel Placement Refinement");
+    menuProject->Append(ID_PROJECT_LEGALIZE, "Remove Overlaps (Legalize)");
 
     wxMenu* menuSim = new wxMenu;
     menuSim->Append(ID_SIM_ENABLE, "Enable");
 
     wxMenu* menuWindow = new wxMenu;
     menuWindow->Append(ID_WINDOW_CASCADE, "Cascade Windows");
+    menuWindow->AppendCheckItem(ID_WINDOW_PERF_HUD, "Performance Overlay\tF12");
+    menuWindow->AppendCheckItem(ID_WINDOW_MINIMAP, "Minimap");
+    menuWindow->Check(ID_WINDOW_MINIMAP, true);
 
     wxMenu* menuHelp = new wxMenu;
     menuHelp->Append(ID_HELP_ABOUT, "About");
@@ -2284,6 +3711,8 @@ MyFrame::MyFrame()
 
     MyTreePanel* treePanel = new MyTreePanel(leftPanel);
     PropertyPanel* prop = new PropertyPanel(leftPanel, canvas);
+    MinimapPanel* minimap = new MinimapPanel(leftPanel, canvas);
+    m_minimap = minimap;
 
     // 设置属性面板的最小高度，保证在多数窗口下完整显示；同时使用 sizer 控制伸缩
     // 修改：将属性面板最小高度显著增大，元件库保持较小固定高度
@@ -2294,6 +3723,7 @@ MyFrame::MyFrame()
     // treePanel 使用固定（比例0）布局以保持较小高度，prop 使用比例1占据剩余并可伸展
     leftSizer->Add(treePanel, 0, wxEXPAND | wxALL, 2); // 固定较小高度
     leftSizer->Add(prop, 1, wxEXPAND | wxALL, 2);      // 占用剩余空间并放大
+    leftSizer->Add(minimap, 0, wxEXPAND | wxALL, 2);   // 缩略图固定高度，可在 Window 菜单中隐藏
 
     leftPanel->SetSizer(leftSizer);
 
@@ -2306,11 +3736,12 @@ MyFrame::MyFrame()
     // 这里把 leftPanel 的最小高度设置为属性面板高度 + margin（40），并设置宽度为 240
     wxSize propMin = prop->GetMinSize();
     int leftMinW = 240;
-    int leftMinH = std::max(200, propMin.y + 40);
+    int leftMinH = std::max(200, propMin.y + minimap->GetMinSize().y + 40);
     leftPanel->SetMinSize(wxSize(leftMinW, leftMinH));
 
     // 让画布知道属性面板
     canvas->SetPropertyPanel(prop);
+    canvas->SetMinimap(minimap);
 
     // 主拆分：左为 leftPanel，右为画布
     splitter->SplitVertically(leftPanel, canvas, 200);
@@ -2334,12 +3765,23 @@ MyFrame::MyFrame()
     Bind(wxEVT_MENU, &MyFrame::OnCut, this, ID_CUT);
     Bind(wxEVT_MENU, &MyFrame::OnCopy, this, ID_COPY);
     Bind(wxEVT_MENU, &MyFrame::OnAddCircuit, this, ID_PROJECT_ADD_CIRCUIT);
+    Bind(wxEVT_MENU, &MyFrame::OnAutorouteAll, this, ID_PROJECT_AUTOROUTE);
+    Bind(wxEVT_MENU, &MyFrame::OnRerouteAll, this, ID_PROJECT_REROUTE_ALL);
+    Bind(wxEVT_MENU, &MyFrame::OnRerouteView, this, ID_PROJECT_REROUTE_VIEW);
+    Bind(wxEVT_MENU, &MyFrame::OnPlaceAll, this, ID_PROJECT_PLACE_ALL);
+    Bind(wxEVT_MENU, &MyFrame::OnAnnealPlacement, this, ID_PROJECT_ANNEAL);
+    Bind(wxEVT_MENU, &MyFrame::OnCancelPlacement, this, ID_PROJECT_CANCEL_PLACE);
+    Bind(wxEVT_MENU, &MyFrame::OnLegalizePlacement, this, ID_PROJECT_LEGALIZE);
     Bind(wxEVT_MENU, &MyFrame::OnSimEnable, this, ID_SIM_ENABLE);
     Bind(wxEVT_MENU, &MyFrame::OnWindowCascade, this, ID_WINDOW_CASCADE);
+    Bind(wxEVT_MENU, &MyFrame::OnWindowPerfHud, this, ID_WINDOW_PERF_HUD);
+    Bind(wxEVT_MENU, &MyFrame::OnWindowMinimap, this, ID_WINDOW_MINIMAP);
     Bind(wxEVT_MENU, &MyFrame::OnHelp, this, ID_HELP_ABOUT);
 
     Bind(wxEVT_MENU, &MyFrame::OnImportNetlist, this, ID_FILE_OPENRECENT);
+    Bind(wxEVT_MENU, &MyFrame::OnImportBookShelf, this, ID_FILE_IMPORT_BOOKSHELF);
     Bind(wxEVT_MENU, &MyFrame::OnExportNetlist, this, ID_FILE_SAVE);
+    Bind(wxEVT_MENU, &MyFrame::OnExportImage, this, ID_FILE_EXPORT_IMAGE);
 
     Bind(wxEVT_TOOL, &MyFrame::OnToolChangeValue, this, ID_TOOL_CHGVALUE);
     Bind(wxEVT_TOOL, &MyFrame::OnToolEditSelect, this, ID_TOOL_EDITSELECT);
@@ -2358,6 +3800,60 @@ void MyFrame::OnCloseWindow(wxCloseEvent& event) {
 void MyFrame::OnCut(wxCommandEvent& event) { wxMessageBox("剪切", "Edit", wxOK | wxICON_INFORMATION); }
 void MyFrame::OnCopy(wxCommandEvent& event) { wxMessageBox("复制", "Edit", wxOK | wxICON_INFORMATION); }
 void MyFrame::OnAddCircuit(wxCommandEvent& event) { wxMessageBox("添加", "Project", wxOK | wxICON_INFORMATION); }
+void MyFrame::OnAutorouteAll(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    AutorouteResult r;
+    {
+        wxBusyCursor busy;
+        r = m_canvas->AutorouteAllConnections();
+    }
+    SetStatusText(wxString::Format("Autoroute: %d routed, %d failed, %d overlaps left, %d passes",
+        (int)r.routed, (int)r.failed, (int)r.overflowCells, r.iterations));
+}
+void MyFrame::OnRerouteAll(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    wxBusyCursor busy;
+    PerfTimer timer;
+    size_t n = m_canvas->RipUpAndReroute(false);
+    SetStatusText(wxString::Format("Rerouted %d connections in %.1f ms", (int)n, timer.ElapsedMs()));
+}
+void MyFrame::OnRerouteView(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    wxBusyCursor busy;
+    PerfTimer timer;
+    size_t n = m_canvas->RipUpAndReroute(true);
+    SetStatusText(wxString::Format("Rerouted %d connections in %.1f ms", (int)n, timer.ElapsedMs()));
+}
+void MyFrame::OnPlaceAll(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    wxBusyCursor busy;
+    PerfTimer timer;
+    PlacementResult r = m_canvas->AutoPlaceAll();
+    SetStatusText(wxString::Format("Placed %d elements in %.1f ms (%d passes), wirelength %.0f -> %.0f",
+        (int)r.moved, timer.ElapsedMs(), r.iterations, r.hpwlBefore, r.hpwlAfter));
+}
+void MyFrame::OnAnnealPlacement(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    if (!m_canvas->StartAnnealPlacement()) SetStatusText("Placement refinement is already running");
+}
+void MyFrame::OnCancelPlacement(wxCommandEvent& event)
+{
+    if (m_canvas) m_canvas->CancelAnnealPlacement();
+}
+void MyFrame::OnLegalizePlacement(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    wxBusyCursor busy;
+    PerfTimer timer;
+    LegalizeResult r = m_canvas->LegalizeAll();
+    SetStatusText(wxString::Format("Legalized in %.1f ms: %d elements moved, max displacement %.0f px",
+        timer.ElapsedMs(), (int)r.moved, r.maxDisplacement));
+}
 void MyFrame::OnSimEnable(wxCommandEvent& event) { wxMessageBox("仿真启用", "Simulate", wxOK | wxICON_INFORMATION); }
 void MyFrame::OnWindowCascade(wxCommandEvent& event) { wxMessageBox("窗口", "Window", wxOK | wxICON_INFORMATION); }
 void MyFrame::OnHelp(wxCommandEvent& event) { wxMessageBox("Logisim 帮助", "Help", wxOK | wxICON_INFORMATION); }
@@ -2375,6 +3871,33 @@ void MyFrame::OnExportNetlist(wxCommandEvent& event)
     }
 }
 
+void MyFrame::OnWindowMinimap(wxCommandEvent& event)
+{
+    if (!m_minimap) return;
+    wxWindow* parent = m_minimap->GetParent();
+    m_minimap->Show(event.IsChecked());
+    if (parent) parent->Layout();
+}
+
+void MyFrame::OnWindowPerfHud(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    m_canvas->SetPerfHudVisible(event.IsChecked());
+    if (!event.IsChecked()) SetStatusText("");
+}
+
+void MyFrame::OnExportImage(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    wxFileDialog dlg(this, "Export image", "", "schematic.png", "PNG files (*.png)|*.png|SVG files (*.svg)|*.svg", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if (dlg.ShowModal() == wxID_OK) {
+        std::string path = dlg.GetPath().ToStdString();
+        wxBusyCursor busy;
+        if (m_canvas->ExportImage(path)) wxMessageBox("导出成功", "Export", wxOK | wxICON_INFORMATION);
+        else wxMessageBox("导出失败", "Export", wxOK | wxICON_ERROR);
+    }
+}
+
 void MyFrame::OnImportNetlist(wxCommandEvent& event)
 {
     if (!m_canvas) return;
@@ -2386,9 +3909,60 @@ void MyFrame::OnImportNetlist(wxCommandEvent& event)
     }
 }
 
+void MyFrame::OnImportBookShelf(wxCommandEvent& event)
+{
+    if (!m_canvas) return;
+    wxFileDialog dlg(this, "Import BookShelf", "", "", "BookShelf files (*.aux;*.nodes;*.node)|*.aux;*.nodes;*.node", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if (dlg.ShowModal() != wxID_OK) return;
+    std::string path = dlg.GetPath().ToStdString();
+    wxBusyCursor busy;
+    PerfTimer timer;
+    BookShelfDesign design;
+    std::string error;
+    if (!m_canvas->ImportBookShelf(path, design, &error)) {
+        wxMessageBox(wxString("导入失败: ") + error.c_str(), "Import", wxOK | wxICON_ERROR);
+        return;
+    }
+    SetStatusText(wxString::Format("BookShelf imported in %.0f ms: %d nets, %d pins, %d rows",
+        timer.ElapsedMs(), (int)design.nets, (int)design.pins, (int)design.rows.size()));
+}
+
 void MyFrame::OnToolChangeValue(wxCommandEvent& event) {}
 void MyFrame::OnToolEditSelect(wxCommandEvent& event) { SetPlacementType("EditSelect"); SetStatusText("Selected tool: Edit selection"); }
 void MyFrame::OnToolEditText(wxCommandEvent& event) { SetPlacementType("EditText"); SetStatusText("Selected tool: Edit text"); }
 void MyFrame::OnToolShowSimulation(wxCommandEvent& event) { if (!m_canvas) return; m_canvas->ToggleSimulation(); if (m_canvas->IsSimulating()) SetStatusText("Simulation: ON"); else SetStatusText("Simulation: OFF"); }
 
+#ifdef __WXMSW__
 wxIMPLEMENT_APP(MyApp);
+#else
+wxIMPLEMENT_APP_NO_MAIN(MyApp);
+
+// 无界面导出（不初始化 wx，可在没有显示环境的主机上批量运行）：
+//   logisim --export design.json|design.lgdb out.png|out.svg [scale]
+static int RunHeadlessExport(int argc, char** argv)
+{
+    std::vector<ElementInfo> elements;
+    std::vector<ConnectionInfo> connections;
+    const bool loaded = IsDesignBinaryPath(argv[2]) ? LoadDesignBinary(argv[2], elements, connections)
+                                                    : LoadDesignFile(argv[2], elements, connections);
+    if (!loaded) {
+        std::fprintf(stderr, "cannot open %s\n", argv[2]);
+        return 1;
+    }
+    ExportOptions opts;
+    if (argc > 4) opts.scale = std::atof(argv[4]);
+    std::string out = argv[3];
+    std::string ext = out.size() >= 4 ? out.substr(out.size() - 4) : std::string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char ch) { return (char)std::tolower(ch); });
+    bool ok = (ext == ".svg") ? ExportSchematicSVG(out, elements, connections, opts)
+                              : ExportSchematicPNG(out, elements, connections, opts);
+    if (!ok) std::fprintf(stderr, "export to %s failed\n", out.c_str());
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 4 && std::string(argv[1]) == "--export") return RunHeadlessExport(argc, argv);
+    return wxEntry(argc, argv);
+}
+#endif
@@ -0,0 +1,385 @@
+#include "JsonStreamReader.h"
+#include "MappedFile.h"
+#include <nlohmann/json.hpp>
+#include <unordered_map>
+#include <algorithm>
+#include <tuple>
+#include <cstdint>
+using json = nlohmann::json;
+
+namespace {
+
+// 识别的字段名
+enum class Field {
+    None, Type, Color, Thickness, X, Y, Size, RotationIndex, Inputs, Outputs, Id,
+    A, APin, B, BPin, X1, Y1, X2, Y2, AConn, AConnAux, TurningPoints, AuxOutputs, Seg, T,
+    Pos, CompId, Pin, Endpoints, Elements, Components, Connections, Nets, Netlist, Journal, Base, Seq
+};
+
+Field FieldOf(const std::string& key)
+{
+    static const std::unordered_map<std::string, Field> fields = {
+        { "type", Field::Type }, { "color", Field::Color }, { "thickness", Field::Thickness },
+        { "x", Field::X }, { "y", Field::Y }, { "size", Field::Size }, { "rotationIndex", Field::RotationIndex },
+        { "inputs", Field::Inputs }, { "outputs", Field::Outputs }, { "id", Field::Id },
+        { "a", Field::A }, { "aPin", Field::APin }, { "b", Field::B }, { "bPin", Field::BPin },
+        { "x1", Field::X1 }, { "y1", Field::Y1 }, { "x2", Field::X2 }, { "y2", Field::Y2 },
+        { "aConn", Field::AConn }, { "aConnAux", Field::AConnAux },
+        { "turningPoints", Field::TurningPoints }, { "auxOutputs", Field::AuxOutputs }, { "seg", Field::Seg }, { "t", Field::T },
+        { "pos", Field::Pos }, { "compId", Field::CompId }, { "pin", Field::Pin }, { "endpoints", Field::Endpoints },
+        { "elements", Field::Elements }, { "components", Field::Components }, { "connections", Field::Connections },
+        { "nets", Field::Nets }, { "netlist", Field::Netlist }, { "journal", Field::Journal },
+        { "base", Field::Base }, { "seq", Field::Seq },
+    };
+    auto it = fields.find(key);
+    return it == fields.end() ? Field::None : it->second;
+}
+
+// 一个层级（顶层对象或 "netlist" 对象）下读到的各节；同时出现时 components 优先于 elements、nets 优先于 connections
+struct Section {
+    std::vector<ElementInfo> elements;
+    std::vector<ElementInfo> components;                      // 不带 id 的 components
+    std::vector<std::pair<int, ElementInfo>> componentsById;
+    std::vector<ConnectionInfo> connections;
+    std::vector<ConnectionInfo> netConnections;
+    bool hasElements = false, hasComponents = false, hasConnections = false, hasNets = false;
+};
+
+class ModelSax
+{
+public:
+    explicit ModelSax(bool netlist) : m_netlistKeys(netlist) {}
+
+    Section root, netlist;
+    bool sawNetlist = false;
+    bool hasJournal = false;
+    JournalMark journal;
+    std::string error;
+
+    // ---- nlohmann::json SAX 接口 ----
+    bool null() { Scalar(); return true; }
+    bool boolean(bool) { Scalar(); return true; }
+    bool number_integer(json::number_integer_t v) { Number((int)v, (double)v, (uint64_t)v); return true; }
+    bool number_unsigned(json::number_unsigned_t v) { Number((int)v, (double)v, v); return true; }
+    bool number_float(json::number_float_t v, const json::string_t&)
+    {
+        const double clamped = std::max(-2147483648.0, std::min(2147483647.0, v));
+        Number((int)clamped, v, v > 0 ? (uint64_t)std::min(v, 1.8e19) : 0);
+        return true;
+    }
+    bool binary(json::binary_t&) { Scalar(); return true; }
+
+    bool string(json::string_t& v)
+    {
+        const Ctx ctx = Top();
+        if (ctx == Ctx::Element) {
+            if (m_field == Field::Type) m_elem.type = std::move(v);
+            else if (m_field == Field::Color) m_elem.color = std::move(v);
+        }
+        else Scalar();
+        return true;
+    }
+
+    bool key(json::string_t& k) { m_field = FieldOf(k); return true; }
+
+    bool start_object(std::size_t)
+    {
+        const Ctx parent = Top();
+        Ctx ctx = Ctx::Skip;
+        if (m_stack.empty()) ctx = Ctx::Root;
+        else if (parent == Ctx::Root && m_netlistKeys && m_field == Field::Netlist) { ctx = Ctx::Netlist; sawNetlist = true; }
+        else if (parent == Ctx::Root && m_field == Field::Journal) { ctx = Ctx::Journal; hasJournal = true; }
+        else if (parent == Ctx::ElementList) {
+            ctx = Ctx::Element;
+            m_elem = ElementInfo();
+            m_elem.color = "black";
+            m_elemHasId = false;
+        }
+        else if (parent == Ctx::ConnList) {
+            ctx = Ctx::Conn;
+            m_conn = ConnectionInfo();
+            m_aux.clear();
+        }
+        else if (parent == Ctx::AuxList) { ctx = Ctx::Aux; m_aux.push_back(PendingAux()); }
+        else if (parent == Ctx::NetList) {
+            ctx = Ctx::Net;
+            m_endpoints.clear();
+            m_netPoints.clear();
+            m_netHasEndpoints = false;
+        }
+        else if (parent == Ctx::Endpoints) { ctx = Ctx::Endpoint; m_endpoints.push_back(Endpoint()); }
+        else if (parent == Ctx::Point) Scalar();
+        m_stack.push_back(ctx);
+        return true;
+    }
+
+    bool end_object()
+    {
+        const Ctx ctx = Top();
+        m_stack.pop_back();
+        if (ctx == Ctx::Element) {
+            if (m_byId && m_elemHasId) m_byId->emplace_back(m_elemId, std::move(m_elem));
+            else m_elemList->push_back(std::move(m_elem));
+        }
+        else if (ctx == Ctx::Conn) FinishConnection();
+        else if (ctx == Ctx::Net) FinishNet();
+        return true;
+    }
+
+    bool start_array(std::size_t)
+    {
+        const Ctx parent = Top();
+        Ctx ctx = Ctx::Skip;
+        if (parent == Ctx::Root || parent == Ctx::Netlist) {
+            Section& s = parent == Ctx::Root ? root : netlist;
+            if (m_field == Field::Elements) { ctx = Ctx::ElementList; s.hasElements = true; m_elemList = &s.elements; m_byId = nullptr; }
+            else if (m_field == Field::Components && m_netlistKeys) { ctx = Ctx::ElementList; s.hasComponents = true; m_elemList = &s.components; m_byId = &s.componentsById; }
+            else if (m_field == Field::Connections) { ctx = Ctx::ConnList; s.hasConnections = true; m_connList = &s.connections; }
+            else if (m_field == Field::Nets && m_netlistKeys) { ctx = Ctx::NetList; s.hasNets = true; m_connList = &s.netConnections; }
+        }
+        else if (parent == Ctx::Conn && m_field == Field::TurningPoints) ctx = Ctx::ConnPoints;
+        else if (parent == Ctx::Conn && m_field == Field::AuxOutputs) ctx = Ctx::AuxList;
+        else if (parent == Ctx::Net && m_field == Field::TurningPoints) ctx = Ctx::NetPoints;
+        else if (parent == Ctx::Net && m_field == Field::Endpoints) { ctx = Ctx::Endpoints; m_netHasEndpoints = true; }
+        else if (parent == Ctx::Endpoint && m_field == Field::Pos) BeginPoint(ctx, Ctx::Endpoint);
+        else if (parent == Ctx::ConnPoints || parent == Ctx::NetPoints) BeginPoint(ctx, parent);
+        else if (parent == Ctx::AuxList) { m_aux.push_back(PendingAux()); BeginPoint(ctx, parent); }
+        else if (parent == Ctx::Endpoints || parent == Ctx::Point) Scalar();
+        m_stack.push_back(ctx);
+        return true;
+    }
+
+    bool end_array()
+    {
+        const Ctx ctx = Top();
+        m_stack.pop_back();
+        if (ctx == Ctx::Point && m_pointCount == 2) {
+            const wxPoint p(m_point[0], m_point[1]);
+            if (m_pointOwner == Ctx::ConnPoints) m_conn.turningPoints.push_back(p);
+            else if (m_pointOwner == Ctx::NetPoints) m_netPoints.push_back(p);
+            else if (m_pointOwner == Ctx::AuxList) { m_aux.back().pixel = true; m_aux.back().pos = p; }
+            else if (m_pointOwner == Ctx::Endpoint) { m_endpoints.back().hasPos = true; m_endpoints.back().pos = p; }
+        }
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const json::exception& ex)
+    {
+        error = ex.what();
+        return false;
+    }
+
+private:
+    enum class Ctx {
+        Skip, Root, Netlist, Journal, ElementList, Element, ConnList, Conn, ConnPoints, AuxList, Aux,
+        NetList, Net, NetPoints, Endpoints, Endpoint, Point
+    };
+    // aux 点：对象形式为 {seg, t}；[x, y] 形式要等整条连接读完（键的顺序任意）后再投影到折线上
+    struct PendingAux {
+        bool pixel = false;
+        ConnectionInfo::AuxOutput ao;
+        wxPoint pos;
+    };
+    struct Endpoint {
+        int compId = -1, pin = -1;
+        bool hasPos = false;
+        wxPoint pos;
+    };
+
+    const bool m_netlistKeys;
+    std::vector<Ctx> m_stack;
+    Field m_field = Field::None;
+    std::vector<ElementInfo>* m_elemList = nullptr;
+    std::vector<std::pair<int, ElementInfo>>* m_byId = nullptr;   // 读 components 时带 id 的元件放这里
+    std::vector<ConnectionInfo>* m_connList = nullptr;
+
+    ElementInfo m_elem;
+    bool m_elemHasId = false;
+    int m_elemId = 0;
+    ConnectionInfo m_conn;
+    std::vector<PendingAux> m_aux;
+    std::vector<Endpoint> m_endpoints;
+    std::vector<wxPoint> m_netPoints;
+    bool m_netHasEndpoints = false;
+    Ctx m_pointOwner = Ctx::Skip;
+    int m_point[2] = { 0, 0 };
+    int m_pointCount = 0;
+
+    Ctx Top() const { return m_stack.empty() ? Ctx::Skip : m_stack.back(); }
+
+    void BeginPoint(Ctx& ctx, Ctx owner)
+    {
+        ctx = Ctx::Point;
+        m_pointOwner = owner;
+        m_pointCount = 0;
+    }
+
+    // aux 列表或端点列表中的非对象元素：与 DOM 版本一致，按默认值占一项
+    void Scalar()
+    {
+        const Ctx ctx = Top();
+        if (ctx == Ctx::AuxList) m_aux.push_back(PendingAux());
+        else if (ctx == Ctx::Endpoints) m_endpoints.push_back(Endpoint());
+        else if (ctx == Ctx::Point) m_pointCount = 3;   // 非数值分量：该点无效
+    }
+
+    void Number(int i, double d, uint64_t u)
+    {
+        switch (Top()) {
+        case Ctx::Element:
+            switch (m_field) {
+            case Field::Thickness: m_elem.thickness = i; break;
+            case Field::X: m_elem.x = i; break;
+            case Field::Y: m_elem.y = i; break;
+            case Field::Size: m_elem.size = i; break;
+            case Field::RotationIndex: m_elem.rotationIndex = i; break;
+            case Field::Inputs: m_elem.inputs = i; break;
+            case Field::Outputs: m_elem.outputs = i; break;
+            case Field::Id: m_elemHasId = true; m_elemId = i; break;
+            default: break;
+            }
+            break;
+        case Ctx::Conn:
+            switch (m_field) {
+            case Field::A: m_conn.aIndex = i; break;
+            case Field::APin: m_conn.aPin = i; break;
+            case Field::B: m_conn.bIndex = i; break;
+            case Field::BPin: m_conn.bPin = i; break;
+            case Field::X1: m_conn.x1 = i; break;
+            case Field::Y1: m_conn.y1 = i; break;
+            case Field::X2: m_conn.x2 = i; break;
+            case Field::Y2: m_conn.y2 = i; break;
+            case Field::AConn: m_conn.aConn = i; break;
+            case Field::AConnAux: m_conn.aConnAux = i; break;
+            default: break;
+            }
+            break;
+        case Ctx::Aux:
+            if (m_field == Field::Seg) m_aux.back().ao.segIndex = i;
+            else if (m_field == Field::T) m_aux.back().ao.t = d;
+            break;
+        case Ctx::Endpoint:
+            if (m_field == Field::CompId) m_endpoints.back().compId = i;
+            else if (m_field == Field::Pin) m_endpoints.back().pin = i;
+            break;
+        case Ctx::Journal:
+            if (m_field == Field::Base) journal.base = u;
+            else if (m_field == Field::Seq) journal.seq = u;
+            break;
+        case Ctx::Point:
+            if (m_pointCount < 2) m_point[m_pointCount] = i;
+            ++m_pointCount;
+            break;
+        default:
+            Scalar();
+            break;
+        }
+    }
+
+    void FinishConnection()
+    {
+        if (!m_aux.empty()) {
+            std::vector<wxPoint> poly;
+            for (const PendingAux& pa : m_aux) {
+                ConnectionInfo::AuxOutput ao = pa.ao;
+                if (pa.pixel) {
+                    if (poly.empty()) {
+                        poly.emplace_back(m_conn.x1, m_conn.y1);
+                        poly.insert(poly.end(), m_conn.turningPoints.begin(), m_conn.turningPoints.end());
+                        poly.emplace_back(m_conn.x2, m_conn.y2);
+                    }
+                    int seg; double t; wxPoint q;
+                    std::tie(seg, t, q) = ProjectPointToPolylineDetailed(pa.pos, poly);
+                    ao.segIndex = seg < 0 ? 0 : seg;
+                    ao.t = t;
+                }
+                m_conn.auxOutputs.push_back(ao);
+            }
+        }
+        m_connList->push_back(std::move(m_conn));
+    }
+
+    // 两个端点：一条带转折点的连接；更多端点：以第一个端点为中心的星形
+    void FinishNet()
+    {
+        if (!m_netHasEndpoints || m_endpoints.size() < 2) return;
+        const Endpoint& center = m_endpoints[0];
+        for (size_t k = 1; k < m_endpoints.size(); ++k) {
+            const Endpoint& other = m_endpoints[k];
+            ConnectionInfo c;
+            c.aIndex = center.compId; c.aPin = center.pin;
+            if (center.hasPos) { c.x1 = center.pos.x; c.y1 = center.pos.y; }
+            c.bIndex = other.compId; c.bPin = other.pin;
+            if (other.hasPos) { c.x2 = other.pos.x; c.y2 = other.pos.y; }
+            if (m_endpoints.size() == 2) c.turningPoints = std::move(m_netPoints);
+            m_connList->push_back(std::move(c));
+        }
+    }
+};
+
+enum class ParseResult { CannotOpen, Error, Ok };
+
+// 映射文件并流式解析；空文件按解析错误处理
+ParseResult ParseFile(const std::string& path, ModelSax& sax, std::string* error)
+{
+    MappedFile file;
+    if (!file.Open(path)) {
+        if (error) *error = "无法打开文件";
+        return ParseResult::CannotOpen;
+    }
+    static const char empty = 0;
+    const char* begin = file.Size() ? file.Data() : &empty;
+    bool ok = false;
+    try { ok = json::sax_parse(begin, begin + file.Size(), &sax); }
+    catch (const std::exception& e) { sax.error = e.what(); }
+    if (!ok && error) *error = sax.error.empty() ? std::string("解析失败") : sax.error;
+    return ok ? ParseResult::Ok : ParseResult::Error;
+}
+
+template <class T>
+void AppendMoved(std::vector<T>& dst, std::vector<T>& src)
+{
+    if (dst.empty()) { dst.swap(src); return; }
+    dst.insert(dst.end(), std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+    src.clear();
+}
+
+} // namespace
+
+bool ReadDesignJson(const std::string& path, std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    JournalMark* mark, std::string* error)
+{
+    ModelSax sax(false);
+    if (ParseFile(path, sax, error) == ParseResult::CannotOpen) return false;
+    AppendMoved(elements, sax.root.elements);
+    AppendMoved(connections, sax.root.connections);
+    if (mark && sax.hasJournal) *mark = sax.journal;
+    return true;
+}
+
+bool ReadNetlistJson(const std::string& path, std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    std::string* error)
+{
+    ModelSax sax(true);
+    if (ParseFile(path, sax, error) != ParseResult::Ok) return false;
+    Section& s = sax.sawNetlist ? sax.netlist : sax.root;
+
+    std::vector<ElementInfo> outElements;
+    if (s.hasComponents) {
+        if (!s.componentsById.empty()) {
+            // 带 id 的元件按 id 放置（同 id 后者覆盖），没有 id 的被丢弃
+            int maxId = -1;
+            for (const auto& kv : s.componentsById) maxId = std::max(maxId, kv.first);
+            outElements.assign((size_t)maxId + 1, ElementInfo());
+            for (auto& kv : s.componentsById) if (kv.first >= 0) outElements[kv.first] = std::move(kv.second);
+        }
+        else outElements.swap(s.components);
+    }
+    else if (s.hasElements) outElements.swap(s.elements);
+
+    elements.swap(outElements);
+    if (s.hasNets) connections.swap(s.netConnections);
+    else if (s.hasConnections) connections.swap(s.connections);
+    else connections.clear();
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "CircuitModel.h"
+#include <string>
+#include <vector>
+
+// ---- 流式 JSON 读取 ----
+// 以 SAX 方式扫描内存映射的文件，边解析边填 ElementInfo/ConnectionInfo，不构建整份 json DOM；
+// 除最终模型外只保留当前正在读的一条记录（网表中一个线网的端点），峰值内存接近模型本身大小
+
+// 读取 JSON 设计文件（SaveDesignFile 的格式）追加到 elements/connections。
+// 文件打不开返回 false；解析出错时保留已读完的元件/连接并返回 true，错误信息写入 error
+bool ReadDesignJson(const std::string& path, std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    JournalMark* mark = nullptr, std::string* error = nullptr);
+
+// 读取通用网表：顶层或 "netlist" 对象下的 components（可带 id）/elements，以及 nets（endpoints 多于两个时
+// 以第一个端点为中心拆成星形连接）/connections。成功时替换 elements/connections；失败时不修改并返回 false
+bool ReadNetlistJson(const std::string& path, std::vector<ElementInfo>& elements, std::vector<ConnectionInfo>& connections,
+    std::string* error = nullptr);
@@ -0,0 +1,271 @@
+#pragma once
+#include "CircuitModel.h"
+#include "ElementDraw.h"
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define OBSTACLE_MAP_SIMD 1
+#endif
+
+// ---- 路由障碍图 ----
+// 持久的占用网格：每个路由格子记录被多少个元件（外扩 Padding 后）覆盖，并按区块登记元件索引。
+// 元件增删、移动、改尺寸时增量维护；路由只按需查询访问到的格子，开销与元件总数无关。
+// 区块内另以 SoA 形式保存元件的精确矩形，供轴对齐线段的批量相交检测（SSE2/AVX2）
+class ObstacleMap
+{
+    struct Chunk;
+public:
+    static const int GridSize = 10;   // 与 A* 网格一致
+    static const int Padding = 8;     // 元件四周的禁行外扩
+
+    // 网格坐标下的闭区间矩形
+    struct CellRect {
+        int gx0 = 0, gy0 = 0, gx1 = -1, gy1 = -1;
+        bool Empty() const { return gx1 < gx0 || gy1 < gy0; }
+        bool Contains(int gx, int gy) const { return gx >= gx0 && gx <= gx1 && gy >= gy0 && gy <= gy1; }
+    };
+
+    // 元件本体的闭区间矩形（与 wxRect(x, y, w, h) 的 GetRight/GetBottom 一致）
+    struct ElemRect { int x0 = 0, y0 = 0, x1 = -1, y1 = -1; };
+    static ElemRect ElementBody(const ElementInfo& e)
+    {
+        int sz = std::max(1, e.size);
+        return ElemRect{ e.x, e.y, e.x + BaseElemWidth * sz - 1, e.y + BaseElemHeight * sz - 1 };
+    }
+
+    // 元件覆盖的格子（坐标换算与路由网格一致：直接整除 GridSize）
+    static CellRect ElementCells(const ElementInfo& e)
+    {
+        int sz = std::max(1, e.size);
+        CellRect r;
+        r.gx0 = (e.x - Padding) / GridSize;
+        r.gy0 = (e.y - Padding) / GridSize;
+        r.gx1 = (e.x + BaseElemWidth * sz + Padding) / GridSize;
+        r.gy1 = (e.y + BaseElemHeight * sz + Padding) / GridSize;
+        return r;
+    }
+
+    void Rebuild(const std::vector<ElementInfo>& elements)
+    {
+        m_chunks.clear();
+        m_cells.clear();
+        m_extent = CellRect();
+        for (size_t i = 0; i < elements.size(); ++i) Add((int)i, elements[i]);
+    }
+
+    // 登记元件 idx（新增元件或重新登记）
+    void Add(int idx, const ElementInfo& e)
+    {
+        if (idx < 0) return;
+        if ((int)m_cells.size() <= idx) m_cells.resize(idx + 1);
+        if (!m_cells[idx].Empty()) Remove(idx);
+        CellRect r = ElementCells(e);
+        m_cells[idx] = r;
+        Stamp(r, idx, +1, ElementBody(e));
+        if (m_extent.Empty()) m_extent = r;
+        else {
+            m_extent.gx0 = std::min(m_extent.gx0, r.gx0); m_extent.gy0 = std::min(m_extent.gy0, r.gy0);
+            m_extent.gx1 = std::max(m_extent.gx1, r.gx1); m_extent.gy1 = std::max(m_extent.gy1, r.gy1);
+        }
+    }
+
+    // 元件移动或改尺寸后调用
+    void Update(int idx, const ElementInfo& e) { Add(idx, e); }
+
+    // 注销元件 idx 的占用（索引保留）
+    void Remove(int idx)
+    {
+        if (idx < 0 || idx >= (int)m_cells.size() || m_cells[idx].Empty()) return;
+        Stamp(m_cells[idx], idx, -1, ElemRect());
+        m_cells[idx] = CellRect();
+    }
+
+    // 删除元件：之后的元件索引整体前移，与 m_elements.erase 一致
+    void EraseElement(int idx)
+    {
+        if (idx < 0 || idx >= (int)m_cells.size()) return;
+        Remove(idx);
+        m_cells.erase(m_cells.begin() + idx);
+        for (auto& kv : m_chunks)
+            for (int& ei : kv.second.elems) if (ei > idx) --ei;
+    }
+
+    // 登记过的格子的包围范围（删除/移动后只增不减，Rebuild 时重算）
+    CellRect Extent() const { return m_extent; }
+    CellRect RegisteredCells(int idx) const { return (idx >= 0 && idx < (int)m_cells.size()) ? m_cells[idx] : CellRect(); }
+
+    int Count(int gx, int gy) const
+    {
+        const Chunk* c = FindChunk(FloorDiv(gx, ChunkCells), FloorDiv(gy, ChunkCells));
+        return c ? c->count[LocalIndex(gx, gy)] : 0;
+    }
+
+    // 对与 r 同区块登记的元件依次调用 fn(index)；跨多个区块的元件会被访问多次
+    template<class Fn>
+    void ForEachElementNear(const CellRect& r, Fn fn) const
+    {
+        if (r.Empty()) return;
+        for (int cy = FloorDiv(r.gy0, ChunkCells); cy <= FloorDiv(r.gy1, ChunkCells); ++cy)
+            for (int cx = FloorDiv(r.gx0, ChunkCells); cx <= FloorDiv(r.gx1, ChunkCells); ++cx) {
+                const Chunk* c = FindChunk(cx, cy);
+                if (!c) continue;
+                for (int ei : c->elems) fn(ei);
+            }
+    }
+
+    // 轴对齐线段 a-b（闭区间）是否碰到 exceptA/exceptB 以外的元件本体。
+    // 只检查线段经过的区块；区块内按 SIMD 宽度批量比较，命中即返回
+    bool SegmentBlocked(const wxPoint& a, const wxPoint& b, int exceptA, int exceptB) const
+    {
+        const int sx0 = std::min(a.x, b.x), sx1 = std::max(a.x, b.x);
+        const int sy0 = std::min(a.y, b.y), sy1 = std::max(a.y, b.y);
+        // 元件本体落在其登记格子内，线段包围盒所在区块之外的元件不可能相交
+        const int cx0 = FloorDiv(sx0 / GridSize, ChunkCells), cx1 = FloorDiv(sx1 / GridSize, ChunkCells);
+        const int cy0 = FloorDiv(sy0 / GridSize, ChunkCells), cy1 = FloorDiv(sy1 / GridSize, ChunkCells);
+        for (int cy = cy0; cy <= cy1; ++cy)
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                const Chunk* c = FindChunk(cx, cy);
+                if (c && AnyRectOverlap(*c, sx0, sy0, sx1, sy1, exceptA, exceptB)) return true;
+            }
+        return false;
+    }
+
+    // 单次路由的只读查询：排除两端元件自身的占用，缓存最近访问的区块
+    class Probe
+    {
+    public:
+        Probe(const ObstacleMap& map, int exceptA, int exceptB)
+            : m_map(map), m_exA(map.RegisteredCells(exceptA)), m_exB(exceptB != exceptA ? map.RegisteredCells(exceptB) : CellRect()) {}
+
+        bool Blocked(int gx, int gy) const
+        {
+            int cx = FloorDiv(gx, ChunkCells), cy = FloorDiv(gy, ChunkCells);
+            if (!m_cached || cx != m_cx || cy != m_cy) {
+                m_chunk = m_map.FindChunk(cx, cy);
+                m_cx = cx; m_cy = cy; m_cached = true;
+            }
+            if (!m_chunk) return false;
+            int n = m_chunk->count[LocalIndex(gx, gy)];
+            if (n == 0) return false;
+            if (m_exA.Contains(gx, gy)) --n;
+            if (m_exB.Contains(gx, gy)) --n;
+            return n > 0;
+        }
+
+    private:
+        const ObstacleMap& m_map;
+        CellRect m_exA, m_exB;
+        mutable const Chunk* m_chunk = nullptr;
+        mutable int m_cx = 0, m_cy = 0;
+        mutable bool m_cached = false;
+    };
+
+private:
+    static const int ChunkCells = 64; // 区块边长（格子数）
+
+    struct Chunk {
+        std::vector<uint16_t> count = std::vector<uint16_t>(ChunkCells * ChunkCells, 0);
+        std::vector<int> elems;  // 覆盖到本区块的元件索引
+        // 与 elems 一一对应的元件本体矩形（SoA）
+        std::vector<int32_t> x0, y0, x1, y1;
+
+        void Push(int idx, const ElemRect& r)
+        {
+            elems.push_back(idx);
+            x0.push_back(r.x0); y0.push_back(r.y0); x1.push_back(r.x1); y1.push_back(r.y1);
+        }
+        void Erase(int idx)
+        {
+            auto it = std::find(elems.begin(), elems.end(), idx);
+            if (it == elems.end()) return;
+            size_t k = (size_t)(it - elems.begin()), last = elems.size() - 1;
+            elems[k] = elems[last]; x0[k] = x0[last]; y0[k] = y0[last]; x1[k] = x1[last]; y1[k] = y1[last];
+            elems.pop_back(); x0.pop_back(); y0.pop_back(); x1.pop_back(); y1.pop_back();
+        }
+    };
+    std::unordered_map<uint64_t, Chunk> m_chunks;
+    std::vector<CellRect> m_cells;  // 每个元件登记时的格子范围
+    CellRect m_extent;
+
+    static int FloorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+    static int LocalIndex(int gx, int gy)
+    {
+        return (gy - FloorDiv(gy, ChunkCells) * ChunkCells) * ChunkCells + (gx - FloorDiv(gx, ChunkCells) * ChunkCells);
+    }
+    static uint64_t Key(int cx, int cy) { return ((uint64_t)(uint32_t)cy << 32) | (uint32_t)cx; }
+
+    const Chunk* FindChunk(int cx, int cy) const
+    {
+        auto it = m_chunks.find(Key(cx, cy));
+        return it == m_chunks.end() ? nullptr : &it->second;
+    }
+
+    // 闭区间矩形相交：!(s.x0 > x1 || x0 > s.x1 || s.y0 > y1 || y0 > s.y1)，并排除两端元件
+    static bool AnyRectOverlap(const Chunk& c, int sx0, int sy0, int sx1, int sy1, int exceptA, int exceptB)
+    {
+        const size_t n = c.elems.size();
+        size_t i = 0;
+#if defined(OBSTACLE_MAP_SIMD) && defined(__AVX2__)
+        {
+            const __m256i vsx0 = _mm256_set1_epi32(sx0), vsx1 = _mm256_set1_epi32(sx1);
+            const __m256i vsy0 = _mm256_set1_epi32(sy0), vsy1 = _mm256_set1_epi32(sy1);
+            const __m256i vexA = _mm256_set1_epi32(exceptA), vexB = _mm256_set1_epi32(exceptB);
+            for (; i + 8 <= n; i += 8) {
+                __m256i miss = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpgt_epi32(vsx0, _mm256_loadu_si256((const __m256i*)&c.x1[i])),
+                        _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)&c.x0[i]), vsx1)),
+                    _mm256_or_si256(_mm256_cmpgt_epi32(vsy0, _mm256_loadu_si256((const __m256i*)&c.y1[i])),
+                        _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)&c.y0[i]), vsy1)));
+                __m256i idx = _mm256_loadu_si256((const __m256i*)&c.elems[i]);
+                miss = _mm256_or_si256(miss, _mm256_or_si256(_mm256_cmpeq_epi32(idx, vexA), _mm256_cmpeq_epi32(idx, vexB)));
+                if (_mm256_movemask_epi8(miss) != -1) return true;
+            }
+        }
+#endif
+#if defined(OBSTACLE_MAP_SIMD)
+        {
+            const __m128i vsx0 = _mm_set1_epi32(sx0), vsx1 = _mm_set1_epi32(sx1);
+            const __m128i vsy0 = _mm_set1_epi32(sy0), vsy1 = _mm_set1_epi32(sy1);
+            const __m128i vexA = _mm_set1_epi32(exceptA), vexB = _mm_set1_epi32(exceptB);
+            for (; i + 4 <= n; i += 4) {
+                __m128i miss = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpgt_epi32(vsx0, _mm_loadu_si128((const __m128i*)&c.x1[i])),
+                        _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)&c.x0[i]), vsx1)),
+                    _mm_or_si128(_mm_cmpgt_epi32(vsy0, _mm_loadu_si128((const __m128i*)&c.y1[i])),
+                        _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)&c.y0[i]), vsy1)));
+                __m128i idx = _mm_loadu_si128((const __m128i*)&c.elems[i]);
+                miss = _mm_or_si128(miss, _mm_or_si128(_mm_cmpeq_epi32(idx, vexA), _mm_cmpeq_epi32(idx, vexB)));
+                if (_mm_movemask_epi8(miss) != 0xFFFF) return true;
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            if (c.elems[i] == exceptA || c.elems[i] == exceptB) continue;
+            if (sx0 > c.x1[i] || c.x0[i] > sx1 || sy0 > c.y1[i] || c.y0[i] > sy1) continue;
+            return true;
+        }
+        return false;
+    }
+
+    void Stamp(const CellRect& r, int idx, int delta, const ElemRect& body)
+    {
+        for (int cy = FloorDiv(r.gy0, ChunkCells); cy <= FloorDiv(r.gy1, ChunkCells); ++cy)
+            for (int cx = FloorDiv(r.gx0, ChunkCells); cx <= FloorDiv(r.gx1, ChunkCells); ++cx) {
+                Chunk& c = m_chunks[Key(cx, cy)];
+                int x0 = std::max(r.gx0, cx * ChunkCells), x1 = std::min(r.gx1, cx * ChunkCells + ChunkCells - 1);
+                int y0 = std::max(r.gy0, cy * ChunkCells), y1 = std::min(r.gy1, cy * ChunkCells + ChunkCells - 1);
+                for (int gy = y0; gy <= y1; ++gy) {
+                    uint16_t* row = &c.count[(gy - cy * ChunkCells) * ChunkCells];
+                    for (int gx = x0; gx <= x1; ++gx) row[gx - cx * ChunkCells] = (uint16_t)(row[gx - cx * ChunkCells] + delta);
+                }
+                if (delta > 0) c.Push(idx, body);
+                else {
+                    c.Erase(idx);
+                    if (c.elems.empty()) m_chunks.erase(Key(cx, cy));
+                }
+            }
+    }
+};
@@ -0,0 +1,110 @@
+#pragma once
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <type_traits>
+
+// 把 [0, count) 分给若干线程执行 fn(i)，任务按原子计数器领取；threads 为 0 时取硬件线程数。
+// 调用线程本身也参与执行，返回时全部任务已完成。fn 之间不得写共享数据
+template <class Fn>
+void ParallelFor(size_t count, Fn&& fn, unsigned threads = 0)
+{
+    if (count == 0) return;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, count);
+
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) fn(i);
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+}
+
+// 常驻线程池：线程在构造时创建一次，For 可反复调用而不再创建线程，
+// 用于迭代求解里每轮都要并行一次的细粒度循环。For 的语义与 ParallelFor 相同（调用线程也参与执行），
+// 同一时刻只能有一个线程调用 For，fn 内不得再调用同一线程池的 For
+class WorkerPool
+{
+public:
+    explicit WorkerPool(unsigned threads = 0)
+    {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned t = 1; t < threads; ++t) m_threads.emplace_back([this]() { Loop(); });
+    }
+    ~WorkerPool()
+    {
+        { std::lock_guard<std::mutex> lock(m_mutex); m_stop = true; }
+        m_wake.notify_all();
+        for (auto& th : m_threads) th.join();
+    }
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned Size() const { return (unsigned)m_threads.size() + 1; }
+
+    template <class Fn>
+    void For(size_t count, Fn&& fn)
+    {
+        if (count == 0) return;
+        if (m_threads.empty() || count == 1) {
+            for (size_t i = 0; i < count; ++i) fn(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_call = [](void* ctx, size_t i) { (*static_cast<typename std::remove_reference<Fn>::type*>(ctx))(i); };
+            m_ctx = (void*)&fn;
+            m_count = count;
+            m_next.store(0);
+            m_busy = (unsigned)m_threads.size();
+            ++m_generation;
+        }
+        m_wake.notify_all();
+        Run(m_call, m_ctx, count);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_busy == 0; });
+    }
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_done;
+    void (*m_call)(void*, size_t) = nullptr;
+    void* m_ctx = nullptr;
+    size_t m_count = 0;
+    std::atomic<size_t> m_next{ 0 };
+    unsigned m_busy = 0;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+
+    void Run(void (*call)(void*, size_t), void* ctx, size_t count)
+    {
+        for (size_t i = m_next.fetch_add(1); i < count; i = m_next.fetch_add(1)) call(ctx, i);
+    }
+
+    void Loop()
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&]() { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+            void (*call)(void*, size_t) = m_call;
+            void* ctx = m_ctx;
+            const size_t count = m_count;
+            lock.unlock();
+            Run(call, ctx, count);
+            lock.lock();
+            if (--m_busy == 0) m_done.notify_one();
+        }
+    }
+};
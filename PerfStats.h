@@ -0,0 +1,95 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+// ---- 性能统计 ----
+// 编辑器内置的耗时采样，用于定位卡顿来自哪个子系统（无需外部 profiler）
+
+// 计时器：构造时开始，ElapsedMs() 返回经过的毫秒数
+class PerfTimer
+{
+public:
+    PerfTimer() : m_start(std::chrono::steady_clock::now()) {}
+    double ElapsedMs() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// 滚动统计：只保留最近 capacity 个样本（环形缓冲），按需计算分位数
+class RollingStat
+{
+public:
+    explicit RollingStat(size_t capacity = 256) : m_capacity(std::max<size_t>(1, capacity)) { m_samples.reserve(m_capacity); }
+
+    void Add(double v)
+    {
+        if (m_samples.size() < m_capacity) m_samples.push_back(v);
+        else m_samples[m_next] = v;
+        m_next = (m_next + 1) % m_capacity;
+        m_last = v;
+        ++m_total;
+    }
+
+    uint64_t Total() const { return m_total; }
+    double Last() const { return m_last; }
+
+    // p 取 0..1；没有样本时返回 0
+    double Percentile(double p) const
+    {
+        if (m_samples.empty()) return 0.0;
+        m_scratch = m_samples;
+        size_t k = (size_t)std::min<double>((double)m_scratch.size() - 1, p * (m_scratch.size() - 1) + 0.5);
+        std::nth_element(m_scratch.begin(), m_scratch.begin() + k, m_scratch.end());
+        return m_scratch[k];
+    }
+
+    // 一行摘要：最近值 / p50 / p99 / 样本总数
+    std::string Summary(const char* name, const char* unit = "ms") const
+    {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "%-10s %8.2f  p50 %8.2f  p99 %8.2f %s  (%llu)", name, m_last,
+            Percentile(0.50), Percentile(0.99), unit, (unsigned long long)m_total);
+        return buf;
+    }
+
+private:
+    size_t m_capacity;
+    std::vector<double> m_samples;
+    size_t m_next = 0;
+    double m_last = 0.0;
+    uint64_t m_total = 0;
+    mutable std::vector<double> m_scratch;
+};
+
+// 热点函数的累计调用次数与耗时（可在多线程中累加）；按区间取差值得到一次操作内的开销
+struct HotPathCounter {
+    std::atomic<uint64_t> calls{ 0 };
+    std::atomic<uint64_t> nanos{ 0 };
+
+    struct Snapshot { uint64_t calls = 0, nanos = 0; };
+    Snapshot Take() const { return Snapshot{ calls.load(), nanos.load() }; }
+
+    // 作用域计时：析构时累加一次调用
+    class Scope
+    {
+    public:
+        explicit Scope(HotPathCounter& c) : m_counter(c), m_start(std::chrono::steady_clock::now()) {}
+        ~Scope()
+        {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+            m_counter.calls.fetch_add(1, std::memory_order_relaxed);
+            m_counter.nanos.fetch_add((uint64_t)ns, std::memory_order_relaxed);
+        }
+    private:
+        HotPathCounter& m_counter;
+        std::chrono::steady_clock::time_point m_start;
+    };
+};
@@ -0,0 +1,869 @@
+#include "Placer.h"
+#include "ElementDraw.h"
+#include "ObstacleMap.h"
+#include "ParallelFor.h"
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <random>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+
+const int kGrid = ObstacleMap::GridSize;
+
+// 线网引脚按 CSR 存放：线网 k 的引脚为 [start[k], start[k+1])。
+// elem >= 0 的引脚位于元件原点 + (ox, oy)；elem < 0 为固定引脚，(ox, oy) 即其坐标
+struct PlacementNets {
+    std::vector<size_t> start;
+    std::vector<int> elem;
+    std::vector<double> ox, oy;
+    size_t Count() const { return start.empty() ? 0 : start.size() - 1; }
+
+    void AddPin(int e, double x, double y) { elem.push_back(e); ox.push_back(x); oy.push_back(y); }
+};
+
+PlacementNets BuildNets(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections)
+{
+    const int n = (int)elements.size();
+    const ConnectionNets cn = BuildConnectionNets(elements.size(), connections);
+    std::vector<std::vector<size_t>> groups(cn.Count());
+    for (size_t ci = 0; ci < connections.size(); ++ci) groups[cn.netOf[ci]].push_back(ci);
+
+    PlacementNets nets;
+    for (size_t k = 0; k < groups.size(); ++k) {
+        const auto& g = groups[k];
+        const size_t first = nets.elem.size();
+        nets.start.push_back(first);
+        const auto& r = connections[cn.root[k]];
+        if (r.aIndex >= 0 && r.aIndex < n) {
+            const ElementInfo& e = elements[r.aIndex];
+            wxPoint p = ElementOutputPoint(e, r.aPin < 0 ? 0 : r.aPin);
+            nets.AddPin(r.aIndex, p.x - e.x, p.y - e.y);
+        }
+        else nets.AddPin(-1, r.x1, r.y1);
+        for (size_t ci : g) {
+            const auto& c = connections[ci];
+            if (c.bIndex >= 0 && c.bIndex < n) {
+                const ElementInfo& e = elements[c.bIndex];
+                wxPoint p = ElementInputPoint(e, c.bPin < 0 ? 0 : c.bPin);
+                nets.AddPin(c.bIndex, p.x - e.x, p.y - e.y);
+            }
+            else nets.AddPin(-1, c.x2, c.y2);
+        }
+        if (nets.elem.size() - first < 2) {
+            nets.start.pop_back();
+            nets.elem.resize(first); nets.ox.resize(first); nets.oy.resize(first);
+        }
+    }
+    nets.start.push_back(nets.elem.size());
+    return nets;
+}
+
+inline double PinX(const PlacementNets& nets, size_t p, const std::vector<double>& x)
+{
+    return nets.elem[p] >= 0 ? x[nets.elem[p]] + nets.ox[p] : nets.ox[p];
+}
+inline double PinY(const PlacementNets& nets, size_t p, const std::vector<double>& y)
+{
+    return nets.elem[p] >= 0 ? y[nets.elem[p]] + nets.oy[p] : nets.oy[p];
+}
+
+double NetsHPWL(const PlacementNets& nets, const std::vector<double>& x, const std::vector<double>& y)
+{
+    double total = 0.0;
+    for (size_t k = 0; k < nets.Count(); ++k) {
+        double x0 = 1e300, x1 = -1e300, y0 = 1e300, y1 = -1e300;
+        for (size_t p = nets.start[k]; p < nets.start[k + 1]; ++p) {
+            double px = PinX(nets, p, x), py = PinY(nets, p, y);
+            x0 = std::min(x0, px); x1 = std::max(x1, px);
+            y0 = std::min(y0, py); y1 = std::max(y1, py);
+        }
+        total += (x1 - x0) + (y1 - y0);
+    }
+    return total;
+}
+
+// 单个坐标轴上的对称正定方程组 A v = b：对角线单独存放，非对角元为 CSR（重复项不合并）
+struct AxisSystem {
+    std::vector<double> diag, b;
+    std::vector<size_t> rowStart;
+    std::vector<int> col;
+    std::vector<double> val;
+};
+
+// Bound2Bound 线网模型：每个引脚只与该轴上的两个边界引脚相连，权重 2 / ((k - 1) * 距离)，
+// 在当前坐标处与 HPWL 等价。var[e] 为元件 e 的变量下标（不移动的元件为 -1）
+void BuildAxisSystem(const PlacementNets& nets, const std::vector<double>& pos, const std::vector<double>& offset,
+    const std::vector<int>& var, size_t varCount, AxisSystem& sys)
+{
+    struct Entry { int row, col; double w; };
+    std::vector<Entry> entries;
+    sys.diag.assign(varCount, 0.0);
+    sys.b.assign(varCount, 0.0);
+
+    auto pinPos = [&](size_t p) { return nets.elem[p] >= 0 ? pos[nets.elem[p]] + offset[p] : offset[p]; };
+    auto varOf = [&](size_t p) { return nets.elem[p] >= 0 ? var[nets.elem[p]] : -1; };
+    auto addEdge = [&](size_t i, size_t j, double w) {
+        if (nets.elem[i] >= 0 && nets.elem[i] == nets.elem[j]) return;
+        int vi = varOf(i), vj = varOf(j);
+        if (vi >= 0) {
+            sys.diag[vi] += w;
+            if (vj >= 0) { entries.push_back(Entry{ vi, vj, -w }); sys.b[vi] += w * (offset[j] - offset[i]); }
+            else sys.b[vi] += w * (pinPos(j) - offset[i]);
+        }
+        if (vj >= 0) {
+            sys.diag[vj] += w;
+            if (vi >= 0) { entries.push_back(Entry{ vj, vi, -w }); sys.b[vj] += w * (offset[i] - offset[j]); }
+            else sys.b[vj] += w * (pinPos(i) - offset[j]);
+        }
+        };
+
+    for (size_t k = 0; k < nets.Count(); ++k) {
+        const size_t s = nets.start[k], e = nets.start[k + 1];
+        size_t lo = s, hi = s;
+        for (size_t p = s + 1; p < e; ++p) {
+            if (pinPos(p) < pinPos(lo)) lo = p;
+            if (pinPos(p) >= pinPos(hi)) hi = p;
+        }
+        if (lo == hi) hi = (lo == s) ? s + 1 : s;
+        const double scale = 2.0 / (double)(e - s - 1);
+        auto weight = [&](size_t i, size_t j) { return scale / std::max((double)kGrid, std::abs(pinPos(i) - pinPos(j))); };
+        addEdge(lo, hi, weight(lo, hi));
+        for (size_t p = s; p < e; ++p) {
+            if (p == lo || p == hi) continue;
+            addEdge(p, lo, weight(p, lo));
+            addEdge(p, hi, weight(p, hi));
+        }
+    }
+
+    sys.rowStart.assign(varCount + 1, 0);
+    for (const auto& en : entries) ++sys.rowStart[en.row + 1];
+    for (size_t i = 0; i < varCount; ++i) sys.rowStart[i + 1] += sys.rowStart[i];
+    sys.col.resize(entries.size());
+    sys.val.resize(entries.size());
+    std::vector<size_t> fill(sys.rowStart.begin(), sys.rowStart.end() - 1);
+    for (const auto& en : entries) {
+        size_t at = fill[en.row]++;
+        sys.col[at] = en.col; sys.val[at] = en.w;
+    }
+}
+
+// out = A v；行数多时按块在常驻线程池上并行（每次 CG 迭代都要调用，不能每次新建线程）
+void Multiply(const AxisSystem& sys, const std::vector<double>& v, std::vector<double>& out, WorkerPool& pool)
+{
+    const size_t n = sys.diag.size();
+    const size_t block = 4096;
+    auto rows = [&](size_t r0, size_t r1) {
+        for (size_t i = r0; i < r1; ++i) {
+            double acc = sys.diag[i] * v[i];
+            for (size_t k = sys.rowStart[i]; k < sys.rowStart[i + 1]; ++k) acc += sys.val[k] * v[sys.col[k]];
+            out[i] = acc;
+        }
+        };
+    if (pool.Size() <= 1 || n < 4 * block) { rows(0, n); return; }
+    pool.For((n + block - 1) / block, [&](size_t bi) { rows(bi * block, std::min(n, (bi + 1) * block)); });
+}
+
+double Dot(const std::vector<double>& a, const std::vector<double>& b)
+{
+    double s = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) s += a[i] * b[i];
+    return s;
+}
+
+// Jacobi 预条件共轭梯度，v 为初值（热启动）并返回解
+void SolveCG(const AxisSystem& sys, std::vector<double>& v, int maxIter, double tol, WorkerPool& pool)
+{
+    const size_t n = sys.diag.size();
+    if (n == 0) return;
+    std::vector<double> r(n), z(n), p(n), ap(n);
+    Multiply(sys, v, ap, pool);
+    for (size_t i = 0; i < n; ++i) r[i] = sys.b[i] - ap[i];
+    const double bnorm = std::sqrt(Dot(sys.b, sys.b));
+    if (bnorm == 0.0) return;
+    for (size_t i = 0; i < n; ++i) { z[i] = r[i] / sys.diag[i]; p[i] = z[i]; }
+    double rz = Dot(r, z);
+    for (int it = 0; it < maxIter; ++it) {
+        if (std::sqrt(Dot(r, r)) <= tol * bnorm) break;
+        Multiply(sys, p, ap, pool);
+        const double pap = Dot(p, ap);
+        if (pap <= 0.0) break;
+        const double alpha = rz / pap;
+        for (size_t i = 0; i < n; ++i) { v[i] += alpha * p[i]; r[i] -= alpha * ap[i]; }
+        for (size_t i = 0; i < n; ++i) z[i] = r[i] / sys.diag[i];
+        const double rzNew = Dot(r, z);
+        const double beta = rzNew / rz;
+        rz = rzNew;
+        for (size_t i = 0; i < n; ++i) p[i] = z[i] + beta * p[i];
+    }
+}
+
+struct Region { double x0, y0, x1, y1; };
+
+// 按面积递归二分扩散：沿区域长边把元件按坐标对半分，切线位置按两半面积占比确定，
+// 每层的子区域互不相交、并行处理；叶子区域内按行排布，得到近乎不重叠的目标位置。
+// w/h 含间距，cx/cy 为当前中心，输出 tx/ty 为目标中心
+void SpreadByBisection(const std::vector<double>& w, const std::vector<double>& h,
+    const std::vector<double>& cx, const std::vector<double>& cy, const Region& region,
+    std::vector<double>& tx, std::vector<double>& ty, WorkerPool& pool)
+{
+    const size_t m = w.size();
+    const size_t leafCells = 12;
+    std::vector<int> order(m);
+    for (size_t i = 0; i < m; ++i) order[i] = (int)i;
+    tx.assign(m, 0.0); ty.assign(m, 0.0);
+
+    struct Task { size_t begin = 0, end = 0; Region r{}; };
+    std::vector<Task> level(1, Task{ 0, m, region }), next;
+
+    auto packLeaf = [&](const Task& t) {
+        std::vector<int> cells(order.begin() + t.begin, order.begin() + t.end);
+        std::sort(cells.begin(), cells.end(), [&](int a, int b) { return cy[a] != cy[b] ? cy[a] < cy[b] : a < b; });
+        const double rw = t.r.x1 - t.r.x0, rh = t.r.y1 - t.r.y0;
+        // 分行：每行宽度不超过区域宽度（至少一个元件）
+        std::vector<size_t> rowBegin;
+        std::vector<double> rowHeight;
+        double used = rw + 1.0, totalHeight = 0.0;
+        for (size_t k = 0; k < cells.size(); ++k) {
+            if (used + w[cells[k]] > rw) {
+                rowBegin.push_back(k); rowHeight.push_back(0.0); used = 0.0;
+            }
+            used += w[cells[k]];
+            rowHeight.back() = std::max(rowHeight.back(), h[cells[k]]);
+        }
+        rowBegin.push_back(cells.size());
+        for (double rhk : rowHeight) totalHeight += rhk;
+        const size_t rows = rowHeight.size();
+        const double vgap = std::max(0.0, (rh - totalHeight) / (double)(rows + 1));
+        double y = t.r.y0 + (totalHeight > rh ? (rh - totalHeight) / 2.0 : vgap);
+        for (size_t ri = 0; ri < rows; ++ri) {
+            auto b = cells.begin() + rowBegin[ri], e = cells.begin() + rowBegin[ri + 1];
+            std::sort(b, e, [&](int a, int c) { return cx[a] != cx[c] ? cx[a] < cx[c] : a < c; });
+            double rowWidth = 0.0;
+            for (auto it = b; it != e; ++it) rowWidth += w[*it];
+            const double hgap = std::max(0.0, (rw - rowWidth) / (double)((e - b) + 1));
+            double x = t.r.x0 + (rowWidth > rw ? (rw - rowWidth) / 2.0 : hgap);
+            for (auto it = b; it != e; ++it) {
+                tx[*it] = x + w[*it] / 2.0;
+                ty[*it] = y + rowHeight[ri] / 2.0;
+                x += w[*it] + hgap;
+            }
+            y += rowHeight[ri] + vgap;
+        }
+        };
+
+    while (!level.empty()) {
+        next.assign(level.size() * 2, Task());
+        pool.For(level.size(), [&](size_t ti) {
+            const Task& t = level[ti];
+            const size_t count = t.end - t.begin;
+            if (count == 0) return;
+            const double rw = t.r.x1 - t.r.x0, rh = t.r.y1 - t.r.y0;
+            if (count <= leafCells) { packLeaf(t); return; }
+            const bool alongX = rw >= rh;
+            const std::vector<double>& key = alongX ? cx : cy;
+            const size_t mid = t.begin + count / 2;
+            std::nth_element(order.begin() + t.begin, order.begin() + mid, order.begin() + t.end,
+                [&](int a, int b) { return key[a] != key[b] ? key[a] < key[b] : a < b; });
+            double areaLow = 0.0, area = 0.0;
+            for (size_t k = t.begin; k < t.end; ++k) {
+                double ak = w[order[k]] * h[order[k]];
+                area += ak;
+                if (k < mid) areaLow += ak;
+            }
+            const double frac = area > 0.0 ? areaLow / area : 0.5;
+            Region lowR = t.r, highR = t.r;
+            if (alongX) lowR.x1 = highR.x0 = t.r.x0 + rw * frac;
+            else lowR.y1 = highR.y0 = t.r.y0 + rh * frac;
+            next[ti * 2] = Task{ t.begin, mid, lowR };
+            next[ti * 2 + 1] = Task{ mid, t.end, highR };
+            });
+        level.clear();
+        for (const auto& t : next) if (t.end > t.begin) level.push_back(t);
+    }
+}
+
+inline int SnapCoord(double v) { return (int)std::lround(v / kGrid) * kGrid; }
+
+// 元件本体矩形，半开区间 [x0, x1) x [y0, y1)
+struct BodyRect { int x0, y0, x1, y1; };
+
+inline BodyRect ElementBodyAt(const ElementInfo& e, int x, int y)
+{
+    int sz = std::max(1, e.size);
+    return BodyRect{ x, y, x + BaseElemWidth * sz, y + BaseElemHeight * sz };
+}
+
+inline bool Overlaps(const BodyRect& a, const BodyRect& b)
+{
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+// 按固定边长分桶的元件矩形索引：元件登记到其矩形覆盖的每个桶，查询只访问相关的桶
+class SpatialBins
+{
+public:
+    explicit SpatialBins(int binSize) : m_bin(std::max(kGrid, binSize)) {}
+
+    void Insert(int idx, const BodyRect& r)
+    {
+        for (int by = FloorDiv(r.y0); by <= FloorDiv(r.y1 - 1); ++by)
+            for (int bx = FloorDiv(r.x0); bx <= FloorDiv(r.x1 - 1); ++bx) m_bins[Key(bx, by)].push_back(idx);
+    }
+
+    void Erase(int idx, const BodyRect& r)
+    {
+        for (int by = FloorDiv(r.y0); by <= FloorDiv(r.y1 - 1); ++by)
+            for (int bx = FloorDiv(r.x0); bx <= FloorDiv(r.x1 - 1); ++bx) {
+                auto it = m_bins.find(Key(bx, by));
+                if (it == m_bins.end()) continue;
+                auto& v = it->second;
+                auto at = std::find(v.begin(), v.end(), idx);
+                if (at != v.end()) { *at = v.back(); v.pop_back(); }
+            }
+    }
+
+    // 对与 r 同桶的元件调用 fn(index)，任一返回 true 即停止并返回 true（同一元件可能被访问多次）
+    template<class Fn>
+    bool AnyNear(const BodyRect& r, Fn fn) const
+    {
+        for (int by = FloorDiv(r.y0); by <= FloorDiv(r.y1 - 1); ++by)
+            for (int bx = FloorDiv(r.x0); bx <= FloorDiv(r.x1 - 1); ++bx) {
+                auto it = m_bins.find(Key(bx, by));
+                if (it == m_bins.end()) continue;
+                for (int idx : it->second) if (fn(idx)) return true;
+            }
+        return false;
+    }
+
+private:
+    int m_bin;
+    std::unordered_map<uint64_t, std::vector<int>> m_bins;
+
+    int FloorDiv(int v) const { return v >= 0 ? v / m_bin : -((-v + m_bin - 1) / m_bin); }
+    static uint64_t Key(int bx, int by) { return ((uint64_t)(uint32_t)bx << 32) | (uint32_t)by; }
+};
+
+// 线网包围盒与落在各边界上的引脚数；边界引脚移走且计数归零时需按全部引脚重算
+struct NetBox {
+    int x0 = 0, x1 = 0, y0 = 0, y1 = 0;
+    int nx0 = 0, nx1 = 0, ny0 = 0, ny1 = 0;
+    int64_t Half() const { return (int64_t)(x1 - x0) + (y1 - y0); }
+
+    // 一个引脚从 from 移到 to；返回 false 表示某条边界已无引脚、需要重算
+    bool MovePin(int fromX, int fromY, int toX, int toY)
+    {
+        return MoveAxis(x0, x1, nx0, nx1, fromX, toX) & MoveAxis(y0, y1, ny0, ny1, fromY, toY);
+    }
+
+private:
+    static bool MoveAxis(int& lo, int& hi, int& nlo, int& nhi, int from, int to)
+    {
+        if (from == lo) --nlo;
+        if (from == hi) --nhi;
+        if (to < lo) { lo = to; nlo = 1; }
+        else if (to == lo) ++nlo;
+        if (to > hi) { hi = to; nhi = 1; }
+        else if (to == hi) ++nhi;
+        return nlo > 0 && nhi > 0;
+    }
+};
+
+} // namespace
+
+double PlacementHPWL(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections)
+{
+    PlacementNets nets = BuildNets(elements, connections);
+    std::vector<double> x(elements.size()), y(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i) { x[i] = elements[i].x; y[i] = elements[i].y; }
+    return NetsHPWL(nets, x, y);
+}
+
+PlacementResult GlobalPlace(std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const std::vector<char>& fixed, const PlacementOptions& opts)
+{
+    PlacementResult result;
+    const size_t n = elements.size();
+    if (n == 0) return result;
+    const unsigned threads = opts.threads ? opts.threads : std::max(1u, std::thread::hardware_concurrency());
+    WorkerPool pool(threads);   // 整个布局过程共用，CG 的每次矩阵向量乘与每层二分只做一次派发
+
+    PlacementNets nets = BuildNets(elements, connections);
+    std::vector<double> x(n), y(n);
+    for (size_t i = 0; i < n; ++i) { x[i] = elements[i].x; y[i] = elements[i].y; }
+    result.hpwlBefore = NetsHPWL(nets, x, y);
+
+    // 可移动元件编号；尺寸含间距
+    std::vector<int> var(n, -1);
+    std::vector<int> movable;
+    std::vector<double> w, h;
+    double area = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (i < fixed.size() && fixed[i]) continue;
+        var[i] = (int)movable.size();
+        movable.push_back((int)i);
+        int sz = std::max(1, elements[i].size);
+        w.push_back(BaseElemWidth * sz + opts.spacing);
+        h.push_back(BaseElemHeight * sz + opts.spacing);
+        area += w.back() * h.back();
+    }
+    const size_t m = movable.size();
+    if (m == 0) return result;
+
+    // 布局区域：以固定引脚（无则以当前元件）重心为中心、4:3 的矩形，面积按目标密度
+    double sx = 0.0, sy = 0.0, cnt = 0.0;
+    for (size_t p = 0; p < nets.elem.size(); ++p) {
+        int e = nets.elem[p];
+        if (e >= 0 && var[e] >= 0) continue;
+        sx += PinX(nets, p, x); sy += PinY(nets, p, y); cnt += 1.0;
+    }
+    if (cnt == 0.0) for (int e : movable) { sx += x[e]; sy += y[e]; cnt += 1.0; }
+    const double regionArea = area / std::max(0.05, std::min(1.0, opts.targetDensity));
+    const double regionW = std::sqrt(regionArea * 4.0 / 3.0), regionH = regionArea / regionW;
+    const Region region{ sx / cnt - regionW / 2.0, sy / cnt - regionH / 2.0, sx / cnt + regionW / 2.0, sy / cnt + regionH / 2.0 };
+
+    std::vector<double> offX(nets.ox), offY(nets.oy);
+    std::vector<double> vx(m), vy(m), targetX(m), targetY(m);
+    for (size_t v = 0; v < m; ++v) { vx[v] = targetX[v] = x[movable[v]]; vy[v] = targetY[v] = y[movable[v]]; }
+    std::vector<double> cx(m), cy(m), tcx, tcy;
+    std::vector<double> sxPos(x), syPos(y);
+    AxisSystem sysX, sysY;
+    std::vector<double> spreadHistory;
+
+    for (int it = 0; it < std::max(1, opts.maxIterations); ++it) {
+        result.iterations = it + 1;
+        // 两个坐标轴依次求解，轴内的矩阵向量乘使用全部线程
+        for (size_t axis = 0; axis < 2; ++axis) {
+            AxisSystem& sys = axis == 0 ? sysX : sysY;
+            std::vector<double>& v = axis == 0 ? vx : vy;
+            const std::vector<double>& target = axis == 0 ? targetX : targetY;
+            BuildAxisSystem(nets, axis == 0 ? x : y, axis == 0 ? offX : offY, var, m, sys);
+            double avg = 0.0;
+            for (double d : sys.diag) avg += d;
+            avg = m ? avg / (double)m : 0.0;
+            if (avg <= 0.0) avg = 1.0 / kGrid;
+            // 首轮只加极弱的锚点保证方程组正定；之后逐轮加重，把元件拉向扩散位置
+            const double anchor = avg * (it == 0 ? 1e-3 : opts.anchorStep * it);
+            for (size_t i = 0; i < m; ++i) { sys.diag[i] += anchor; sys.b[i] += anchor * target[i]; }
+            SolveCG(sys, v, opts.cgIterations, opts.cgTolerance, pool);
+        }
+        for (size_t v = 0; v < m; ++v) { x[movable[v]] = vx[v]; y[movable[v]] = vy[v]; }
+
+        for (size_t v = 0; v < m; ++v) { cx[v] = vx[v] + w[v] / 2.0; cy[v] = vy[v] + h[v] / 2.0; }
+        SpreadByBisection(w, h, cx, cy, region, tcx, tcy, pool);
+        for (size_t v = 0; v < m; ++v) {
+            targetX[v] = tcx[v] - w[v] / 2.0; targetY[v] = tcy[v] - h[v] / 2.0;
+            sxPos[movable[v]] = targetX[v]; syPos[movable[v]] = targetY[v];
+        }
+        const double spreadHPWL = NetsHPWL(nets, sxPos, syPos);
+        // 扩散后的线长连续若干轮几乎不再下降即停止
+        spreadHistory.push_back(spreadHPWL);
+        const size_t window = 5;
+        if (spreadHistory.size() > window && spreadHPWL > (1.0 - opts.minImprovement) * spreadHistory[spreadHistory.size() - 1 - window]) break;
+    }
+
+    // 取扩散后的位置（元件四周留有间距的一半）并对齐网格
+    for (size_t v = 0; v < m; ++v) {
+        ElementInfo& e = elements[movable[v]];
+        int nx = SnapCoord(targetX[v] + opts.spacing / 2.0), ny = SnapCoord(targetY[v] + opts.spacing / 2.0);
+        if (nx != e.x || ny != e.y) {
+            e.x = nx; e.y = ny; e.Touch();
+            ++result.moved;
+        }
+    }
+    result.hpwlAfter = PlacementHPWL(elements, connections);
+    return result;
+}
+
+AnnealResult AnnealPlacement(std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const std::vector<char>& fixed, const AnnealOptions& opts, const std::atomic<bool>* cancel, const PlacementProgress& progress)
+{
+    AnnealResult result;
+    const size_t n = elements.size();
+    if (n == 0) return result;
+
+    PlacementNets nets = BuildNets(elements, connections);
+    const size_t netCount = nets.Count(), pinCount = nets.elem.size();
+    std::vector<int> pinOx(pinCount), pinOy(pinCount), pinNet(pinCount);
+    for (size_t p = 0; p < pinCount; ++p) { pinOx[p] = (int)nets.ox[p]; pinOy[p] = (int)nets.oy[p]; }
+    for (size_t k = 0; k < netCount; ++k)
+        for (size_t p = nets.start[k]; p < nets.start[k + 1]; ++p) pinNet[p] = (int)k;
+    // 元件 -> 引脚（CSR）
+    std::vector<size_t> elemPinStart(n + 1, 0);
+    std::vector<int> elemPins(pinCount);
+    for (size_t p = 0; p < pinCount; ++p) if (nets.elem[p] >= 0) ++elemPinStart[nets.elem[p] + 1];
+    for (size_t i = 0; i < n; ++i) elemPinStart[i + 1] += elemPinStart[i];
+    {
+        std::vector<size_t> fill(elemPinStart.begin(), elemPinStart.end() - 1);
+        for (size_t p = 0; p < pinCount; ++p) if (nets.elem[p] >= 0) elemPins[fill[nets.elem[p]]++] = (int)p;
+    }
+
+    std::vector<int> px(n), py(n);
+    std::vector<int> movable;
+    int maxDim = 0;
+    for (size_t i = 0; i < n; ++i) {
+        px[i] = elements[i].x; py[i] = elements[i].y;
+        if (!(i < fixed.size() && fixed[i])) movable.push_back((int)i);
+        int sz = std::max(1, elements[i].size);
+        maxDim = std::max(maxDim, std::max(BaseElemWidth, BaseElemHeight) * sz);
+    }
+    if (movable.empty()) return result;
+
+    auto pinX = [&](size_t p) { return nets.elem[p] >= 0 ? px[nets.elem[p]] + pinOx[p] : pinOx[p]; };
+    auto pinY = [&](size_t p) { return nets.elem[p] >= 0 ? py[nets.elem[p]] + pinOy[p] : pinOy[p]; };
+    auto computeBox = [&](size_t k) {
+        NetBox b;
+        b.x0 = b.y0 = INT32_MAX; b.x1 = b.y1 = INT32_MIN;
+        for (size_t p = nets.start[k]; p < nets.start[k + 1]; ++p) {
+            int x = pinX(p), y = pinY(p);
+            if (x < b.x0) { b.x0 = x; b.nx0 = 0; }
+            if (x == b.x0) ++b.nx0;
+            if (x > b.x1) { b.x1 = x; b.nx1 = 0; }
+            if (x == b.x1) ++b.nx1;
+            if (y < b.y0) { b.y0 = y; b.ny0 = 0; }
+            if (y == b.y0) ++b.ny0;
+            if (y > b.y1) { b.y1 = y; b.ny1 = 0; }
+            if (y == b.y1) ++b.ny1;
+        }
+        return b;
+        };
+    std::vector<NetBox> boxes(netCount);
+    int64_t total = 0;
+    for (size_t k = 0; k < netCount; ++k) { boxes[k] = computeBox(k); total += boxes[k].Half(); }
+    result.hpwlBefore = (double)total;
+
+    SpatialBins bins(maxDim + opts.spacing);
+    for (size_t i = 0; i < n; ++i) bins.Insert((int)i, ElementBodyAt(elements[i], px[i], py[i]));
+
+    // 元件 e 放到 (x, y) 时与其它元件（exA/exB 除外）的间隙是否不小于 spacing
+    auto fits = [&](int e, int x, int y, int exA, int exB) {
+        BodyRect q = ElementBodyAt(elements[e], x, y);
+        q.x0 -= opts.spacing; q.y0 -= opts.spacing; q.x1 += opts.spacing; q.y1 += opts.spacing;
+        return !bins.AnyNear(q, [&](int o) {
+            return o != exA && o != exB && Overlaps(q, ElementBodyAt(elements[o], px[o], py[o]));
+            });
+        };
+
+    // 平移与交换都保持网格偏移，先把未对齐的可移动元件吸附到附近（±2 格内）最近的不冲突网格点；
+    // 附近没有空位时直接取最近的网格点
+    bool snapped = false;
+    for (int e : movable) {
+        const int nx = SnapCoord(px[e]), ny = SnapCoord(py[e]);
+        if (nx == px[e] && ny == py[e]) continue;
+        int bx = nx, by = ny;
+        int64_t best = INT64_MAX;
+        for (int dy = -2; dy <= 2; ++dy) {
+            for (int dx = -2; dx <= 2; ++dx) {
+                const int cx = nx + dx * kGrid, cy = ny + dy * kGrid;
+                const int64_t dist = (int64_t)(cx - px[e]) * (cx - px[e]) + (int64_t)(cy - py[e]) * (cy - py[e]);
+                if (dist < best && fits(e, cx, cy, e, -1)) { best = dist; bx = cx; by = cy; }
+            }
+        }
+        bins.Erase(e, ElementBodyAt(elements[e], px[e], py[e]));
+        px[e] = bx; py[e] = by;
+        bins.Insert(e, ElementBodyAt(elements[e], px[e], py[e]));
+        snapped = true;
+    }
+    if (snapped) {
+        total = 0;
+        for (size_t k = 0; k < netCount; ++k) { boxes[k] = computeBox(k); total += boxes[k].Half(); }
+    }
+
+    // 试探移动：元件 a 到 (ax, ay)，可选元件 b 到 (bx, by)；返回线长增量，试探后的包围盒留在 touched
+    std::vector<uint32_t> netStamp(netCount, 0);
+    std::vector<int> netSlot(netCount, 0);
+    uint32_t stamp = 0;
+    struct Touched { int net; NetBox box; bool recompute; };
+    std::vector<Touched> touched;
+    auto evaluate = [&](int a, int ax, int ay, int b, int bx, int by) -> int64_t {
+        touched.clear();
+        if (++stamp == 0) { std::fill(netStamp.begin(), netStamp.end(), 0); stamp = 1; }
+        auto movePins = [&](int e, int nxPos, int nyPos) {
+            for (size_t q = elemPinStart[e]; q < elemPinStart[e + 1]; ++q) {
+                int p = elemPins[q], k = pinNet[p];
+                if (netStamp[k] != stamp) {
+                    netStamp[k] = stamp; netSlot[k] = (int)touched.size();
+                    touched.push_back(Touched{ k, boxes[k], false });
+                }
+                Touched& t = touched[netSlot[k]];
+                if (t.recompute) continue;
+                if (!t.box.MovePin(px[e] + pinOx[p], py[e] + pinOy[p], nxPos + pinOx[p], nyPos + pinOy[p])) t.recompute = true;
+            }
+            };
+        movePins(a, ax, ay);
+        if (b >= 0) movePins(b, bx, by);
+        int64_t delta = 0;
+        bool anyRecompute = false;
+        for (const auto& t : touched) anyRecompute |= t.recompute;
+        if (anyRecompute) {
+            // 按移动后的坐标重算这些线网
+            const int oax = px[a], oay = py[a], obx = b >= 0 ? px[b] : 0, oby = b >= 0 ? py[b] : 0;
+            px[a] = ax; py[a] = ay;
+            if (b >= 0) { px[b] = bx; py[b] = by; }
+            for (auto& t : touched) if (t.recompute) t.box = computeBox(t.net);
+            px[a] = oax; py[a] = oay;
+            if (b >= 0) { px[b] = obx; py[b] = oby; }
+        }
+        for (const auto& t : touched) delta += t.box.Half() - boxes[t.net].Half();
+        return delta;
+        };
+
+    std::mt19937 rng(opts.seed);
+    auto randInt = [&](int lo, int hi) { return lo + (int)(rng() % (uint32_t)(hi - lo + 1)); };
+    auto rand01 = [&]() { return (rng() >> 8) * (1.0 / 16777216.0); };
+    double radius = std::max(1, opts.maxShiftCells);
+
+    // 生成一次移动：平移到窗口内的网格点，或与该点处的元件交换位置。返回 false 表示不合法
+    struct Move { int a, ax, ay, b, bx, by; };
+    auto propose = [&](Move& mv) -> bool {
+        const int a = movable[rng() % movable.size()];
+        const int r = std::max(1, (int)radius);
+        const int tx = px[a] + randInt(-r, r) * kGrid, ty = py[a] + randInt(-r, r) * kGrid;
+        if (tx == px[a] && ty == py[a]) return false;
+        mv = Move{ a, tx, ty, -1, 0, 0 };
+        if (rng() & 1) {
+            // 交换：取目标点所在的可移动元件
+            int other = -1;
+            BodyRect probe{ tx, ty, tx + 1, ty + 1 };
+            bins.AnyNear(probe, [&](int o) {
+                if (o == a || (o < (int)fixed.size() && fixed[o])) return false;
+                if (!Overlaps(probe, ElementBodyAt(elements[o], px[o], py[o]))) return false;
+                other = o;
+                return true;
+                });
+            if (other >= 0) {
+                mv = Move{ a, px[other], py[other], other, px[a], py[a] };
+                BodyRect ra = ElementBodyAt(elements[a], mv.ax, mv.ay);
+                ra.x0 -= opts.spacing; ra.y0 -= opts.spacing; ra.x1 += opts.spacing; ra.y1 += opts.spacing;
+                if (Overlaps(ra, ElementBodyAt(elements[other], mv.bx, mv.by))) return false;
+                return fits(a, mv.ax, mv.ay, a, other) && fits(other, mv.bx, mv.by, a, other);
+            }
+        }
+        return fits(a, tx, ty, a, -1);
+        };
+    auto commit = [&](const Move& mv, int64_t delta) {
+        for (const auto& t : touched) boxes[t.net] = t.box;
+        total += delta;
+        bins.Erase(mv.a, ElementBodyAt(elements[mv.a], px[mv.a], py[mv.a]));
+        if (mv.b >= 0) bins.Erase(mv.b, ElementBodyAt(elements[mv.b], px[mv.b], py[mv.b]));
+        px[mv.a] = mv.ax; py[mv.a] = mv.ay;
+        bins.Insert(mv.a, ElementBodyAt(elements[mv.a], mv.ax, mv.ay));
+        if (mv.b >= 0) {
+            px[mv.b] = mv.bx; py[mv.b] = mv.by;
+            bins.Insert(mv.b, ElementBodyAt(elements[mv.b], mv.bx, mv.by));
+        }
+        };
+
+    // 初始温度：采样上坡移动的平均增量，使其按 initialAcceptance 的概率被接受
+    double uphill = 0.0;
+    size_t uphillCount = 0;
+    Move mv{};
+    for (size_t s = 0; s < std::min<size_t>(2000, movable.size() * 4); ++s) {
+        if (!propose(mv)) continue;
+        int64_t d = evaluate(mv.a, mv.ax, mv.ay, mv.b, mv.bx, mv.by);
+        if (d > 0) { uphill += (double)d; ++uphillCount; }
+    }
+    const double t0 = uphillCount ? -(uphill / uphillCount) / std::log(std::max(1e-6, std::min(0.99, opts.initialAcceptance))) : 1.0;
+    const int stages = std::max(1, opts.stages);
+    const double cooling = std::pow(std::max(1e-9, opts.finalTemperature), 1.0 / stages);
+    const size_t movesPerStage = std::max<size_t>(1, movable.size() * (size_t)std::max(1, opts.movesPerElement) / stages);
+
+    double temperature = t0;
+    for (int stage = 0; stage < stages; ++stage) {
+        size_t accepted = 0;
+        for (size_t k = 0; k < movesPerStage; ++k) {
+            if (cancel && (k & 255) == 0 && cancel->load(std::memory_order_relaxed)) {
+                result.cancelled = true;
+                result.hpwlAfter = (double)total;
+                return result;
+            }
+            ++result.attempted;
+            if (!propose(mv)) continue;
+            int64_t d = evaluate(mv.a, mv.ax, mv.ay, mv.b, mv.bx, mv.by);
+            if (d <= 0 || rand01() < std::exp(-(double)d / temperature)) {
+                commit(mv, d);
+                ++accepted;
+            }
+        }
+        result.accepted += accepted;
+        // 窗口随接受率自适应：接受率高于约 0.44 时放大，低时收缩
+        const double rate = (double)accepted / (double)movesPerStage;
+        radius = std::max(1.0, std::min((double)std::max(1, opts.maxShiftCells), radius * (0.56 + rate)));
+        temperature *= cooling;
+        if (progress) progress((double)(stage + 1) / stages, (double)total);
+    }
+
+    for (int e : movable) {
+        ElementInfo& el = elements[e];
+        if (el.x != px[e] || el.y != py[e]) {
+            el.x = px[e]; el.y = py[e]; el.Touch();
+            ++result.moved;
+        }
+    }
+    result.hpwlAfter = (double)total;
+    return result;
+}
+
+LegalizeResult LegalizePlacement(std::vector<ElementInfo>& elements, const std::vector<char>& fixed, const LegalizeOptions& opts)
+{
+    LegalizeResult result;
+    const size_t n = elements.size();
+    if (n == 0) return result;
+    auto isFixed = [&](size_t i) { return i < fixed.size() && fixed[i]; };
+
+    int maxDim = 0;
+    for (const auto& e : elements) maxDim = std::max(maxDim, std::max(BaseElemWidth, BaseElemHeight) * std::max(1, e.size));
+    SpatialBins bins(maxDim + opts.spacing);
+    std::vector<int> px(n), py(n);
+    std::vector<char> placed(n, 0);
+
+    // r 扩展 spacing 后是否碰到已放置的元件；碰到时经 blocker 返回扩展后相交的元件矩形
+    auto firstBlocker = [&](const BodyRect& body, BodyRect* blocker) {
+        BodyRect q{ body.x0 - opts.spacing, body.y0 - opts.spacing, body.x1 + opts.spacing, body.y1 + opts.spacing };
+        return bins.AnyNear(q, [&](int o) {
+            BodyRect ro = ElementBodyAt(elements[o], px[o], py[o]);
+            if (!Overlaps(q, ro)) return false;
+            if (blocker) *blocker = ro;
+            return true;
+            });
+        };
+    auto place = [&](size_t i) {
+        placed[i] = 1;
+        bins.Insert((int)i, ElementBodyAt(elements[i], px[i], py[i]));
+        };
+
+    // 固定元件原样占位；其余先对齐网格
+    std::vector<int> order;
+    for (size_t i = 0; i < n; ++i) {
+        px[i] = elements[i].x; py[i] = elements[i].y;
+        if (isFixed(i)) place(i);
+        else {
+            px[i] = SnapCoord(px[i]); py[i] = SnapCoord(py[i]);
+            order.push_back((int)i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return py[a] != py[b] ? py[a] < py[b] : (px[a] != px[b] ? px[a] < px[b] : a < b);
+        });
+
+    // 第一遍：与已保留元件不冲突的原地保留
+    std::vector<int> pending;
+    for (int i : order) {
+        if (!firstBlocker(ElementBodyAt(elements[i], px[i], py[i]), nullptr)) place(i);
+        else pending.push_back(i);
+    }
+
+    // 第二遍：以 (x0, y0) 为中心，按位移由小到大逐行向两侧搜索空位（best-first）。
+    // 每行每个方向保留一个探针，被挡住时直接跳到阻挡元件之外、按新位移重新入堆；
+    // 行本身的位移 |dy| 小于堆顶时才展开下一行。结果与逐行穷举取最小位移（同位移先 dy 序、再向右）相同。
+    // 占用只增不减，挡住的位置之后仍被挡住：行内经跳转表越过已知的阻挡元件；同一点上同尺寸的元件
+    // （如无坐标导入时叠在一起的元件）沿用上一个元件留下的探针继续搜索，不再从头展开各行
+    struct RowProbe {
+        int64_t d;      // |x - x0| + |dy|
+        int k;          // 行序号：dy = 0, +1, -1, +2, -2, ...（以网格为单位）
+        int dir;
+        int x;
+    };
+    auto probeAfter = [](const RowProbe& a, const RowProbe& b) {
+        if (a.d != b.d) return a.d > b.d;
+        if (a.k != b.k) return a.k > b.k;
+        return a.dir < b.dir;
+        };
+    struct RowSearch {
+        std::vector<RowProbe> heap;
+        int nextK = 0;
+        size_t group = 0;
+    };
+    auto rowOffset = [](int k) { return ((k + 1) / 2) * kGrid * ((k & 1) ? 1 : -1); };
+    // 跳转表：按 (行 y, 尺寸, 方向) 记录已知被挡住的位置 x 及越过阻挡元件后的下一个候选位置。
+    // 占用只增不减，跳转一直有效；沿跳转链前进时做路径压缩，不同起点的搜索共享已跳过的阻挡元件
+    std::unordered_map<uint64_t, std::unordered_map<int, int>> skips;
+    std::vector<int> skipPath;
+    // 从 x 出发沿跳转链前进，再检查一个位置：空闲时 free 为 true 并返回该位置；
+    // 被挡住时登记跳转并返回越过阻挡元件后的下一个候选（由调用方按新位移重新排序，不在行内一直搜到底）
+    auto advance = [&](int i, int x, int y, int dir, bool& free) -> int {
+        const int sz = std::max(1, elements[i].size);
+        const uint64_t rowKey = ((uint64_t)(uint32_t)y << 32) | ((uint64_t)(uint32_t)sz << 1) | (dir > 0 ? 1u : 0u);
+        // 多数搜索在第一个位置就成功，此时不建跳转表
+        auto rowIt = skips.find(rowKey);
+        std::unordered_map<int, int>* jump = rowIt != skips.end() ? &rowIt->second : nullptr;
+        skipPath.clear();
+        if (jump) {
+            for (auto it = jump->find(x); it != jump->end(); it = jump->find(x)) {
+                skipPath.push_back(x);
+                x = it->second;
+            }
+        }
+        BodyRect blocker{};
+        BodyRect body = ElementBodyAt(elements[i], x, y);
+        free = !firstBlocker(body, &blocker);
+        if (!free) {
+            int nx = dir > 0 ? blocker.x1 + opts.spacing : blocker.x0 - opts.spacing - (body.x1 - body.x0);
+            // 对齐网格（向搜索方向取整，保证越过阻挡元件）
+            nx = dir > 0 ? ((nx % kGrid == 0) ? nx : nx + (kGrid - ((nx % kGrid) + kGrid) % kGrid))
+                : nx - ((nx % kGrid) + kGrid) % kGrid;
+            if (!jump) jump = &skips[rowKey];
+            skipPath.push_back(x);
+            x = nx;
+        }
+        for (int p : skipPath) (*jump)[p] = x;
+        return x;
+        };
+    std::unordered_map<int, RowSearch> searches;  // 按元件尺寸区分的搜索状态，只在同一点 (x0, y0) 的元件之间沿用
+    size_t group = 0;
+    int groupX = 0, groupY = 0;
+    for (int i : pending) {
+        const int x0 = px[i], y0 = py[i];
+        // pending 按 (y, x) 有序，同一点的元件相邻
+        if (group == 0 || x0 != groupX || y0 != groupY) {
+            ++group;
+            groupX = x0; groupY = y0;
+        }
+        RowSearch& rs = searches[std::max(1, elements[i].size)];
+        if (rs.group != group) {
+            rs.heap.clear();
+            rs.nextK = 0;
+            rs.group = group;
+        }
+        for (;;) {
+            const int64_t nextRow = std::abs(rowOffset(rs.nextK));
+            if (rs.heap.empty() || nextRow < rs.heap.front().d) {
+                for (int dir : { 1, -1 }) {
+                    rs.heap.push_back(RowProbe{ nextRow, rs.nextK, dir, x0 });
+                    std::push_heap(rs.heap.begin(), rs.heap.end(), probeAfter);
+                }
+                ++rs.nextK;
+                continue;
+            }
+            std::pop_heap(rs.heap.begin(), rs.heap.end(), probeAfter);
+            RowProbe& pr = rs.heap.back();
+            const int dy = rowOffset(pr.k);
+            const int y = y0 + dy;
+            bool free = false;
+            const int x = advance(i, pr.x, y, pr.dir, free);
+            if (free && x == pr.x) {
+                px[i] = x; py[i] = y;
+                place(i);
+                // 探针留在原处（现已被本元件挡住），供同一点上的下一个元件继续
+                std::push_heap(rs.heap.begin(), rs.heap.end(), probeAfter);
+                break;
+            }
+            pr.x = x;
+            pr.d = (int64_t)std::abs(x - x0) + std::abs(dy);
+            std::push_heap(rs.heap.begin(), rs.heap.end(), probeAfter);
+        }
+    }
+
+    for (int i : order) {
+        ElementInfo& e = elements[i];
+        if (e.x == px[i] && e.y == py[i]) continue;
+        double d = (double)std::abs(e.x - px[i]) + std::abs(e.y - py[i]);
+        result.totalDisplacement += d;
+        result.maxDisplacement = std::max(result.maxDisplacement, d);
+        e.x = px[i]; e.y = py[i]; e.Touch();
+        ++result.moved;
+    }
+    return result;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "CircuitModel.h"
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <cstddef>
+
+// ---- 自动布局 ----
+// 线网按 BuildConnectionNets 划分，未接元件的自由端点视为固定引脚。线长以端点坐标的半周长（HPWL）计
+
+struct PlacementOptions {
+    int spacing = 20;                // 元件四周预留的布线间距（像素）
+    double targetDensity = 0.5;      // 布局区域内元件（含间距）面积占比
+    int maxIterations = 40;          // 外层迭代：B2B 重新加权求解 + 扩散
+    int cgIterations = 150;          // 每次共轭梯度求解的最大迭代次数
+    double cgTolerance = 1e-4;       // 相对残差
+    double anchorStep = 0.001;       // 每轮扩散锚点权重的增量（相对线网平均权重），越小越慢、线长越短
+    double minImprovement = 0.005;   // 扩散后的线长 5 轮内改善低于此比例即停止
+    unsigned threads = 0;            // 0 表示硬件线程数
+};
+
+struct PlacementResult {
+    int iterations = 0;
+    size_t moved = 0;           // 坐标有变化的元件数
+    double hpwlBefore = 0.0;
+    double hpwlAfter = 0.0;
+};
+
+// 全部连接的半周长线长之和
+double PlacementHPWL(const std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections);
+
+// 全局布局：二次线长（Bound2Bound 线网模型）用 Jacobi 预条件共轭梯度求解，
+// 每轮按面积递归二分把元件摊开到布局区域，并以逐轮加重的锚点拉向摊开位置，直至重叠基本消除。
+// 结果对齐 10 像素网格写回 elements[i].x/y 并 Touch；fixed[i] 非 0 的元件不移动（fixed 可为空）。
+// 不修改连接走线，调用方应随后重新布线
+PlacementResult GlobalPlace(std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const std::vector<char>& fixed, const PlacementOptions& opts = PlacementOptions());
+
+struct AnnealOptions {
+    int spacing = 20;                // 元件之间的最小间隙（像素），移动后不得小于此值
+    int movesPerElement = 300;       // 总尝试次数 = 可移动元件数 * movesPerElement
+    int stages = 60;                 // 降温阶段数，每阶段结束报告一次进度
+    double initialAcceptance = 0.2;  // 首阶段上坡移动的目标接受率（据此推算初始温度）
+    double finalTemperature = 1e-3;  // 末阶段温度相对初始温度的比例
+    int maxShiftCells = 20;          // 平移/交换窗口的初始半径（网格数），按接受率自适应收缩
+    unsigned seed = 1;               // 随机数种子（同一输入与种子结果相同）
+};
+
+struct AnnealResult {
+    double hpwlBefore = 0.0;
+    double hpwlAfter = 0.0;
+    size_t attempted = 0;
+    size_t accepted = 0;
+    size_t moved = 0;           // 坐标有变化的元件数
+    bool cancelled = false;
+};
+
+// 进度回调：fraction 为 0~1 的完成比例，hpwl 为当前线长；在调用 AnnealPlacement 的线程中调用
+using PlacementProgress = std::function<void(double fraction, double hpwl)>;
+
+// 详细布局：模拟退火，随机平移元件或与窗口内的元件交换位置，坐标始终在 10 像素网格上
+// （未对齐的输入先吸附到附近不冲突的网格点）。
+// 每次移动只按受影响线网的包围盒（边界引脚计数）增量更新线长，不做全局重算；
+// 合法性由按桶划分的空间索引检查，已合法（互不重叠）的输入始终保持合法。
+// cancel 非空时可被其它线程取消，取消时不写回 elements；否则写回并 Touch 变化的元件
+AnnealResult AnnealPlacement(std::vector<ElementInfo>& elements, const std::vector<ConnectionInfo>& connections,
+    const std::vector<char>& fixed, const AnnealOptions& opts = AnnealOptions(),
+    const std::atomic<bool>* cancel = nullptr, const PlacementProgress& progress = PlacementProgress());
+
+struct LegalizeOptions {
+    int spacing = 20;           // 元件之间的最小间隙（像素）
+};
+
+struct LegalizeResult {
+    size_t moved = 0;           // 坐标有变化的元件数（含仅对齐网格的）
+    double totalDisplacement = 0.0;  // 曼哈顿位移之和（像素）
+    double maxDisplacement = 0.0;
+};
+
+// 合法化：把元件移到最近的、对齐 10 像素网格且与其它元件间隙不小于 spacing 的位置。
+// 先按 (y, x) 顺序保留互不冲突的元件，其余元件按位移由小到大逐行向两侧跳过阻挡元件搜索最近空位，
+// 总能找到空位；叠在同一点的元件沿用前一个元件的搜索进度。
+// 冲突检测用按桶划分的空间索引，代价与元件数近似线性。fixed[i] 非 0 的元件不移动（fixed 可为空）
+LegalizeResult LegalizePlacement(std::vector<ElementInfo>& elements, const std::vector<char>& fixed,
+    const LegalizeOptions& opts = LegalizeOptions());
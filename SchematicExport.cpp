@@ -0,0 +1,673 @@
+#include "SchematicExport.h"
+#include "ElementDraw.h"
+#include "ParallelFor.h"
+#include <zlib.h>
+#include <fstream>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <new>
+
+// 与画布静态层保持一致的尺寸与配色
+namespace {
+
+struct Rgb { uint8_t r, g, b; };
+
+const Rgb kWhite{ 255, 255, 255 };
+const Rgb kBlack{ 0, 0, 0 };
+const Rgb kWireConnected{ 0, 128, 0 };   // 输出→输入的连线、已连接端点
+const Rgb kPinFree{ 30, 144, 255 };      // 未连接端点
+const int kWireWidth = 2;
+const int kAuxRadius = 3;
+const int kPinRadius = 4;
+
+// 元件颜色：支持 #RRGGBB 与常用颜色名（与 wxColour 的名字一致），未知名字按黑色处理
+Rgb ParseColour(const std::string& name)
+{
+    if (name.size() == 7 && name[0] == '#') {
+        unsigned v = 0;
+        if (std::sscanf(name.c_str() + 1, "%6x", &v) == 1) return Rgb{ uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v) };
+    }
+    std::string n;
+    for (char ch : name) if (ch != ' ') n.push_back((char)std::tolower((unsigned char)ch));
+    static const struct { const char* name; Rgb rgb; } table[] = {
+        { "black", { 0, 0, 0 } },       { "white", { 255, 255, 255 } }, { "red", { 255, 0, 0 } },
+        { "green", { 0, 255, 0 } },     { "blue", { 0, 0, 255 } },      { "yellow", { 255, 255, 0 } },
+        { "cyan", { 0, 255, 255 } },    { "magenta", { 255, 0, 255 } }, { "grey", { 128, 128, 128 } },
+        { "gray", { 128, 128, 128 } },  { "lightgrey", { 211, 211, 211 } }, { "lightgray", { 211, 211, 211 } },
+        { "darkgrey", { 47, 47, 47 } }, { "darkgray", { 47, 47, 47 } }, { "orange", { 204, 50, 50 } },
+        { "purple", { 176, 0, 255 } },  { "brown", { 165, 42, 42 } },   { "navy", { 35, 35, 142 } },
+        { "pink", { 255, 192, 203 } },
+    };
+    for (const auto& t : table) if (n == t.name) return t.rgb;
+    return kBlack;
+}
+
+std::string HexColour(const Rgb& c)
+{
+    char buf[8];
+    std::snprintf(buf, sizeof(buf), "#%02x%02x%02x", c.r, c.g, c.b);
+    return buf;
+}
+
+// 内置 5x7 点阵字体（小写按大写绘制），用于元件名称；无需字体库与显示环境
+const uint8_t* Glyph(char ch)
+{
+    static const uint8_t letters[26][7] = {
+        { 0x0E,0x11,0x11,0x1F,0x11,0x11,0x11 }, { 0x1E,0x11,0x11,0x1E,0x11,0x11,0x1E }, // A B
+        { 0x0E,0x11,0x10,0x10,0x10,0x11,0x0E }, { 0x1E,0x11,0x11,0x11,0x11,0x11,0x1E }, // C D
+        { 0x1F,0x10,0x10,0x1E,0x10,0x10,0x1F }, { 0x1F,0x10,0x10,0x1E,0x10,0x10,0x10 }, // E F
+        { 0x0E,0x11,0x10,0x17,0x11,0x11,0x0F }, { 0x11,0x11,0x11,0x1F,0x11,0x11,0x11 }, // G H
+        { 0x0E,0x04,0x04,0x04,0x04,0x04,0x0E }, { 0x07,0x02,0x02,0x02,0x02,0x12,0x0C }, // I J
+        { 0x11,0x12,0x14,0x18,0x14,0x12,0x11 }, { 0x10,0x10,0x10,0x10,0x10,0x10,0x1F }, // K L
+        { 0x11,0x1B,0x15,0x15,0x11,0x11,0x11 }, { 0x11,0x11,0x19,0x15,0x13,0x11,0x11 }, // M N
+        { 0x0E,0x11,0x11,0x11,0x11,0x11,0x0E }, { 0x1E,0x11,0x11,0x1E,0x10,0x10,0x10 }, // O P
+        { 0x0E,0x11,0x11,0x11,0x15,0x12,0x0D }, { 0x1E,0x11,0x11,0x1E,0x14,0x12,0x11 }, // Q R
+        { 0x0F,0x10,0x10,0x0E,0x01,0x01,0x1E }, { 0x1F,0x04,0x04,0x04,0x04,0x04,0x04 }, // S T
+        { 0x11,0x11,0x11,0x11,0x11,0x11,0x0E }, { 0x11,0x11,0x11,0x11,0x11,0x0A,0x04 }, // U V
+        { 0x11,0x11,0x11,0x15,0x15,0x15,0x0A }, { 0x11,0x11,0x0A,0x04,0x0A,0x11,0x11 }, // W X
+        { 0x11,0x11,0x11,0x0A,0x04,0x04,0x04 }, { 0x1F,0x01,0x02,0x04,0x08,0x10,0x1F }, // Y Z
+    };
+    static const uint8_t digits[10][7] = {
+        { 0x0E,0x11,0x13,0x15,0x19,0x11,0x0E }, { 0x04,0x0C,0x04,0x04,0x04,0x04,0x0E },
+        { 0x0E,0x11,0x01,0x02,0x04,0x08,0x1F }, { 0x1F,0x02,0x04,0x02,0x01,0x11,0x0E },
+        { 0x02,0x06,0x0A,0x12,0x1F,0x02,0x02 }, { 0x1F,0x10,0x1E,0x01,0x01,0x11,0x0E },
+        { 0x06,0x08,0x10,0x1E,0x11,0x11,0x0E }, { 0x1F,0x01,0x02,0x04,0x08,0x08,0x08 },
+        { 0x0E,0x11,0x11,0x0E,0x11,0x11,0x0E }, { 0x0E,0x11,0x11,0x0F,0x01,0x02,0x0C },
+    };
+    static const uint8_t space[7] = { 0 };
+    static const uint8_t dash[7] = { 0, 0, 0, 0x1F, 0, 0, 0 };
+    static const uint8_t dot[7] = { 0, 0, 0, 0, 0, 0x0C, 0x0C };
+    static const uint8_t under[7] = { 0, 0, 0, 0, 0, 0, 0x1F };
+    static const uint8_t lparen[7] = { 0x02,0x04,0x08,0x08,0x08,0x04,0x02 };
+    static const uint8_t rparen[7] = { 0x08,0x04,0x02,0x02,0x02,0x04,0x08 };
+    static const uint8_t slash[7] = { 0x01,0x01,0x02,0x04,0x08,0x10,0x10 };
+    static const uint8_t unknown[7] = { 0x0E,0x11,0x01,0x02,0x04,0x00,0x04 };
+    if (ch >= 'a' && ch <= 'z') ch = (char)(ch - 'a' + 'A');
+    if (ch >= 'A' && ch <= 'Z') return letters[ch - 'A'];
+    if (ch >= '0' && ch <= '9') return digits[ch - '0'];
+    switch (ch) {
+    case ' ': return space;
+    case '-': return dash;
+    case '.': return dot;
+    case '_': return under;
+    case '(': return lparen;
+    case ')': return rparen;
+    case '/': return slash;
+    default: return unknown;
+    }
+}
+
+// 导出场景：世界坐标包围盒、端点占用与坐标变换（设备 = 世界 * scale + off）
+struct ExportScene {
+    const std::vector<ElementInfo>& elements;
+    const std::vector<ConnectionInfo>& connections;
+    PinOccupancyIndex pins;
+    double scale = 1.0;
+    double offX = 0.0, offY = 0.0;
+    int minX = 0, minY = 0, maxX = 1, maxY = 1;   // 世界坐标包围盒
+    long long width = 1, height = 1;               // 图片尺寸（像素）
+
+    ExportScene(const std::vector<ElementInfo>& e, const std::vector<ConnectionInfo>& c) : elements(e), connections(c) {}
+
+    double DevX(double x) const { return x * scale + offX; }
+    double DevY(double y) const { return y * scale + offY; }
+};
+
+int ElemW(const ElementInfo& e) { return BaseElemWidth * std::max(1, e.size); }
+int ElemH(const ElementInfo& e) { return BaseElemHeight * std::max(1, e.size); }
+int PinCount(int n) { return n > 0 ? n : 1; }
+
+// 预热几何缓存（单线程）、建立端点索引、计算包围盒与图片尺寸；之后的并行渲染只读
+bool PrepareScene(ExportScene& s, const ExportOptions& opts)
+{
+    s.scale = opts.scale > 0.0 ? opts.scale : 1.0;
+    s.pins.Rebuild(s.elements.size(), s.connections);
+    for (size_t ci = 0; ci < s.connections.size(); ++ci) EnsureConnectionGeometry(s.elements, s.connections, ci);
+
+    bool any = false;
+    auto grow = [&](int x0, int y0, int x1, int y1) {
+        if (!any) { s.minX = x0; s.minY = y0; s.maxX = x1; s.maxY = y1; any = true; return; }
+        s.minX = std::min(s.minX, x0); s.minY = std::min(s.minY, y0);
+        s.maxX = std::max(s.maxX, x1); s.maxY = std::max(s.maxY, y1);
+    };
+    for (const auto& e : s.elements) {
+        int pad = std::max(kPinRadius, e.thickness) + 1;
+        // 名称比元件宽时会向两侧伸出（点阵字宽 6 点/字，点大小为字号的 1/8）
+        int textW = (int)((6 * e.type.size()) * std::max(8, 12 * std::max(1, e.size)) / 8);
+        int over = std::max(0, (textW - ElemW(e)) / 2) + 1;
+        grow(e.x - std::max(pad, over), e.y - pad, e.x + ElemW(e) + std::max(pad, over), e.y + ElemH(e) + pad);
+    }
+    for (const auto& c : s.connections) {
+        for (const auto& p : c.geom.poly) grow(p.x - kAuxRadius, p.y - kAuxRadius, p.x + kAuxRadius, p.y + kAuxRadius);
+    }
+
+    int margin = std::max(0, opts.margin);
+    double w = std::ceil((s.maxX - s.minX) * s.scale) + 2.0 * margin;
+    double h = std::ceil((s.maxY - s.minY) * s.scale) + 2.0 * margin;
+    if (w < 1.0 || h < 1.0 || w > INT_MAX || h > INT_MAX) return false;
+    s.width = (long long)w;
+    s.height = (long long)h;
+    s.offX = margin - s.minX * s.scale;
+    s.offY = margin - s.minY * s.scale;
+    return true;
+}
+
+// ---- 软件光栅化 ----
+
+// 一个分块的绘制目标：直接写入整行分块共享的缓冲区（各分块列范围互不重叠，可并行）
+class TileCanvas
+{
+public:
+    TileCanvas(uint8_t* base, size_t stride, int x0, int y0, int w, int h)
+        : m_base(base), m_stride(stride), m_x0(x0), m_y0(y0), m_w(w), m_h(h) {}
+
+    // 以像素中心判断覆盖：[x0, x1) × [y0, y1)
+    void FillRect(double x0, double y0, double x1, double y1, const Rgb& c)
+    {
+        int ix0 = std::max(m_x0, (int)std::ceil(x0 - 0.5));
+        int iy0 = std::max(m_y0, (int)std::ceil(y0 - 0.5));
+        int ix1 = std::min(m_x0 + m_w, (int)std::ceil(x1 - 0.5));
+        int iy1 = std::min(m_y0 + m_h, (int)std::ceil(y1 - 0.5));
+        for (int y = iy0; y < iy1; ++y)
+            for (int x = ix0; x < ix1; ++x) Put(x, y, c);
+    }
+
+    // 粗线：到线段距离不超过 width/2 的像素
+    void Line(double ax, double ay, double bx, double by, double width, const Rgb& c)
+    {
+        double r = std::max(0.5, width / 2.0);
+        int ix0, iy0, ix1, iy1;
+        if (!Clip(std::min(ax, bx) - r, std::min(ay, by) - r, std::max(ax, bx) + r, std::max(ay, by) + r, ix0, iy0, ix1, iy1)) return;
+        double dx = bx - ax, dy = by - ay;
+        double len2 = dx * dx + dy * dy;
+        double r2 = r * r;
+        for (int y = iy0; y < iy1; ++y) {
+            double py = y + 0.5;
+            for (int x = ix0; x < ix1; ++x) {
+                double px = x + 0.5;
+                double t = len2 > 0.0 ? ((px - ax) * dx + (py - ay) * dy) / len2 : 0.0;
+                t = std::max(0.0, std::min(1.0, t));
+                double qx = ax + t * dx - px, qy = ay + t * dy - py;
+                if (qx * qx + qy * qy <= r2) Put(x, y, c);
+            }
+        }
+    }
+
+    // 圆：inner < 0 为实心，否则绘制 [inner, outer] 的圆环
+    void Disc(double cx, double cy, double outer, double inner, const Rgb& c)
+    {
+        int ix0, iy0, ix1, iy1;
+        if (!Clip(cx - outer, cy - outer, cx + outer, cy + outer, ix0, iy0, ix1, iy1)) return;
+        double o2 = outer * outer, i2 = inner < 0.0 ? -1.0 : inner * inner;
+        for (int y = iy0; y < iy1; ++y) {
+            double dy = y + 0.5 - cy;
+            for (int x = ix0; x < ix1; ++x) {
+                double dx = x + 0.5 - cx;
+                double d2 = dx * dx + dy * dy;
+                if (d2 <= o2 && d2 >= i2) Put(x, y, c);
+            }
+        }
+    }
+
+    void FillTriangle(const double (&xs)[3], const double (&ys)[3], const Rgb& c)
+    {
+        int ix0, iy0, ix1, iy1;
+        if (!Clip(std::min({ xs[0], xs[1], xs[2] }), std::min({ ys[0], ys[1], ys[2] }),
+            std::max({ xs[0], xs[1], xs[2] }), std::max({ ys[0], ys[1], ys[2] }), ix0, iy0, ix1, iy1)) return;
+        auto edge = [&](int i, int j, double px, double py) {
+            return (xs[j] - xs[i]) * (py - ys[i]) - (ys[j] - ys[i]) * (px - xs[i]);
+        };
+        for (int y = iy0; y < iy1; ++y) {
+            for (int x = ix0; x < ix1; ++x) {
+                double px = x + 0.5, py = y + 0.5;
+                double e0 = edge(0, 1, px, py), e1 = edge(1, 2, px, py), e2 = edge(2, 0, px, py);
+                if ((e0 >= 0 && e1 >= 0 && e2 >= 0) || (e0 <= 0 && e1 <= 0 && e2 <= 0)) Put(x, y, c);
+            }
+        }
+    }
+
+    // 点阵文字：每个字形点绘制为 k×k 的方块，字符间距 1 点
+    void Text(const std::string& s, double x, double y, double k, const Rgb& c)
+    {
+        if (!Overlaps(x, y, x + TextWidth(s, k), y + 7 * k)) return;
+        for (char ch : s) {
+            const uint8_t* g = Glyph(ch);
+            for (int row = 0; row < 7; ++row)
+                for (int col = 0; col < 5; ++col)
+                    if (g[row] & (0x10 >> col)) FillRect(x + col * k, y + row * k, x + (col + 1) * k, y + (row + 1) * k, c);
+            x += 6 * k;
+        }
+    }
+
+    static double TextWidth(const std::string& s, double k) { return s.empty() ? 0.0 : (6.0 * s.size() - 1.0) * k; }
+
+private:
+    uint8_t* m_base;
+    size_t m_stride;
+    int m_x0, m_y0, m_w, m_h;
+
+    void Put(int x, int y, const Rgb& c)
+    {
+        uint8_t* p = m_base + (size_t)(y - m_y0) * m_stride + (size_t)x * 4;
+        p[0] = c.r; p[1] = c.g; p[2] = c.b; p[3] = 255;
+    }
+
+    bool Overlaps(double x0, double y0, double x1, double y1) const
+    {
+        return x1 >= m_x0 && y1 >= m_y0 && x0 <= m_x0 + m_w && y0 <= m_y0 + m_h;
+    }
+
+    bool Clip(double x0, double y0, double x1, double y1, int& ix0, int& iy0, int& ix1, int& iy1) const
+    {
+        if (!Overlaps(x0, y0, x1, y1)) return false;
+        ix0 = std::max(m_x0, (int)std::floor(x0));
+        iy0 = std::max(m_y0, (int)std::floor(y0));
+        ix1 = std::min(m_x0 + m_w, (int)std::ceil(x1) + 1);
+        iy1 = std::min(m_y0 + m_h, (int)std::ceil(y1) + 1);
+        return ix0 < ix1 && iy0 < iy1;
+    }
+};
+
+bool IsOutputToInput(const ConnectionInfo& c) { return ((c.aIndex >= 0) || (c.aConn >= 0)) && (c.bIndex >= 0); }
+
+void RasterWire(TileCanvas& t, const ExportScene& s, const ConnectionInfo& c)
+{
+    const Rgb col = IsOutputToInput(c) ? kWireConnected : kBlack;
+    const std::vector<wxPoint>& poly = c.geom.poly;
+    double w = std::max(1.0, kWireWidth * s.scale);
+    for (size_t i = 1; i < poly.size(); ++i)
+        t.Line(s.DevX(poly[i - 1].x), s.DevY(poly[i - 1].y), s.DevX(poly[i].x), s.DevY(poly[i].y), w, col);
+    for (const auto& p : c.geom.auxPixels) t.Disc(s.DevX(p.x), s.DevY(p.y), kAuxRadius * s.scale, -1.0, col);
+}
+
+// 白底圆 + 描边（对应 DrawCircle 在白色画刷下的效果）
+void RasterOpenCircle(TileCanvas& t, double cx, double cy, double r, double pen, const Rgb& c)
+{
+    t.Disc(cx, cy, r, -1.0, kWhite);
+    t.Disc(cx, cy, r + pen / 2.0, std::max(0.0, r - pen / 2.0), c);
+}
+
+// 与 DrawElement 的图形一致
+void RasterElement(TileCanvas& t, const ExportScene& s, const ElementInfo& e)
+{
+    const int size = std::max(1, e.size);
+    const Rgb col = ParseColour(e.color);
+    const double sc = s.scale;
+    const double pen = std::max(1.0, std::max(1, e.thickness) * sc);
+    const double x = s.DevX(e.x), y = s.DevY(e.y);
+    const double w = ElemW(e) * sc, h = ElemH(e) * sc;
+    const double inset = std::max(2, (int)std::round(4.0 * size)) * sc;
+    const double triW = std::max(5, (int)std::round(8.0 * size)) * sc;
+
+    t.FillRect(x, y, x + w, y + h, kWhite);
+    t.Line(x, y, x + w, y, pen, col);
+    t.Line(x + w, y, x + w, y + h, pen, col);
+    t.Line(x + w, y + h, x, y + h, pen, col);
+    t.Line(x, y + h, x, y, pen, col);
+
+    const bool triangle = e.type == "Buffer" || e.type == "Controlled Buffer" || e.type == "Controlled Inverter";
+    if (triangle) {
+        const double xs[3] = { x + w - triW, x + w - triW, x + w };
+        const double ys[3] = { y + inset, y + h - inset, y + inset + (h - 2 * inset) / 2 };
+        t.FillTriangle(xs, ys, kWhite);
+        for (int i = 0; i < 3; ++i) t.Line(xs[i], ys[i], xs[(i + 1) % 3], ys[(i + 1) % 3], pen, col);
+    }
+    if (e.type == "Odd Parity") {
+        double half = std::max(5, (int)std::round(8.0 * size)) / 2 * sc;
+        double cx = x + w / 2, cy = y + h / 2;
+        t.Line(cx - half, cy - half, cx + half, cy + half, pen, col);
+        t.Line(cx - half, cy + half, cx + half, cy - half, pen, col);
+    }
+    if (e.type == "Controlled Buffer" || e.type == "Controlled Inverter") {
+        RasterOpenCircle(t, x + inset * 2, y + inset * 2, std::max(2, (int)std::round(3.0 * size)) * sc, pen, col);
+    }
+    if (e.type == "Controlled Inverter") {
+        RasterOpenCircle(t, x + w - triW / 2, y + h / 2, std::max(1, (int)std::round(2.0 * size)) * sc, pen, col);
+    }
+
+    // 名称：字号与 DrawElement 相同，点阵高 7 点约合字号的 7/8
+    double k = std::max(8, 12 * size) * sc / 8.0;
+    if (k >= 0.5) {
+        if (k >= 1.0) k = std::round(k);   // 整数倍放大，笔画粗细一致
+        double tw = TileCanvas::TextWidth(e.type, k);
+        t.Text(e.type, std::round(x + (w - tw) / 2), std::round(y + (h - 7 * k) / 2), k, kBlack);
+    }
+}
+
+void RasterPins(TileCanvas& t, const ExportScene& s, int i)
+{
+    const ElementInfo& e = s.elements[i];
+    const double r = kPinRadius * s.scale;
+    if (e.type != "Output") {
+        for (int op = 0; op < PinCount(e.outputs); ++op) {
+            wxPoint p = ElementOutputPoint(e, op);
+            t.Disc(s.DevX(p.x), s.DevY(p.y), r, -1.0, s.pins.IsOutputUsed(i, op) ? kWireConnected : kPinFree);
+        }
+    }
+    if (e.type != "Input") {
+        for (int pin = 0; pin < PinCount(e.inputs); ++pin) {
+            wxPoint p = ElementInputPoint(e, pin);
+            t.Disc(s.DevX(p.x), s.DevY(p.y), r, -1.0, s.pins.IsInputUsed(i, pin) ? kWireConnected : kPinFree);
+        }
+    }
+}
+
+// 分块内的绘制项，按静态层顺序（连线 → 元件 → 端点）加入，分块内保持相同的叠放次序
+struct DrawItem {
+    enum Kind : uint8_t { Wire, Element, Pins } kind;
+    uint32_t index;
+};
+
+// ---- PNG 流式写出 ----
+class PngStreamWriter
+{
+public:
+    ~PngStreamWriter() { if (m_zInit) deflateEnd(&m_z); }
+
+    bool Open(const std::string& path, uint32_t width, uint32_t height)
+    {
+        m_out.open(path, std::ios::binary);
+        if (!m_out.is_open()) return false;
+        static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        m_out.write((const char*)sig, 8);
+        uint8_t ihdr[13];
+        PutBE32(ihdr, width);
+        PutBE32(ihdr + 4, height);
+        ihdr[8] = 8;    // 位深
+        ihdr[9] = 6;    // RGBA
+        ihdr[10] = 0; ihdr[11] = 0; ihdr[12] = 0;
+        WriteChunk("IHDR", ihdr, sizeof(ihdr));
+
+        std::memset(&m_z, 0, sizeof(m_z));
+        if (deflateInit(&m_z, Z_DEFAULT_COMPRESSION) != Z_OK) return false;
+        m_zInit = true;
+        m_idat.resize(64 * 1024);
+        m_z.next_out = m_idat.data();
+        m_z.avail_out = (uInt)m_idat.size();
+        return m_out.good();
+    }
+
+    // 写入一行 RGBA（width * 4 字节）。原理图多为整列重复的像素，用 Up 过滤（与上一行相减）后
+    // 大部分字节为 0，压缩快且体积小
+    bool WriteRow(const uint8_t* rgba, size_t bytes)
+    {
+        static const uint8_t filterUp = 2;
+        m_filtered.resize(bytes);
+        if (m_prev.size() != bytes) m_prev.assign(bytes, 0);
+        for (size_t i = 0; i < bytes; ++i) m_filtered[i] = uint8_t(rgba[i] - m_prev[i]);
+        std::memcpy(m_prev.data(), rgba, bytes);
+        return Deflate(&filterUp, 1, Z_NO_FLUSH) && Deflate(m_filtered.data(), bytes, Z_NO_FLUSH);
+    }
+
+    bool Finish()
+    {
+        if (!Deflate(nullptr, 0, Z_FINISH)) return false;
+        if (m_z.avail_out < m_idat.size()) WriteChunk("IDAT", m_idat.data(), m_idat.size() - m_z.avail_out);
+        WriteChunk("IEND", nullptr, 0);
+        m_out.close();
+        return !m_out.fail();
+    }
+
+private:
+    std::ofstream m_out;
+    z_stream m_z;
+    bool m_zInit = false;
+    std::vector<uint8_t> m_idat;
+    std::vector<uint8_t> m_prev, m_filtered;
+
+    static void PutBE32(uint8_t* p, uint32_t v) { p[0] = uint8_t(v >> 24); p[1] = uint8_t(v >> 16); p[2] = uint8_t(v >> 8); p[3] = uint8_t(v); }
+
+    void WriteChunk(const char* type, const uint8_t* data, size_t len)
+    {
+        uint8_t hdr[8];
+        PutBE32(hdr, (uint32_t)len);
+        std::memcpy(hdr + 4, type, 4);
+        m_out.write((const char*)hdr, 8);
+        if (len) m_out.write((const char*)data, (std::streamsize)len);
+        uLong crc = crc32(0L, (const Bytef*)type, 4);
+        if (len) crc = crc32(crc, data, (uInt)len);
+        uint8_t tail[4];
+        PutBE32(tail, (uint32_t)crc);
+        m_out.write((const char*)tail, 4);
+    }
+
+    // 压缩输入，输出缓冲写满即作为一个 IDAT 块落盘
+    bool Deflate(const uint8_t* data, size_t len, int flush)
+    {
+        m_z.next_in = const_cast<Bytef*>(data);
+        m_z.avail_in = (uInt)len;
+        for (;;) {
+            int ret = deflate(&m_z, flush);
+            if (ret == Z_STREAM_ERROR) return false;
+            if (m_z.avail_out == 0) {
+                WriteChunk("IDAT", m_idat.data(), m_idat.size());
+                m_z.next_out = m_idat.data();
+                m_z.avail_out = (uInt)m_idat.size();
+                continue;
+            }
+            if (flush == Z_FINISH ? ret == Z_STREAM_END : m_z.avail_in == 0) break;
+        }
+        return m_out.good();
+    }
+};
+
+// ---- SVG 流式写出 ----
+class SvgStreamWriter
+{
+public:
+    explicit SvgStreamWriter(const std::string& path) : m_out(path, std::ios::binary) { m_buf.reserve(FlushBytes + 4096); }
+    bool IsOpen() const { return m_out.is_open(); }
+
+    SvgStreamWriter& operator<<(const char* s) { m_buf.append(s); return MaybeFlush(); }
+    SvgStreamWriter& operator<<(const std::string& s) { m_buf.append(s); return MaybeFlush(); }
+    SvgStreamWriter& operator<<(int v) { m_buf.append(std::to_string(v)); return MaybeFlush(); }
+    SvgStreamWriter& operator<<(double v)
+    {
+        char b[32];
+        std::snprintf(b, sizeof(b), "%.6g", v);
+        m_buf.append(b);
+        return MaybeFlush();
+    }
+
+    // 文本内容需要转义
+    SvgStreamWriter& Escaped(const std::string& s)
+    {
+        for (char ch : s) {
+            switch (ch) {
+            case '&': m_buf.append("&amp;"); break;
+            case '<': m_buf.append("&lt;"); break;
+            case '>': m_buf.append("&gt;"); break;
+            case '"': m_buf.append("&quot;"); break;
+            default: m_buf.push_back(ch); break;
+            }
+        }
+        return MaybeFlush();
+    }
+
+    bool Close()
+    {
+        Flush();
+        m_out.close();
+        return !m_out.fail();
+    }
+
+private:
+    static constexpr size_t FlushBytes = 1 << 20;
+    std::ofstream m_out;
+    std::string m_buf;
+
+    void Flush()
+    {
+        if (!m_buf.empty()) m_out.write(m_buf.data(), (std::streamsize)m_buf.size());
+        m_buf.clear();
+    }
+    SvgStreamWriter& MaybeFlush()
+    {
+        if (m_buf.size() >= FlushBytes) Flush();
+        return *this;
+    }
+};
+
+void SvgOpenCircle(SvgStreamWriter& w, double cx, double cy, double r, const std::string& stroke, int pen)
+{
+    w << "<circle cx=\"" << cx << "\" cy=\"" << cy << "\" r=\"" << r << "\" fill=\"white\" stroke=\"" << stroke << "\" stroke-width=\"" << pen << "\"/>\n";
+}
+
+void SvgElement(SvgStreamWriter& w, const ElementInfo& e)
+{
+    const int size = std::max(1, e.size);
+    const std::string stroke = HexColour(ParseColour(e.color));
+    const int pen = std::max(1, e.thickness);
+    const int x = e.x, y = e.y, ew = ElemW(e), eh = ElemH(e);
+    const int inset = std::max(2, (int)std::round(4.0 * size));
+    const int triW = std::max(5, (int)std::round(8.0 * size));
+
+    w << "<g stroke=\"" << stroke << "\" stroke-width=\"" << pen << "\">";
+    w << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << ew << "\" height=\"" << eh << "\" fill=\"white\"/>";
+    if (e.type == "Buffer" || e.type == "Controlled Buffer" || e.type == "Controlled Inverter") {
+        w << "<polygon fill=\"white\" points=\"" << (x + ew - triW) << "," << (y + inset) << " "
+            << (x + ew - triW) << "," << (y + eh - inset) << " " << (x + ew) << "," << (y + inset + (eh - 2 * inset) / 2) << "\"/>";
+    }
+    if (e.type == "Odd Parity") {
+        int half = std::max(5, (int)std::round(8.0 * size)) / 2;
+        int cx = x + ew / 2, cy = y + eh / 2;
+        w << "<path fill=\"none\" d=\"M" << (cx - half) << " " << (cy - half) << "L" << (cx + half) << " " << (cy + half)
+            << "M" << (cx - half) << " " << (cy + half) << "L" << (cx + half) << " " << (cy - half) << "\"/>";
+    }
+    w << "</g>\n";
+    if (e.type == "Controlled Buffer" || e.type == "Controlled Inverter")
+        SvgOpenCircle(w, x + inset * 2, y + inset * 2, std::max(2, (int)std::round(3.0 * size)), stroke, pen);
+    if (e.type == "Controlled Inverter")
+        SvgOpenCircle(w, x + ew - triW / 2, y + eh / 2, std::max(1, (int)std::round(2.0 * size)), stroke, pen);
+
+    w << "<text x=\"" << (x + ew / 2) << "\" y=\"" << (y + eh / 2) << "\" font-size=\"" << std::max(8, 12 * size) << "\">";
+    w.Escaped(e.type) << "</text>\n";
+}
+
+} // namespace
+
+bool ExportSchematicPNG(const std::string& path, const std::vector<ElementInfo>& elements,
+    const std::vector<ConnectionInfo>& connections, const ExportOptions& opts)
+{
+    ExportScene scene(elements, connections);
+    if (!PrepareScene(scene, opts)) return false;
+    const int width = (int)scene.width, height = (int)scene.height;
+    const int tile = std::max(16, opts.tileSize);
+    const int tilesX = (width + tile - 1) / tile;
+    const int tilesY = (height + tile - 1) / tile;
+
+    try {
+        // 按设备坐标包围盒把绘制项分到覆盖的分块
+        std::vector<std::vector<DrawItem>> bins((size_t)tilesX * tilesY);
+        auto bin = [&](double x0, double y0, double x1, double y1, DrawItem item) {
+            int tx0 = std::max(0, (int)std::floor(x0) / tile), ty0 = std::max(0, (int)std::floor(y0) / tile);
+            int tx1 = std::min(tilesX - 1, (int)std::ceil(x1) / tile), ty1 = std::min(tilesY - 1, (int)std::ceil(y1) / tile);
+            for (int ty = ty0; ty <= ty1; ++ty)
+                for (int tx = tx0; tx <= tx1; ++tx) bins[(size_t)ty * tilesX + tx].push_back(item);
+        };
+        const double pad = std::max(kPinRadius, kWireWidth) * scene.scale + 2.0;
+        for (size_t ci = 0; ci < connections.size(); ++ci) {
+            const auto& poly = connections[ci].geom.poly;
+            if (poly.empty()) continue;
+            int x0 = poly[0].x, y0 = poly[0].y, x1 = x0, y1 = y0;
+            for (const auto& p : poly) { x0 = std::min(x0, p.x); y0 = std::min(y0, p.y); x1 = std::max(x1, p.x); y1 = std::max(y1, p.y); }
+            bin(scene.DevX(x0) - pad, scene.DevY(y0) - pad, scene.DevX(x1) + pad, scene.DevY(y1) + pad, DrawItem{ DrawItem::Wire, (uint32_t)ci });
+        }
+        for (int pass = 0; pass < 2; ++pass) {
+            for (size_t i = 0; i < elements.size(); ++i) {
+                const ElementInfo& e = elements[i];
+                // 名称可能超出元件框，元件项的包围盒按文字宽度放宽
+                double textW = TileCanvas::TextWidth(e.type, std::max(8, 12 * std::max(1, e.size)) * scene.scale / 8.0);
+                double extra = pass == 0 ? std::max(0.0, (textW - ElemW(e) * scene.scale) / 2) : 0.0;
+                double p = pad + std::max(1, e.thickness) * scene.scale;
+                bin(scene.DevX(e.x) - p - extra, scene.DevY(e.y) - p, scene.DevX(e.x + ElemW(e)) + p + extra, scene.DevY(e.y + ElemH(e)) + p,
+                    DrawItem{ pass == 0 ? DrawItem::Element : DrawItem::Pins, (uint32_t)i });
+            }
+        }
+
+        PngStreamWriter png;
+        if (!png.Open(path, (uint32_t)width, (uint32_t)height)) return false;
+
+        // 逐行分块：并行渲染一行分块到共享缓冲，再按像素行依次压缩写出
+        const size_t stride = (size_t)width * 4;
+        std::vector<uint8_t> band(stride * tile);
+        for (int ty = 0; ty < tilesY; ++ty) {
+            const int y0 = ty * tile;
+            const int bandH = std::min(tile, height - y0);
+            ParallelFor((size_t)tilesX, [&](size_t tx) {
+                const int x0 = (int)tx * tile;
+                const int w = std::min(tile, width - x0);
+                for (int row = 0; row < bandH; ++row) std::memset(band.data() + row * stride + (size_t)x0 * 4, 255, (size_t)w * 4);
+                TileCanvas canvas(band.data(), stride, x0, y0, w, bandH);
+                for (const DrawItem& it : bins[(size_t)ty * tilesX + tx]) {
+                    if (it.kind == DrawItem::Wire) RasterWire(canvas, scene, connections[it.index]);
+                    else if (it.kind == DrawItem::Element) RasterElement(canvas, scene, elements[it.index]);
+                    else RasterPins(canvas, scene, (int)it.index);
+                }
+            }, opts.threads);
+            // 已写出的分块不再需要，释放其绘制项
+            for (int tx = 0; tx < tilesX; ++tx) std::vector<DrawItem>().swap(bins[(size_t)ty * tilesX + tx]);
+            for (int row = 0; row < bandH; ++row) {
+                if (!png.WriteRow(band.data() + row * stride, stride)) return false;
+            }
+        }
+        return png.Finish();
+    }
+    catch (const std::bad_alloc&) {
+        return false;
+    }
+}
+
+bool ExportSchematicSVG(const std::string& path, const std::vector<ElementInfo>& elements,
+    const std::vector<ConnectionInfo>& connections, const ExportOptions& opts)
+{
+    ExportScene scene(elements, connections);
+    if (!PrepareScene(scene, opts)) return false;
+    SvgStreamWriter w(path);
+    if (!w.IsOpen()) return false;
+
+    // 图元使用世界坐标，由 viewBox 完成缩放与留白
+    const double m = std::max(0, opts.margin) / scene.scale;
+    const double vx = scene.minX - m, vy = scene.minY - m;
+    w << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << (double)scene.width << "\" height=\"" << (double)scene.height
+        << "\" viewBox=\"" << vx << " " << vy << " " << scene.width / scene.scale << " " << scene.height / scene.scale << "\">\n";
+    w << "<rect x=\"" << vx << "\" y=\"" << vy << "\" width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+
+    const std::string wireOn = HexColour(kWireConnected), wireOff = HexColour(kBlack), pinFree = HexColour(kPinFree);
+    w << "<g fill=\"none\" stroke-width=\"" << kWireWidth << "\">\n";
+    for (const auto& c : connections) {
+        const auto& poly = c.geom.poly;
+        if (poly.size() < 2) continue;
+        w << "<polyline stroke=\"" << (IsOutputToInput(c) ? wireOn : wireOff) << "\" points=\"";
+        for (size_t i = 0; i < poly.size(); ++i) w << (i ? " " : "") << poly[i].x << "," << poly[i].y;
+        w << "\"/>\n";
+    }
+    w << "</g>\n";
+    for (const auto& c : connections) {
+        const std::string& col = IsOutputToInput(c) ? wireOn : wireOff;
+        for (const auto& p : c.geom.auxPixels)
+            w << "<circle cx=\"" << p.x << "\" cy=\"" << p.y << "\" r=\"" << kAuxRadius << "\" fill=\"" << col << "\"/>\n";
+    }
+
+    w << "<g font-family=\"sans-serif\" font-weight=\"bold\" text-anchor=\"middle\" dominant-baseline=\"central\">\n";
+    for (const auto& e : elements) SvgElement(w, e);
+    w << "</g>\n";
+
+    for (size_t i = 0; i < elements.size(); ++i) {
+        const ElementInfo& e = elements[i];
+        auto pin = [&](const wxPoint& p, bool used) {
+            w << "<circle cx=\"" << p.x << "\" cy=\"" << p.y << "\" r=\"" << kPinRadius << "\" fill=\"" << (used ? wireOn : pinFree) << "\"/>\n";
+        };
+        if (e.type != "Output")
+            for (int op = 0; op < PinCount(e.outputs); ++op) pin(ElementOutputPoint(e, op), scene.pins.IsOutputUsed((int)i, op));
+        if (e.type != "Input")
+            for (int ip = 0; ip < PinCount(e.inputs); ++ip) pin(ElementInputPoint(e, ip), scene.pins.IsInputUsed((int)i, ip));
+    }
+    w << "</svg>\n";
+    return w.Close();
+}
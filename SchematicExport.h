@@ -0,0 +1,23 @@
+#pragma once
+#include "CircuitModel.h"
+#include <string>
+#include <vector>
+
+// ---- 无窗口导出 ----
+// 不依赖 wxDC / 显示环境，图形与 DrawElement / DrawConnection / 端点绘制一致，
+// 适合在无界面的 Linux 主机上批量生成超大设计的文档图片
+
+struct ExportOptions {
+    double scale = 1.0;     // 世界坐标到图片像素的缩放
+    int margin = 20;        // 四周留白（像素）
+    int tileSize = 256;     // PNG 分块边长（像素），每行分块并行渲染
+    unsigned threads = 0;   // 渲染线程数，0 表示硬件线程数
+};
+
+// 分块并行光栅化为 RGBA，再逐行压缩流式写出 PNG；内存占用只与一行分块相关
+bool ExportSchematicPNG(const std::string& path, const std::vector<ElementInfo>& elements,
+    const std::vector<ConnectionInfo>& connections, const ExportOptions& opts = ExportOptions());
+
+// 逐个图元写出 SVG，输出缓冲满即落盘，不在内存中保留整份文档
+bool ExportSchematicSVG(const std::string& path, const std::vector<ElementInfo>& elements,
+    const std::vector<ConnectionInfo>& connections, const ExportOptions& opts = ExportOptions());